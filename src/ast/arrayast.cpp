@@ -29,12 +29,7 @@ std::string ArrayDeclarationAST::asString() const {
 }
 
 void ArrayDeclarationAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newLength;
-	while (mLengthExpression->rewriteAST(newLength, compiler)) {
-		mLengthExpression = std::dynamic_pointer_cast<ExpressionAST>(newLength);
-	}
-
-	mLengthExpression->rewrite(compiler);
+	AST::rewriteTree(mLengthExpression, compiler);
 }
 
 void ArrayDeclarationAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
@@ -108,12 +103,7 @@ std::string MultiDimArrayDeclarationAST::asString() const {
 
 void MultiDimArrayDeclarationAST::rewrite(Compiler& compiler) {
 	for (auto& lengthExpr : mLengthExpressions) {
-		std::shared_ptr<AbstractSyntaxTree> newLength;
-		while (lengthExpr->rewriteAST(newLength, compiler)) {
-			lengthExpr = std::dynamic_pointer_cast<ExpressionAST>(newLength);
-		}
-
-		lengthExpr->rewrite(compiler);
+		AST::rewriteTree(lengthExpr, compiler);
 	}
 }
 
@@ -146,8 +136,8 @@ void MultiDimArrayDeclarationAST::typeCheck(TypeChecker& checker) {
 	checker.assertTypeExists(elementType(), false);
 	checker.assertNotVoid(*checker.findType(elementType()), "Arrays of type 'Void' is not allowed.");
 
-	//Create all array types
-	for (int i = 0; i < mLengthExpressions.size(); i++) {
+	//Create all array types, including the type of the created array
+	for (std::size_t i = 1; i <= mLengthExpressions.size(); i++) {
 		checker.makeType(typeString(i));
 	}
 }
@@ -156,72 +146,318 @@ std::shared_ptr<Type> MultiDimArrayDeclarationAST::expressionType(const TypeChec
 	return checker.findType(typeString());
 }
 
-void MultiDimArrayDeclarationAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
-	if (mLengthExpressions.size() > 2) {
-		codeGen.codeGenError("Array creation of dimension larger than 2 is not supported.");
-	}
-
+void MultiDimArrayDeclarationAST::generateArray(CodeGenerator& codeGen, GeneratedFunction& func, int dim,
+												const std::vector<int>& lengthLocals, const std::vector<int>& arrayLocals,
+												const std::vector<int>& indexLocals) {
 	auto& typeChecker = codeGen.typeChecker();
+	int rank = mLengthExpressions.size();
+	auto elementVMType = typeChecker.findType(typeString(rank - dim - 1))->vmType();
 
-	int outerLocal = func.newLocal("$local$_outer_" + std::to_string(func.numLocals()), typeChecker.findType(typeString()));
-	int subArrayLocal = func.newLocal("$local$_sub_" + std::to_string(func.numLocals()), typeChecker.findType("Int"));
+	func.addInstruction("LDLOC " + std::to_string(lengthLocals[dim]));
+	func.addInstruction("NEWARR " + elementVMType);
+	func.addInstruction("STLOC " + std::to_string(arrayLocals[dim]));
 
-	//Create the outer array
-	mLengthExpressions.at(0)->generateCode(codeGen, func);
-	func.addInstruction("NEWARR " + typeChecker.findType(typeString(mLengthExpressions.size() - 1))->vmType());
-	func.addInstruction("STLOC " + std::to_string(outerLocal));
+	if (dim == rank - 1) {
+		return;
+	}
+
+	//The index is reset for each array of the dimension
+	func.addInstruction("LDINT 0");
+	func.addInstruction("STLOC " + std::to_string(indexLocals[dim]));
 
 	int condStart = func.numInstructions();
 	int condIndex = -1;
 
 	//Condition
-	mLengthExpressions.at(0)->generateCode(codeGen, func);
-	func.addInstruction("LDLOC " + std::to_string(subArrayLocal));
+	func.addInstruction("LDLOC " + std::to_string(lengthLocals[dim]));
+	func.addInstruction("LDLOC " + std::to_string(indexLocals[dim]));
 	condIndex = func.numInstructions();
 	func.addInstruction("BLE");
 
-	//Body
-	func.addInstruction("LDLOC " + std::to_string(outerLocal));
-	func.addInstruction("LDLOC " + std::to_string(subArrayLocal));
-	mLengthExpressions.at(1)->generateCode(codeGen, func);
-	func.addInstruction("NEWARR " + typeChecker.findType(typeString(mLengthExpressions.size() - 2))->vmType());
+	//Body, where the arrays of the innermost dimension are created directly
+	if (dim + 1 < rank - 1) {
+		generateArray(codeGen, func, dim + 1, lengthLocals, arrayLocals, indexLocals);
+	}
 
-	func.addInstruction("STELEM " + typeChecker.findType(typeString(mLengthExpressions.size() - 1))->vmType());
+	func.addInstruction("LDLOC " + std::to_string(arrayLocals[dim]));
+	func.addInstruction("LDLOC " + std::to_string(indexLocals[dim]));
 
-	func.addInstruction("LDLOC " + std::to_string(subArrayLocal));
+	if (dim + 1 < rank - 1) {
+		func.addInstruction("LDLOC " + std::to_string(arrayLocals[dim + 1]));
+	} else {
+		func.addInstruction("LDLOC " + std::to_string(lengthLocals[dim + 1]));
+		func.addInstruction("NEWARR " + typeChecker.findType(typeString(rank - dim - 2))->vmType());
+	}
+
+	func.addInstruction("STELEM " + elementVMType);
+
+	func.addInstruction("LDLOC " + std::to_string(indexLocals[dim]));
 	func.addInstruction("LDINT 1");
 	func.addInstruction("ADD");
-	func.addInstruction("STLOC " + std::to_string(subArrayLocal));
+	func.addInstruction("STLOC " + std::to_string(indexLocals[dim]));
 
 	func.addInstruction("BR " + std::to_string(condStart));
 	func.instruction(condIndex) += " " + std::to_string(func.numInstructions());
+}
+
+void MultiDimArrayDeclarationAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+	auto& typeChecker = codeGen.typeChecker();
+	int rank = mLengthExpressions.size();
+
+	//Each length is evaluated once, before any array is created
+	std::vector<int> lengthLocals;
+	std::vector<int> arrayLocals;
+	std::vector<int> indexLocals;
+
+	for (int dim = 0; dim < rank; dim++) {
+		auto suffix = std::to_string(dim) + "_" + std::to_string(func.numLocals());
+		lengthLocals.push_back(func.newLocal("$local$_length" + suffix, typeChecker.findType("Int")));
+		//The arrays of the innermost dimension are not stored in a local
+		if (dim == 0 || dim < rank - 1) {
+			arrayLocals.push_back(func.newLocal("$local$_array" + suffix, typeChecker.findType(typeString(rank - dim))));
+		} else {
+			arrayLocals.push_back(-1);
+		}
+
+		if (dim < rank - 1) {
+			indexLocals.push_back(func.newLocal("$local$_index" + suffix, typeChecker.findType("Int")));
+		}
+
+		mLengthExpressions[dim]->generateCode(codeGen, func);
+		func.addInstruction("STLOC " + std::to_string(lengthLocals[dim]));
+	}
+
+	generateArray(codeGen, func, 0, lengthLocals, arrayLocals, indexLocals);
+	func.addInstruction("LDLOC " + std::to_string(arrayLocals[0]));
+}
+
+//Rectangular array declaration
+RectangularArrayDeclarationAST::RectangularArrayDeclarationAST(std::string elementType, int rank,
+															   std::vector<std::shared_ptr<ExpressionAST>> lengthExpressions)
+	: mElementType(TypeName::make(elementType)), mRank(rank), mLengthExpressions(lengthExpressions) {
+
+}
+
+std::string RectangularArrayDeclarationAST::typeString() const {
+	return elementType() + "[" + std::string(mRank - 1, ',') + "]";
+}
+
+std::string RectangularArrayDeclarationAST::elementType() const {
+	return mElementType->name();
+}
+
+const std::vector<std::shared_ptr<ExpressionAST>>& RectangularArrayDeclarationAST::lengthExpressions() const {
+	return mLengthExpressions;
+}
+
+std::string RectangularArrayDeclarationAST::asString() const {
+	auto lengthsStr = Helpers::join<std::shared_ptr<ExpressionAST>>(
+		mLengthExpressions,
+		[](std::shared_ptr<ExpressionAST> length) { return length->asString(); },
+		", ");
+
+	return "new " + typeString() + "(" + lengthsStr + ")";
+}
+
+void RectangularArrayDeclarationAST::rewrite(Compiler& compiler) {
+	for (auto& lengthExpr : mLengthExpressions) {
+		AST::rewriteTree(lengthExpr, compiler);
+	}
+}
+
+void RectangularArrayDeclarationAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
+	AbstractSyntaxTree::generateSymbols(binder, symbolTable);
+
+	for (auto lengthExpr : mLengthExpressions) {
+		lengthExpr->generateSymbols(binder, symbolTable);
+	}
+
+	mElementType = std::move(TypeName::makeFull(mElementType.get(), symbolTable));
+}
+
+void RectangularArrayDeclarationAST::typeCheck(TypeChecker& checker) {
+	for (auto lengthExpr : mLengthExpressions) {
+		lengthExpr->typeCheck(checker);
+	}
 
-	func.addInstruction("LDLOC " + std::to_string(outerLocal));
+	if ((int)mLengthExpressions.size() != mRank) {
+		checker.typeError(
+			"Expected " + std::to_string(mRank) + " lengths for the array of type '" + typeString()
+			+ "' but got " + std::to_string(mLengthExpressions.size()) + ".");
+	}
+
+	//Check lengths
+	int dim = 0;
+	for (auto lengthExpr : mLengthExpressions) {
+		checker.assertSameType(
+			*checker.makeType("Int"),
+			*lengthExpr->expressionType(checker),
+			"Expected the length of dimension " + std::to_string(dim) + " to be of type 'Int'.");
+		dim++;
+	}
+
+	//Check if the element type exists
+	checker.assertTypeExists(elementType(), false);
+	checker.assertNotVoid(*checker.findType(elementType()), "Arrays of type 'Void' is not allowed.");
+
+	//Create the array type if not created, which also generates the class of the array
+	checker.makeType(typeString());
+}
+
+std::shared_ptr<Type> RectangularArrayDeclarationAST::expressionType(const TypeChecker& checker) const {
+	return checker.findType(typeString());
+}
+
+void RectangularArrayDeclarationAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+	//The constructor of the generated class stores the lengths and allocates the elements
+	auto arrayType = std::dynamic_pointer_cast<RectangularArrayType>(expressionType(codeGen.typeChecker()));
+	std::vector<std::string> lengthTypes;
+
+	for (auto lengthExpr : mLengthExpressions) {
+		lengthExpr->generateCode(codeGen, func);
+		lengthTypes.push_back(codeGen.typeChecker().findType("Int")->vmType());
+	}
+
+	auto paramsStr = Helpers::join<std::string>(lengthTypes, [](std::string type) { return type; }, " ");
+	func.addInstruction("NEWOBJ " + arrayType->vmClassName() + "::.constructor(" + paramsStr + ")");
 }
 
 //Array access
 ArrayAccessAST::ArrayAccessAST(std::shared_ptr<ExpressionAST> arrayRefExpression, std::shared_ptr<ExpressionAST> accessExpression)
-	: mArrayRefExpression(arrayRefExpression), mAccessExpression(accessExpression) {
+	: mArrayRefExpression(arrayRefExpression), mAccessExpressions({ accessExpression }) {
 	
 }
 
+ArrayAccessAST::ArrayAccessAST(std::shared_ptr<ExpressionAST> arrayRefExpression,
+							   std::vector<std::shared_ptr<ExpressionAST>> accessExpressions)
+	: mArrayRefExpression(arrayRefExpression), mAccessExpressions(accessExpressions) {
+
+}
+
 std::shared_ptr<ExpressionAST> ArrayAccessAST::arrayRefExpression() const {
 	return mArrayRefExpression;
 }
 
 std::shared_ptr<ExpressionAST> ArrayAccessAST::accessExpression() const {
-	return mAccessExpression;
+	return mAccessExpressions.at(0);
+}
+
+const std::vector<std::shared_ptr<ExpressionAST>>& ArrayAccessAST::accessExpressions() const {
+	return mAccessExpressions;
+}
+
+std::shared_ptr<Type> ArrayAccessAST::elementType(std::shared_ptr<Type> arrayType) {
+	if (auto rectangularType = std::dynamic_pointer_cast<RectangularArrayType>(arrayType)) {
+		return rectangularType->elementType();
+	} else if (auto jaggedType = std::dynamic_pointer_cast<ArrayType>(arrayType)) {
+		return jaggedType->elementType();
+	}
+
+	return nullptr;
+}
+
+void ArrayAccessAST::typeCheckAccess(TypeChecker& checker, std::shared_ptr<Type> arrayType,
+									 const std::vector<std::shared_ptr<ExpressionAST>>& accessExpressions, std::string arrayString) {
+	//Check if array
+	if (elementType(arrayType) == nullptr) {
+		checker.typeError("The expression '" + arrayString + "' is not of array type.");
+	}
+
+	int rank = 1;
+	if (auto rectangularType = std::dynamic_pointer_cast<RectangularArrayType>(arrayType)) {
+		rank = rectangularType->rank();
+	}
+
+	if ((int)accessExpressions.size() != rank) {
+		checker.typeError(
+			"Expected " + std::to_string(rank) + " indices for the array of type '" + arrayType->name()
+			+ "' but got " + std::to_string(accessExpressions.size()) + ".");
+	}
+
+	for (auto accessExpr : accessExpressions) {
+		checker.assertSameType(
+			*checker.makeType("Int"),
+			*accessExpr->expressionType(checker),
+			"Expected the array access indexing to be of type 'Int'.");
+	}
+}
+
+void ArrayAccessAST::generateIndex(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> arrayType,
+								   const std::vector<std::shared_ptr<ExpressionAST>>& accessExpressions) {
+	auto rectangularType = std::dynamic_pointer_cast<RectangularArrayType>(arrayType);
+
+	if (rectangularType == nullptr) {
+		accessExpressions.at(0)->generateCode(codeGen, func);
+		return;
+	}
+
+	//The array is used for the elements and the lengths. Each index is checked against its length.
+	auto className = rectangularType->vmClassName();
+	auto intType = codeGen.typeChecker().findType("Int");
+	int arrayLocal = func.newLocal("$local$_array_" + std::to_string(func.numLocals()), rectangularType);
+	func.addStoreLocal(arrayLocal);
+	func.addLoadLocal(arrayLocal);
+	func.addInstruction("LDFIELD " + className + "::" + RectangularArrayType::elementsField);
+
+	std::vector<int> indexLocals;
+	std::vector<int> lengthLocals;
+
+	for (std::size_t dim = 0; dim < accessExpressions.size(); dim++) {
+		indexLocals.push_back(func.newLocal("$local$_index_" + std::to_string(func.numLocals()), intType));
+		accessExpressions[dim]->generateCode(codeGen, func);
+		func.addStoreLocal(indexLocals[dim]);
+	}
+
+	std::vector<int> failBranches;
+
+	for (std::size_t dim = 0; dim < accessExpressions.size(); dim++) {
+		lengthLocals.push_back(func.newLocal("$local$_length_" + std::to_string(func.numLocals()), intType));
+		func.addLoadLocal(arrayLocal);
+		func.addInstruction("LDFIELD " + className + "::" + rectangularType->lengthField(dim));
+		func.addStoreLocal(lengthLocals[dim]);
+
+		func.addLoadLocal(indexLocals[dim]);
+		func.addInstruction("LDINT 0");
+		failBranches.push_back(func.numInstructions());
+		func.addInstruction("BLT");
+
+		func.addLoadLocal(indexLocals[dim]);
+		func.addLoadLocal(lengthLocals[dim]);
+		failBranches.push_back(func.numInstructions());
+		func.addInstruction("BGE");
+	}
+
+	//The index is computed in row-major order
+	func.addLoadLocal(indexLocals[0]);
+
+	for (std::size_t dim = 1; dim < accessExpressions.size(); dim++) {
+		func.addLoadLocal(lengthLocals[dim]);
+		func.addInstruction("MUL");
+		func.addLoadLocal(indexLocals[dim]);
+		func.addInstruction("ADD");
+	}
+
+	int endBranch = func.numInstructions();
+	func.addInstruction("BR");
+
+	//An index out of bounds is replaced by an invalid index, so that the element access fails
+	func.setBranchTargets(failBranches, func.numInstructions());
+	func.addInstruction("LDINT -1");
+	func.setBranchTargets({ endBranch }, func.numInstructions());
 }
 
 std::string ArrayAccessAST::asString() const {
-	return mArrayRefExpression->asString() + "[" + mAccessExpression->asString() + "]";
+	auto accessStr = Helpers::join<std::shared_ptr<ExpressionAST>>(
+		mAccessExpressions,
+		[](std::shared_ptr<ExpressionAST> access) { return access->asString(); },
+		", ");
+
+	return mArrayRefExpression->asString() + "[" + accessStr + "]";
 }
 
 void ArrayAccessAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newAccess;
-
-	while (mAccessExpression->rewriteAST(newAccess, compiler)) {
-		mAccessExpression = std::dynamic_pointer_cast<ExpressionAST>(newAccess);
+	for (auto& accessExpr : mAccessExpressions) {
+		AST::rewriteTree(accessExpr, compiler);
 	}
 
 	std::shared_ptr<AbstractSyntaxTree> newMember;
@@ -230,47 +466,40 @@ void ArrayAccessAST::rewrite(Compiler& compiler) {
 		mArrayRefExpression = std::dynamic_pointer_cast<ExpressionAST>(newMember);
 	}
 
-	mAccessExpression->rewrite(compiler);
 	mArrayRefExpression->rewrite(compiler);
 }
 
 void ArrayAccessAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
 	AbstractSyntaxTree::generateSymbols(binder, symbolTable);
 	mArrayRefExpression->generateSymbols(binder, symbolTable);
-	mAccessExpression->generateSymbols(binder, symbolTable);
+
+	for (auto accessExpr : mAccessExpressions) {
+		accessExpr->generateSymbols(binder, symbolTable);
+	}
 }
 
 void ArrayAccessAST::typeCheck(TypeChecker& checker) {
-	mAccessExpression->typeCheck(checker);
-	mArrayRefExpression->typeCheck(checker);
-
-	//Check if array
-	auto varType = std::dynamic_pointer_cast<ArrayType>(mArrayRefExpression->expressionType(checker));
-
-	if (varType == nullptr) {
-		checker.typeError("The expression '" + mArrayRefExpression->asString() + "' is not of array type.");
+	for (auto accessExpr : mAccessExpressions) {
+		accessExpr->typeCheck(checker);
 	}
 
-	checker.assertSameType(
-		*checker.makeType("Int"),
-		*mAccessExpression->expressionType(checker),
-		"Expected the array access indexing to be of type 'Int'.");
+	mArrayRefExpression->typeCheck(checker);
+
+	typeCheckAccess(checker, mArrayRefExpression->expressionType(checker), mAccessExpressions, mArrayRefExpression->asString());
 }
 	
 std::shared_ptr<Type> ArrayAccessAST::expressionType(const TypeChecker& checker) const {
-	auto varType = std::dynamic_pointer_cast<ArrayType>(mArrayRefExpression->expressionType(checker));
-	return varType->elementType();
+	return elementType(mArrayRefExpression->expressionType(checker));
 }
 
-void ArrayAccessAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> elementType) {
-	if (elementType == nullptr) {
+void ArrayAccessAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> arrayType) {
+	if (arrayType == nullptr) {
 		mArrayRefExpression->generateCode(codeGen, func);
-		elementType = std::dynamic_pointer_cast<ArrayType>(mArrayRefExpression->expressionType(codeGen.typeChecker()))
-			->elementType();
+		arrayType = mArrayRefExpression->expressionType(codeGen.typeChecker());
 	}
 
-	mAccessExpression->generateCode(codeGen, func);
-	func.addInstruction("LDELEM " + elementType->vmType());
+	generateIndex(codeGen, func, arrayType, mAccessExpressions);
+	func.addInstruction("LDELEM " + elementType(arrayType)->vmType());
 }
 
 void ArrayAccessAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
@@ -280,9 +509,9 @@ void ArrayAccessAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& fun
 //Array set element
 ArraySetElementAST::ArraySetElementAST(
 	std::shared_ptr<ExpressionAST> arrayRefExpression,
-	std::shared_ptr<ExpressionAST> accessExpression,
+	std::vector<std::shared_ptr<ExpressionAST>> accessExpressions,
 	std::shared_ptr<ExpressionAST> rightHandSide)
-	: mArrayRefExpression(arrayRefExpression), mAccessExpression(accessExpression), mRightHandSide(rightHandSide) {
+	: mArrayRefExpression(arrayRefExpression), mAccessExpressions(accessExpressions), mRightHandSide(rightHandSide) {
 	
 }
 
@@ -291,7 +520,11 @@ std::shared_ptr<ExpressionAST> ArraySetElementAST::arrayRefExpression() const {
 }
 
 std::shared_ptr<ExpressionAST> ArraySetElementAST::accessExpression() const {
-	return mAccessExpression;
+	return mAccessExpressions.at(0);
+}
+
+const std::vector<std::shared_ptr<ExpressionAST>>& ArraySetElementAST::accessExpressions() const {
+	return mAccessExpressions;
 }
 
 std::shared_ptr<ExpressionAST> ArraySetElementAST::rightHandSide() const {
@@ -299,7 +532,12 @@ std::shared_ptr<ExpressionAST> ArraySetElementAST::rightHandSide() const {
 }
 
 std::string ArraySetElementAST::asString() const {
-	return mArrayRefExpression->asString() + "[" + mAccessExpression->asString() + "] = " + mRightHandSide->asString();
+	auto accessStr = Helpers::join<std::shared_ptr<ExpressionAST>>(
+		mAccessExpressions,
+		[](std::shared_ptr<ExpressionAST> access) { return access->asString(); },
+		", ");
+
+	return mArrayRefExpression->asString() + "[" + accessStr + "] = " + mRightHandSide->asString();
 }
 
 void ArraySetElementAST::rewrite(Compiler& compiler) {
@@ -308,49 +546,41 @@ void ArraySetElementAST::rewrite(Compiler& compiler) {
 		mArrayRefExpression = std::dynamic_pointer_cast<ExpressionAST>(newArrayRef);
 	}
 
-	std::shared_ptr<AbstractSyntaxTree> newAccess;
-	while (mAccessExpression->rewriteAST(newAccess, compiler)) {
-		mAccessExpression = std::dynamic_pointer_cast<ExpressionAST>(newAccess);
-	}
+	mArrayRefExpression->rewrite(compiler);
 
-	std::shared_ptr<AbstractSyntaxTree> newRHS;
-	while (mRightHandSide->rewriteAST(newRHS, compiler)) {
-		mRightHandSide = std::dynamic_pointer_cast<ExpressionAST>(newRHS);
+	for (auto& accessExpr : mAccessExpressions) {
+		AST::rewriteTree(accessExpr, compiler);
 	}
 
-	mAccessExpression->rewrite(compiler);
-	mArrayRefExpression->rewrite(compiler);
-	mRightHandSide->rewrite(compiler);
+	AST::rewriteTree(mRightHandSide, compiler);
 }
 
 void ArraySetElementAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
 	AbstractSyntaxTree::generateSymbols(binder, symbolTable);
 	mArrayRefExpression->generateSymbols(binder, symbolTable);
-	mAccessExpression->generateSymbols(binder, symbolTable);
+
+	for (auto accessExpr : mAccessExpressions) {
+		accessExpr->generateSymbols(binder, symbolTable);
+	}
+
 	mRightHandSide->generateSymbols(binder, symbolTable);
 }
 
 void ArraySetElementAST::typeCheck(TypeChecker& checker) {
 	mArrayRefExpression->typeCheck(checker);
-	mAccessExpression->typeCheck(checker);
-	mRightHandSide->typeCheck(checker);
-
-	//Check if array
-	auto arrayRefType = std::dynamic_pointer_cast<ArrayType>(mArrayRefExpression->expressionType(checker));
 
-	if (arrayRefType == nullptr) {
-		checker.typeError("The expression '" + mArrayRefExpression->asString() + "' is not of array type.");
+	for (auto accessExpr : mAccessExpressions) {
+		accessExpr->typeCheck(checker);
 	}
 
-	//Access access
-	checker.assertSameType(
-		*checker.makeType("Int"),
-		*mAccessExpression->expressionType(checker),
-		"Expected the array indexing to be of type 'Int'.");
+	mRightHandSide->typeCheck(checker);
+
+	auto arrayRefType = mArrayRefExpression->expressionType(checker);
+	ArrayAccessAST::typeCheckAccess(checker, arrayRefType, mAccessExpressions, mArrayRefExpression->asString());
 
 	//Check rhs
 	checker.assertSameType(
-		*arrayRefType->elementType(), 
+		*ArrayAccessAST::elementType(arrayRefType),
 		*mRightHandSide->expressionType(checker),
 		asString());
 }
@@ -359,16 +589,15 @@ std::shared_ptr<Type> ArraySetElementAST::expressionType(const TypeChecker& chec
 	return checker.findType("Void");
 }
 
-void ArraySetElementAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> elementType) {
-	if (elementType == nullptr) {
-		auto arrayRefType = std::dynamic_pointer_cast<ArrayType>(mArrayRefExpression->expressionType(codeGen.typeChecker()));
+void ArraySetElementAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> arrayType) {
+	if (arrayType == nullptr) {
 		mArrayRefExpression->generateCode(codeGen, func);
-		elementType = arrayRefType->elementType();
+		arrayType = mArrayRefExpression->expressionType(codeGen.typeChecker());
 	}
 
-	mAccessExpression->generateCode(codeGen, func);
+	ArrayAccessAST::generateIndex(codeGen, func, arrayType, mAccessExpressions);
 	mRightHandSide->generateCode(codeGen, func);
-	func.addInstruction("STELEM " + elementType->vmType());
+	func.addInstruction("STELEM " + ArrayAccessAST::elementType(arrayType)->vmType());
 }
 
 void ArraySetElementAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
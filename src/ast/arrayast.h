@@ -44,6 +44,11 @@ private:
 
 	//Returns the type string
 	std::string typeString(int dim = -1) const;
+
+	//Generates code for creating the arrays of the given dimension, where the outermost is 0. The array is stored in the local
+	//of the dimension, and the arrays of the inner dimensions are created by loops counting with the index locals.
+	void generateArray(CodeGenerator& codeGen, GeneratedFunction& func, int dim, const std::vector<int>& lengthLocals,
+					   const std::vector<int>& arrayLocals, const std::vector<int>& indexLocals);
 public:
 	//Creates a new multidim array declaration AST
 	MultiDimArrayDeclarationAST(std::string elementType, std::vector<std::shared_ptr<ExpressionAST>> lengthExpressions);
@@ -67,21 +72,70 @@ public:
 	virtual void generateCode(CodeGenerator& codeGen, GeneratedFunction& func) override;
 };
 
-//Represents an array access AST
+//Represents a rectangular array declaration AST, such as 'new Float[,](height, width)'
+class RectangularArrayDeclarationAST : public ExpressionAST {
+private:
+	std::unique_ptr<TypeName> mElementType;
+	int mRank;
+	std::vector<std::shared_ptr<ExpressionAST>> mLengthExpressions;
+
+	//Returns the type string
+	std::string typeString() const;
+public:
+	//Creates a new rectangular array declaration AST
+	RectangularArrayDeclarationAST(std::string elementType, int rank, std::vector<std::shared_ptr<ExpressionAST>> lengthExpressions);
+
+	//Returns the element type
+	std::string elementType() const;
+
+	//Returns the length expressions
+	const std::vector<std::shared_ptr<ExpressionAST>>& lengthExpressions() const;
+
+	std::string asString() const override;
+
+	virtual void rewrite(Compiler& compiler) override;
+
+	virtual void generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) override;
+
+	virtual void typeCheck(TypeChecker& checker) override;
+
+	virtual std::shared_ptr<Type> expressionType(const TypeChecker& checker) const override;
+
+	virtual void generateCode(CodeGenerator& codeGen, GeneratedFunction& func) override;
+};
+
+//Represents an array access AST. Rectangular arrays are indexed by one expression per dimension.
 class ArrayAccessAST : public ExpressionAST {
 private:
 	std::shared_ptr<ExpressionAST> mArrayRefExpression;
-	std::shared_ptr<ExpressionAST> mAccessExpression;
+	std::vector<std::shared_ptr<ExpressionAST>> mAccessExpressions;
 public:
 	//Creates a new array access AST
 	ArrayAccessAST(std::shared_ptr<ExpressionAST> arrayRefExpression, std::shared_ptr<ExpressionAST> accessExpression);
+	ArrayAccessAST(std::shared_ptr<ExpressionAST> arrayRefExpression, std::vector<std::shared_ptr<ExpressionAST>> accessExpressions);
 
 	//Returns the array reference expression
 	std::shared_ptr<ExpressionAST> arrayRefExpression() const;
 
-	//Returns the access expression
+	//Returns the access expression of the first dimension
 	std::shared_ptr<ExpressionAST> accessExpression() const;
 
+	//Returns the access expressions
+	const std::vector<std::shared_ptr<ExpressionAST>>& accessExpressions() const;
+
+	//Returns the element type of the given array or rectangular array type. Nullptr if not an array type.
+	static std::shared_ptr<Type> elementType(std::shared_ptr<Type> arrayType);
+
+	//Checks that the given type is an array that can be indexed by the given type checked access expressions
+	static void typeCheckAccess(TypeChecker& checker, std::shared_ptr<Type> arrayType,
+								const std::vector<std::shared_ptr<ExpressionAST>>& accessExpressions, std::string arrayString);
+
+	//Generates code for the index of an element, where the reference to the array is on the stack.
+	//For rectangular arrays, the reference is replaced by the flat array, and the index is computed in row-major order after
+	//each index is checked against its length. The checks and the index are generated at each access.
+	static void generateIndex(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> arrayType,
+							  const std::vector<std::shared_ptr<ExpressionAST>>& accessExpressions);
+
 	std::string asString() const override;
 
 	virtual void rewrite(Compiler& compiler) override;
@@ -92,8 +146,8 @@ public:
 
 	virtual std::shared_ptr<Type> expressionType(const TypeChecker& checker) const override;
 
-	//Generates code for accessing an array
-	void generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> elementType);
+	//Generates code for accessing an array. If the array type is given, the reference to the array is on the stack.
+	void generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> arrayType);
 
 	virtual void generateCode(CodeGenerator& codeGen, GeneratedFunction& func) override;
 };
@@ -102,21 +156,24 @@ public:
 class ArraySetElementAST : public ExpressionAST {
 private:
 	std::shared_ptr<ExpressionAST> mArrayRefExpression;
-	std::shared_ptr<ExpressionAST> mAccessExpression;
+	std::vector<std::shared_ptr<ExpressionAST>> mAccessExpressions;
 	std::shared_ptr<ExpressionAST> mRightHandSide;
 public:
 	//Creates a new array set element AST
 	ArraySetElementAST(
 		std::shared_ptr<ExpressionAST> arrayRefExpression,
-		std::shared_ptr<ExpressionAST> accessExpression,
+		std::vector<std::shared_ptr<ExpressionAST>> accessExpressions,
 		std::shared_ptr<ExpressionAST> rightHandSide);
 
 	//Returns the array reference expression
 	std::shared_ptr<ExpressionAST> arrayRefExpression() const;
 
-	//Returns the access expression
+	//Returns the access expression of the first dimension
 	std::shared_ptr<ExpressionAST> accessExpression() const;
 
+	//Returns the access expressions
+	const std::vector<std::shared_ptr<ExpressionAST>>& accessExpressions() const;
+
 	//Returns the right hand side expression
 	std::shared_ptr<ExpressionAST> rightHandSide() const;
 
@@ -130,8 +187,8 @@ public:
 
 	virtual std::shared_ptr<Type> expressionType(const TypeChecker& checker) const override;
 
-	//Generated code for setting an element
-	void generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> elementType);
+	//Generated code for setting an element. If the array type is given, the reference to the array is on the stack.
+	void generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<Type> arrayType);
 
 	virtual void generateCode(CodeGenerator& codeGen, GeneratedFunction& func) override;
 };
\ No newline at end of file
@@ -2,29 +2,30 @@
 #include "../typechecker.h"
 #include "../symboltable.h"
 #include "../binder.h"
+#include "../codegenerator.h"
 #include <stdexcept>
 
-void AbstractSyntaxTree::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
+void AbstractSyntaxTree::generateSymbols(Binder& /*binder*/, std::shared_ptr<SymbolTable> symbolTable) {
 	mSymbolTable = symbolTable;
 }
 
-void AbstractSyntaxTree::rewrite(Compiler& compiler) {
+void AbstractSyntaxTree::rewrite(Compiler& /*compiler*/) {
 
 }
 
-bool AbstractSyntaxTree::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
+bool AbstractSyntaxTree::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& /*newAST*/, Compiler& /*compiler*/) const {
 	return false;
 }
 
-void AbstractSyntaxTree::typeCheck(TypeChecker& checker) {
+void AbstractSyntaxTree::typeCheck(TypeChecker& /*checker*/) {
 
 }
 
-void AbstractSyntaxTree::verify(SemanticVerifier& verifier) {
+void AbstractSyntaxTree::verify(SemanticVerifier& /*verifier*/) {
 
 }
 
-void AbstractSyntaxTree::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void AbstractSyntaxTree::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& /*func*/) {
 
 }
 
@@ -35,4 +36,11 @@ std::ostream& operator<<(std::ostream& os, const AbstractSyntaxTree& ast) {
 
 std::shared_ptr<Type> ExpressionAST::expressionType(const TypeChecker& checker) const {
 	return checker.findType("Void");
+}
+
+void ExpressionAST::generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches) {
+	generateCode(codeGen, func);
+	func.addInstruction("LDTRUE");
+	branches.push_back(func.numInstructions());
+	func.addInstruction(branchIf ? "BEQ" : "BNE");
 }
\ No newline at end of file
@@ -26,7 +26,7 @@ public:
 	using VisitFn = std::function<void(const AbstractSyntaxTree*)>;
 
 	//Visits all the nodes
-	virtual void visit(VisitFn visitFn) const {};
+	virtual void visit(VisitFn /*visitFn*/) const {};
 
 	//Rewrites the children of the current tree
 	virtual void rewrite(Compiler& compiler);
@@ -54,6 +54,10 @@ class ExpressionAST : public AbstractSyntaxTree {
 public:
 	//The type returned by the expression
 	virtual std::shared_ptr<Type> expressionType(const TypeChecker& checker) const; 
+
+	//Generates code that branches if the expression evaluates to the given value.
+	//The indices of the branch instructions are added to the given list, and their targets must be set by the caller.
+	virtual void generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches);
 };
 
 //Represents a statement AST
@@ -62,6 +66,23 @@ class StatementAST : public AbstractSyntaxTree {
 };
 
 namespace AST {
+	//Rewrites the given tree and its children. The tree is rewritten both before and after its children,
+	//so that rewrites depending on rewritten children (such as constant folding) are applied bottom-up.
+	template <class T>
+	void rewriteTree(std::shared_ptr<T>& tree, Compiler& compiler) {
+		std::shared_ptr<AbstractSyntaxTree> newAST;
+
+		while (tree->rewriteAST(newAST, compiler)) {
+			tree = std::dynamic_pointer_cast<T>(newAST);
+		}
+
+		tree->rewrite(compiler);
+
+		while (tree->rewriteAST(newAST, compiler)) {
+			tree = std::dynamic_pointer_cast<T>(newAST);
+		}
+	}
+
 	//Combines the given ASTs into a string with the given seperator
 	template <class T>
 	std::string combineAST(std::vector<std::shared_ptr<T>> asts, std::string sep) {
@@ -30,13 +30,7 @@ std::string BlockAST::asString() const {
 
 void BlockAST::rewrite(Compiler& compiler) {
 	for (auto& statement : mStatements) {
-		std::shared_ptr<AbstractSyntaxTree> newAST;
-
-		if (statement->rewriteAST(newAST, compiler)) {
-			statement = std::dynamic_pointer_cast<StatementAST>(newAST);
-		}
-
-		statement->rewrite(compiler);
+		AST::rewriteTree(statement, compiler);
 	}
 }
 
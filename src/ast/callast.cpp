@@ -16,6 +16,10 @@ CallExpressionAST::CallExpressionAST(std::string functionName, std::vector<std::
 
 }
 
+std::shared_ptr<FunctionSymbol> CallExpressionAST::funcSymbol() const {
+	return mFuncSymbol;
+}
+
 std::shared_ptr<FunctionSignatureSymbol> CallExpressionAST::funcSignature(const TypeChecker& typeChecker) const {
 	std::vector<std::string> argumentsTypes;
 
@@ -26,6 +30,25 @@ std::shared_ptr<FunctionSignatureSymbol> CallExpressionAST::funcSignature(const
 	return std::dynamic_pointer_cast<FunctionSignatureSymbol>(mFuncSymbol->findOverload(argumentsTypes));
 }
 
+std::string CallExpressionAST::signature(const TypeChecker& typeChecker) const {
+	auto argsTypeStr = Helpers::join<std::shared_ptr<ExpressionAST>>(
+		arguments(),
+		[&](std::shared_ptr<ExpressionAST> arg) {
+			return arg->expressionType(typeChecker)->vmType();
+		}, " ");
+
+	auto nameParts = Helpers::splitString(mFunctionName, "::");
+	auto funcName = nameParts[nameParts.size() - 1];
+	auto namespaceName = mFuncSymbol->definedNamespace().vmName();
+	std::string calledFuncName = funcName;
+
+	if (namespaceName != "") {
+		calledFuncName = namespaceName + "." + funcName;
+	}
+
+	return calledFuncName + "(" + argsTypeStr + ")";
+}
+
 std::string CallExpressionAST::functionName() const {
 	return mFunctionName;
 }
@@ -62,18 +85,13 @@ void CallExpressionAST::visit(VisitFn visitFn) const {
 
 void CallExpressionAST::rewrite(Compiler& compiler) {
 	for (auto& arg : mArguments) {
-		std::shared_ptr<AbstractSyntaxTree> newAST;
-
-		while (arg->rewriteAST(newAST, compiler)) {
-			arg = std::dynamic_pointer_cast<ExpressionAST>(newAST);
-		}
-
-		arg->rewrite(compiler);
+		AST::rewriteTree(arg, compiler);
 	}
 }
 
 bool CallExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
-	if (mSymbolTable != nullptr) {
+	//The optimization pass is excluded, as the calls of member call expressions are bound during type checking
+	if (mSymbolTable != nullptr && !compiler.isOptimizing()) {
 		//Call to member function within member function with implicit 'this'
 		if (mFuncSymbol->isMember()) {
 			newAST = std::make_shared<MemberCallExpressionAST>(
@@ -84,6 +102,16 @@ bool CallExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST,
 		}
 	}
 
+	//Replace calls of pure functions with constant arguments by their results
+	if (compiler.isEvaluating()) {
+		auto result = compiler.evaluator().evaluateCall(*this);
+
+		if (result != nullptr) {
+			newAST = result;
+			return true;
+		}
+	}
+
 	return false;
 }
 
@@ -149,27 +177,14 @@ std::shared_ptr<Type> CallExpressionAST::expressionType(const TypeChecker& check
 	return checker.findType(func->returnType());
 }
 
-void CallExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::string scopeName) {
+void CallExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func, std::string /*scopeName*/) {
 	for (auto arg : arguments()) {
 		arg->generateCode(codeGen, func);
 	}
 
-	auto argsTypeStr = Helpers::join<std::shared_ptr<ExpressionAST>>(
-		arguments(),
-		[&](std::shared_ptr<ExpressionAST> arg) {
-			return arg->expressionType(codeGen.typeChecker())->vmType();
-		}, " ");
-
-	auto nameParts = Helpers::splitString(mFunctionName, "::");
-	auto funcName = nameParts[nameParts.size() - 1];
-	auto namespaceName = mFuncSymbol->definedNamespace().vmName();
-	std::string calledFuncName = funcName;
-
-	if (namespaceName != "") {
-		calledFuncName = namespaceName + "." + funcName;
-	}
-
-	func.addInstruction("CALL " + calledFuncName + "(" + argsTypeStr + ")");
+	auto calledSignature = signature(codeGen.typeChecker());
+	codeGen.instructionInfo().defineFunction(calledSignature, expressionType(codeGen.typeChecker()));
+	func.addInstruction("CALL " + calledSignature);
 }
 
 void CallExpressionAST::generateMemberCallCode(CodeGenerator& codeGen, GeneratedFunction& func, std::shared_ptr<ClassType> classType) {
@@ -183,8 +198,9 @@ void CallExpressionAST::generateMemberCallCode(CodeGenerator& codeGen, Generated
 			return arg->expressionType(codeGen.typeChecker())->vmType();
 		}, " ");
 
-	auto calldedFuncName = classType->vmClassName() + "::" + mFunctionName;
-	func.addInstruction("CALLINST " + calldedFuncName + "(" + argsTypeStr + ")");
+	auto signature = classType->vmClassName() + "::" + mFunctionName + "(" + argsTypeStr + ")";
+	codeGen.instructionInfo().defineFunction(signature, expressionType(codeGen.typeChecker()));
+	func.addInstruction("CALLINST " + signature);
 }
 
 void CallExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
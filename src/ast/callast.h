@@ -37,9 +37,15 @@ public:
 	//Sets the call table where to look for functions. The default is the symbol table for the tree.
 	void setCallTable(std::shared_ptr<SymbolTable> callTable);
 
+	//Returns the function symbol. Returns null if not bound.
+	std::shared_ptr<FunctionSymbol> funcSymbol() const;
+
 	//Finds the func signature symbol
 	std::shared_ptr<FunctionSignatureSymbol> funcSignature(const TypeChecker& typeChecker) const;
 
+	//Returns the signature of the called function in the VM
+	std::string signature(const TypeChecker& typeChecker) const;
+
 	std::string asString() const override;
 
 	virtual void visit(VisitFn visitFn) const override;
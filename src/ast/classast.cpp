@@ -66,13 +66,14 @@ std::shared_ptr<Type> FieldDeclarationExpressionAST::expressionType(const TypeCh
 	return checker.findType(fieldType());
 }
 
-void FieldDeclarationExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void FieldDeclarationExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& /*func*/) {
 	
 }
 
 //Member function
-MemberFunctionAST::MemberFunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body, AccessModifiers accessModifier)
-	: FunctionAST(prototype, body), mAccessModifier(accessModifier) {
+MemberFunctionAST::MemberFunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body, AccessModifiers accessModifier,
+									 std::vector<std::string> attributes)
+	: FunctionAST(prototype, body, attributes), mAccessModifier(accessModifier) {
 
 }
 
@@ -304,7 +305,7 @@ void ClassDefinitionAST::typeCheck(TypeChecker& checker) {
 	}
 }
 
-void ClassDefinitionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void ClassDefinitionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& /*func*/) {
 
 }
 
@@ -343,12 +344,7 @@ std::shared_ptr<FunctionSignatureSymbol> NewClassExpressionAST::constructorSigna
 
 void NewClassExpressionAST::rewrite(Compiler& compiler) {
 	for (auto& arg : mConstructorArguments) {
-		std::shared_ptr<AbstractSyntaxTree> newArg;
-		if (arg->rewriteAST(newArg, compiler)) {
-			arg = std::dynamic_pointer_cast<ExpressionAST>(newArg);
-		}
-
-		arg->rewrite(compiler);
+		AST::rewriteTree(arg, compiler);
 	}
 }
 
@@ -56,7 +56,8 @@ private:
 	AccessModifiers mAccessModifier;
 public:
 	//Creates a new member function
-	MemberFunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body, AccessModifiers accessModifier);
+	MemberFunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body, AccessModifiers accessModifier,
+					  std::vector<std::string> attributes = {});
 
 	//Returns the access modifier
 	AccessModifiers accessModifier() const;
@@ -3,6 +3,12 @@
 #include "../typechecker.h"
 #include "../type.h"
 #include "../codegenerator.h"
+#include "../compiler.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <iomanip>
 
 //Integer expression AST
 IntegerExpressionAST::IntegerExpressionAST(int value)
@@ -26,7 +32,7 @@ std::shared_ptr<Type> IntegerExpressionAST::expressionType(const TypeChecker& ch
 	return checker.findType("Int");
 }
 
-void IntegerExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void IntegerExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 	func.addInstruction("LDINT " + std::to_string(mValue));
 }
 
@@ -56,7 +62,7 @@ std::shared_ptr<Type> BoolExpressionAST::expressionType(const TypeChecker& check
 	return checker.findType("Bool");
 }
 
-void BoolExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void BoolExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 	if (mValue) {
 		func.addInstruction("LDTRUE");
 	} else {
@@ -64,6 +70,19 @@ void BoolExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction&
 	}
 }
 
+void BoolExpressionAST::generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches) {
+	if (!codeGen.isOptimizing()) {
+		ExpressionAST::generateConditionCode(codeGen, func, branchIf, branches);
+		return;
+	}
+
+	//The condition is known, so either always or never branch
+	if (mValue == branchIf) {
+		branches.push_back(func.numInstructions());
+		func.addInstruction("BR");
+	}
+}
+
 //Float expression AST
 FloatExpressionAST::FloatExpressionAST(float value)
 	: mValue(value) {
@@ -86,8 +105,17 @@ std::shared_ptr<Type> FloatExpressionAST::expressionType(const TypeChecker& chec
 	return checker.findType("Float");
 }
 
-void FloatExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
-	func.addInstruction("LDFLOAT " + std::to_string(mValue));
+void FloatExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
+	//Use the shortest form unless it loses precision, which can happen for folded constants
+	auto valueStr = std::to_string(mValue);
+
+	if (std::stof(valueStr) != mValue) {
+		std::ostringstream valueStream;
+		valueStream << std::setprecision(std::numeric_limits<float>::max_digits10) << mValue;
+		valueStr = valueStream.str();
+	}
+
+	func.addInstruction("LDFLOAT " + valueStr);
 }
 
 //Null ref expression AST
@@ -107,7 +135,7 @@ std::shared_ptr<Type> NullRefExpressionAST::expressionType(const TypeChecker& ch
 	return checker.findType("NullRef");
 }
 
-void NullRefExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void NullRefExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 	func.addInstruction("LDNULL");
 }
 
@@ -133,7 +161,7 @@ std::shared_ptr<Type> CharExpressionAST::expressionType(const TypeChecker& check
 	return checker.findType("Char");
 }
 
-void CharExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void CharExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 	func.addInstruction("LDCHAR " + std::to_string((int)mValue));
 }
 
@@ -173,7 +201,7 @@ std::shared_ptr<Type> StringExpressionAST::expressionType(const TypeChecker& che
 	return checker.findType("std::String");
 }
 
-void StringExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void StringExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 	func.addInstruction("LDSTR \"" + toProgramString(mValue)  + "\"");
 }
 
@@ -201,13 +229,35 @@ void CastExpressionAST::visit(VisitFn visitFn) const {
 }
 
 void CastExpressionAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newAST;
+	AST::rewriteTree(mExpression, compiler);
+}
 
-	if (mExpression->rewriteAST(newAST, compiler)) {
-		mExpression = std::dynamic_pointer_cast<ExpressionAST>(newAST);
+bool CastExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
+	if (!compiler.isOptimizing()) {
+		return false;
+	}
+
+	//Fold conversions of constants
+	if (mTypeName == "Float") {
+		if (auto intExpr = std::dynamic_pointer_cast<IntegerExpressionAST>(mExpression)) {
+			newAST = std::make_shared<FloatExpressionAST>((float)intExpr->value());
+			return true;
+		}
+	} else if (mTypeName == "Int") {
+		if (auto floatExpr = std::dynamic_pointer_cast<FloatExpressionAST>(mExpression)) {
+			//Only fold if the result is defined, else leave it to the VM
+			double value = std::trunc(floatExpr->value());
+
+			if (std::isfinite(value)
+				&& value >= (double)std::numeric_limits<int>::min()
+				&& value <= (double)std::numeric_limits<int>::max()) {
+				newAST = std::make_shared<IntegerExpressionAST>((int)value);
+				return true;
+			}
+		}
 	}
 
-	mExpression->rewrite(compiler);
+	return false;
 }
 
 void CastExpressionAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
@@ -50,6 +50,8 @@ public:
 	virtual std::shared_ptr<Type> expressionType(const TypeChecker& checker) const override; 
 
 	virtual void generateCode(CodeGenerator& codeGen, GeneratedFunction& func) override;
+
+	virtual void generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches) override;
 };
 
 //Represents a float expression
@@ -148,6 +150,8 @@ public:
 	virtual void visit(VisitFn visitFn) const override;
 	
 	virtual void rewrite(Compiler& compiler) override;
+
+	virtual bool rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const override;
 	
 	virtual void generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) override;
 
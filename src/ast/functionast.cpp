@@ -8,9 +8,12 @@
 #include "../typechecker.h"
 #include "../type.h"
 #include "../semantics.h"
+#include "../codegenerator.h"
 #include "../helpers.h"
 #include "../typename.h"
 
+#include <algorithm>
+
 //Function prototype AST
 FunctionPrototypeAST::FunctionPrototypeAST(std::string name, const std::vector<std::shared_ptr<VariableDeclarationExpressionAST>>& parameters, std::string returnType)
 	: mName(name), mParameters(parameters), mReturnType(TypeName::make(returnType)) {
@@ -112,11 +115,13 @@ void FunctionPrototypeAST::verify(SemanticVerifier& verifier) {
 }
 
 //Function AST
-FunctionAST::FunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body)
-	: mPrototype(prototype), mBody(body) {
+FunctionAST::FunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body, std::vector<std::string> attributes)
+	: mPrototype(prototype), mBody(body), mAttributes(attributes) {
 
 }
 
+const std::set<std::string> FunctionAST::validAttributes = { "Inline", "NoInline", "Export" };
+
 const std::shared_ptr<FunctionPrototypeAST> FunctionAST::prototype() const {
 	return mPrototype;
 }
@@ -125,8 +130,22 @@ std::shared_ptr<BlockAST> FunctionAST::body() const {
 	return mBody;
 }
 
+const std::vector<std::string>& FunctionAST::attributes() const {
+	return mAttributes;
+}
+
+bool FunctionAST::hasAttribute(std::string name) const {
+	return std::find(mAttributes.begin(), mAttributes.end(), name) != mAttributes.end();
+}
+
 std::string FunctionAST::asString() const {
-	auto funcStr = mPrototype->asString();
+	std::string funcStr = "";
+
+	for (auto& attribute : mAttributes) {
+		funcStr += "@" + attribute + " ";
+	}
+
+	funcStr += mPrototype->asString();
 	funcStr += mBody->asString();
 	return funcStr;
 }
@@ -234,6 +253,16 @@ void FunctionAST::checkReturnStatements(SemanticVerifier& verifier) {
 }
 
 void FunctionAST::verify(SemanticVerifier& verifier) {
+	for (auto& attribute : mAttributes) {
+		if (validAttributes.count(attribute) == 0) {
+			verifier.semanticError("'" + attribute + "' is not a valid function attribute.");
+		}
+	}
+
+	if (hasAttribute("Inline") && hasAttribute("NoInline")) {
+		verifier.semanticError("A function cannot have both the 'Inline' and 'NoInline' attributes.");
+	}
+
 	mPrototype->verify(verifier);
 	mBody->verify(verifier);
 
@@ -243,4 +272,5 @@ void FunctionAST::verify(SemanticVerifier& verifier) {
 
 void FunctionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
 	mBody->generateCode(codeGen, func);
+	func.addEndReturn();
 }
\ No newline at end of file
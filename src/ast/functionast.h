@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <set>
 
 class Compiler;
 class SymbolTable;
@@ -55,6 +56,7 @@ class FunctionAST : public AbstractSyntaxTree {
 private:
 	std::shared_ptr<FunctionPrototypeAST> mPrototype;
 	std::shared_ptr<BlockAST> mBody;
+	std::vector<std::string> mAttributes;
 	std::shared_ptr<SymbolTable> mBodyTable;
 
 	//Checks the given return statement
@@ -67,7 +69,7 @@ private:
 	void checkReturnStatements(SemanticVerifier& verifier);
 public:
 	//Creates a new function
-	FunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body);
+	FunctionAST(std::shared_ptr<FunctionPrototypeAST> prototype, std::shared_ptr<BlockAST> body, std::vector<std::string> attributes = {});
 
 	//Returns the prototype
 	const std::shared_ptr<FunctionPrototypeAST> prototype() const;
@@ -75,6 +77,15 @@ public:
 	//Returns the body
 	std::shared_ptr<BlockAST> body() const;
 
+	//Returns the attributes
+	const std::vector<std::string>& attributes() const;
+
+	//Indicates if the function has the given attribute
+	bool hasAttribute(std::string name) const;
+
+	//The attributes that functions can have
+	static const std::set<std::string> validAttributes;
+
 	std::string asString() const override;
 
 	virtual void visit(VisitFn visitFn) const override;
@@ -2,6 +2,7 @@
 #include "variableast.h"
 #include "callast.h"
 #include "arrayast.h"
+#include "expressionast.h"
 #include "../object.h"
 #include "../typechecker.h"
 #include "../binder.h"
@@ -36,7 +37,7 @@ void MemberAccessAST::visit(VisitFn visitFn) const {
 	visitFn(this);
 }
 
-bool MemberAccessAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
+bool MemberAccessAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& /*compiler*/) const {
 	if (auto callMember = std::dynamic_pointer_cast<CallExpressionAST>(mMemberExpression)) {
 		newAST = std::make_shared<MemberCallExpressionAST>(
 			mAccessExpression,
@@ -76,7 +77,9 @@ void MemberAccessAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTabl
 	}
 
 	if (arrayMember != nullptr) {
- 		arrayMember->accessExpression()->generateSymbols(binder, symbolTable);
+		for (auto accessExpr : arrayMember->accessExpressions()) {
+			accessExpr->generateSymbols(binder, symbolTable);
+		}
 	}
 }
 
@@ -117,7 +120,15 @@ void MemberAccessAST::typeCheck(TypeChecker& checker) {
 		}
 
 		if (auto arrayMember = std::dynamic_pointer_cast<ArrayAccessAST>(mMemberExpression)) {
-			arrayMember->accessExpression()->typeCheck(checker);
+			for (auto accessExpr : arrayMember->accessExpressions()) {
+				accessExpr->typeCheck(checker);
+			}
+
+			ArrayAccessAST::typeCheckAccess(
+				checker,
+				object.getField(memberName).type(),
+				arrayMember->accessExpressions(),
+				mMemberExpression->asString());
 		}
 	}
 }
@@ -148,7 +159,7 @@ const Field& MemberAccessAST::getField(const TypeChecker& checker) const {
 
 std::shared_ptr<Type> MemberAccessAST::expressionType(const TypeChecker& checker) const {
 	if (auto arrayMember = std::dynamic_pointer_cast<ArrayAccessAST>(mMemberExpression)) {
-		return std::dynamic_pointer_cast<ArrayType>(getField(checker).type())->elementType();
+		return ArrayAccessAST::elementType(getField(checker).type());
 	} else {
 		return getField(checker).type();
 	}
@@ -182,7 +193,7 @@ void MemberAccessAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& fu
 		func.addInstruction("LDFIELD " + classTypeRef->vmClassName() + "::" + memberName);
 
 		if (auto arrayMember = std::dynamic_pointer_cast<ArrayAccessAST>(mMemberExpression)) {
-			arrayMember->generateCode(codeGen, func, expressionType(codeGen.typeChecker()));
+			arrayMember->generateCode(codeGen, func, getField(codeGen.typeChecker()).type());
 		}
 	}
 }
@@ -233,9 +244,36 @@ void MemberCallExpressionAST::generateSymbols(Binder& binder, std::shared_ptr<Sy
 	mAccessExpression->generateSymbols(binder, symbolTable);
 }
 
+int MemberCallExpressionAST::rectangularLengthDimension(const TypeChecker& checker) const {
+	auto arrayType = std::dynamic_pointer_cast<RectangularArrayType>(mAccessExpression->expressionType(checker));
+
+	if (arrayType != nullptr
+		&& mMemberCallExpression->functionName() == "length"
+		&& mMemberCallExpression->arguments().size() == 1) {
+		if (auto dimExpr = std::dynamic_pointer_cast<IntegerExpressionAST>(mMemberCallExpression->arguments()[0])) {
+			return dimExpr->value();
+		}
+	}
+
+	return -1;
+}
+
 void MemberCallExpressionAST::typeCheck(TypeChecker& checker) {
 	mAccessExpression->typeCheck(checker);
 
+	//Special handling of the lengths of rectangular arrays
+	if (auto arrayType = std::dynamic_pointer_cast<RectangularArrayType>(mAccessExpression->expressionType(checker))) {
+		int dim = rectangularLengthDimension(checker);
+
+		if (dim < 0 || dim >= arrayType->rank()) {
+			checker.typeError(
+				"The lengths of the array of type '" + arrayType->name() + "' are accessed by 'length(<dimension>)',"
+				+ " where the dimension is an integer constant less than " + std::to_string(arrayType->rank()) + ".");
+		}
+
+		return;
+	}
+
 	if (auto varRef = std::dynamic_pointer_cast<VariableReferenceExpressionAST>(mAccessExpression)) {
 		auto varSymbol = std::dynamic_pointer_cast<VariableSymbol>(mSymbolTable->find(varRef->name()));
 		auto varRefType = checker.findType(varSymbol->variableType());
@@ -267,11 +305,20 @@ void MemberCallExpressionAST::typeCheck(TypeChecker& checker) {
 }
 
 std::shared_ptr<Type> MemberCallExpressionAST::expressionType(const TypeChecker& checker) const {
+	if (rectangularLengthDimension(checker) >= 0) {
+		return checker.findType("Int");
+	}
+
 	return mMemberCallExpression->expressionType(checker);
 }
 
 void MemberCallExpressionAST::verify(SemanticVerifier& verifier) {
 	mAccessExpression->verify(verifier);
+
+	if (rectangularLengthDimension(verifier.typeChecker()) >= 0) {
+		return;
+	}
+
 	mMemberCallExpression->verify(verifier);
 
 	auto accessModifier = mMemberCallExpression->funcSignature(verifier.typeChecker())->accessModifier();
@@ -287,6 +334,14 @@ void MemberCallExpressionAST::verify(SemanticVerifier& verifier) {
 
 void MemberCallExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
 	mAccessExpression->generateCode(codeGen, func);
+
+	int dim = rectangularLengthDimension(codeGen.typeChecker());
+	if (dim >= 0) {
+		auto arrayType = std::dynamic_pointer_cast<RectangularArrayType>(mAccessExpression->expressionType(codeGen.typeChecker()));
+		func.addInstruction("LDFIELD " + arrayType->vmClassName() + "::" + arrayType->lengthField(dim));
+		return;
+	}
+
 	auto classType = std::dynamic_pointer_cast<ClassType>(mAccessExpression->expressionType(codeGen.typeChecker()));
 	mMemberCallExpression->generateMemberCallCode(codeGen, func, classType);
 }
@@ -336,15 +391,9 @@ void SetFieldValueAST::rewrite(Compiler& compiler) {
 		mMemberExpression = std::dynamic_pointer_cast<ExpressionAST>(newMember);
 	}
 
-	std::shared_ptr<AbstractSyntaxTree> newRHS;
-
-	if (mRightHandSide->rewriteAST(newRHS, compiler)) {
-		mRightHandSide = std::dynamic_pointer_cast<ExpressionAST>(newRHS);
-	}
-
 	mObjectRefExpression->rewrite(compiler);
 	mMemberExpression->rewrite(compiler);
-	mRightHandSide->rewrite(compiler);
+	AST::rewriteTree(mRightHandSide, compiler);
 }
 
 std::string SetFieldValueAST::getMemberName() const {
@@ -373,7 +422,9 @@ void SetFieldValueAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTab
 	mRightHandSide->generateSymbols(binder, symbolTable);
 
 	if (arrayMember != nullptr) {
-		arrayMember->accessExpression()->generateSymbols(binder, symbolTable);
+		for (auto accessExpr : arrayMember->accessExpressions()) {
+			accessExpr->generateSymbols(binder, symbolTable);
+		}
 	}
 }
 
@@ -426,8 +477,18 @@ void SetFieldValueAST::typeCheck(TypeChecker& checker) {
 	//Check rhs
 	std::shared_ptr<Type> fieldType;
 
-	if (std::dynamic_pointer_cast<ArrayAccessAST>(mMemberExpression)) {
-		fieldType = std::dynamic_pointer_cast<ArrayType>(object.getField(memberName).type())->elementType();
+	if (auto arrayMember = std::dynamic_pointer_cast<ArrayAccessAST>(mMemberExpression)) {
+		for (auto accessExpr : arrayMember->accessExpressions()) {
+			accessExpr->typeCheck(checker);
+		}
+
+		ArrayAccessAST::typeCheckAccess(
+			checker,
+			object.getField(memberName).type(),
+			arrayMember->accessExpressions(),
+			mMemberExpression->asString());
+
+		fieldType = ArrayAccessAST::elementType(object.getField(memberName).type());
 	} else {
 		fieldType = object.getField(memberName).type();
 	}
@@ -474,7 +535,7 @@ void SetFieldValueAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& f
 	if (auto arrayMember = std::dynamic_pointer_cast<ArrayAccessAST>(mMemberExpression)) {
 		mObjectRefExpression->generateCode(codeGen, func);
 		func.addInstruction("LDFIELD " + objRefType->vmClassName() + "::" + memberName);
-		arrayMember->accessExpression()->generateCode(codeGen, func);
+		ArrayAccessAST::generateIndex(codeGen, func, getField(checker).type(), arrayMember->accessExpressions());
 
 		mRightHandSide->generateCode(codeGen, func);
 		func.addInstruction("STELEM " + mRightHandSide->expressionType(codeGen.typeChecker())->vmType());
@@ -61,6 +61,9 @@ class MemberCallExpressionAST : public ExpressionAST {
 private:	
 	std::shared_ptr<ExpressionAST> mAccessExpression;
 	std::shared_ptr<CallExpressionAST> mMemberCallExpression;
+
+	//Returns the dimension if the call is 'length(<dimension>)' on a rectangular array, else -1
+	int rectangularLengthDimension(const TypeChecker& checker) const;
 public:
 	//Creates a new member call expression AST
 	MemberCallExpressionAST(std::shared_ptr<ExpressionAST> accessExpression, std::shared_ptr<CallExpressionAST> memberCallExpression);
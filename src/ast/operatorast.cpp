@@ -14,6 +14,10 @@
 #include "../symbol.h"
 #include "../semantics.h"
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
 //Binary OP expression AST
 std::set<std::string> BinaryOpExpressionAST::arithmeticTypes = {
 	TypeSystem::toString(PrimitiveTypes::Int),
@@ -62,18 +66,230 @@ void BinaryOpExpressionAST::visit(VisitFn visitFn) const {
 }
 
 void BinaryOpExpressionAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newLHS;
-	while (mLeftHandSide->rewriteAST(newLHS, compiler)) {
-		mLeftHandSide = std::dynamic_pointer_cast<ExpressionAST>(newLHS);
+	AST::rewriteTree(mLeftHandSide, compiler);
+	AST::rewriteTree(mRightHandSide, compiler);
+}
+
+namespace {
+	//Indicates if the given expression is the given integer constant
+	bool isIntConstant(std::shared_ptr<ExpressionAST> expression, int value) {
+		auto intExpr = std::dynamic_pointer_cast<IntegerExpressionAST>(expression);
+		return intExpr != nullptr && intExpr->value() == value;
+	}
+
+	//Indicates if the given expression is the given float constant
+	bool isFloatConstant(std::shared_ptr<ExpressionAST> expression, float value) {
+		auto floatExpr = std::dynamic_pointer_cast<FloatExpressionAST>(expression);
+		return floatExpr != nullptr && floatExpr->value() == value && std::signbit(floatExpr->value()) == std::signbit(value);
+	}
+
+	//Performs the given integer operation with the wrap around semantics of the VM
+	int wrapIntOp(int x, int y, char op) {
+		auto ux = (std::uint32_t)x;
+		auto uy = (std::uint32_t)y;
+		std::uint32_t res = 0;
+
+		switch (op) {
+			case '+':
+				res = ux + uy;
+				break;
+			case '-':
+				res = ux - uy;
+				break;
+			case '*':
+				res = ux * uy;
+				break;
+		}
+
+		return (int)(std::int32_t)res;
 	}
+}
+
+bool BinaryOpExpressionAST::foldConstants(std::shared_ptr<AbstractSyntaxTree>& newAST) const {
+	//Integer constants
+	auto lhsInt = std::dynamic_pointer_cast<IntegerExpressionAST>(mLeftHandSide);
+	auto rhsInt = std::dynamic_pointer_cast<IntegerExpressionAST>(mRightHandSide);
+
+	if (lhsInt != nullptr && rhsInt != nullptr) {
+		int x = lhsInt->value();
+		int y = rhsInt->value();
+
+		if (mOp == Operator('+') || mOp == Operator('-') || mOp == Operator('*')) {
+			newAST = std::make_shared<IntegerExpressionAST>(wrapIntOp(x, y, mOp.op1()));
+			return true;
+		} else if (mOp == Operator('/')) {
+			//Division by zero and overflowing divisions are left for the VM to handle
+			if (y == 0 || (x == std::numeric_limits<int>::min() && y == -1)) {
+				return false;
+			}
+
+			newAST = std::make_shared<IntegerExpressionAST>(x / y);
+			return true;
+		} else if (mOp == Operator('=', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x == y);
+			return true;
+		} else if (mOp == Operator('!', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x != y);
+			return true;
+		} else if (mOp == Operator('<')) {
+			newAST = std::make_shared<BoolExpressionAST>(x < y);
+			return true;
+		} else if (mOp == Operator('<', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x <= y);
+			return true;
+		} else if (mOp == Operator('>')) {
+			newAST = std::make_shared<BoolExpressionAST>(x > y);
+			return true;
+		} else if (mOp == Operator('>', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x >= y);
+			return true;
+		}
+
+		return false;
+	}
+
+	//Float constants
+	auto lhsFloat = std::dynamic_pointer_cast<FloatExpressionAST>(mLeftHandSide);
+	auto rhsFloat = std::dynamic_pointer_cast<FloatExpressionAST>(mRightHandSide);
+
+	if (lhsFloat != nullptr && rhsFloat != nullptr) {
+		float x = lhsFloat->value();
+		float y = rhsFloat->value();
+		float res = 0.0f;
+
+		if (mOp == Operator('+')) {
+			res = x + y;
+		} else if (mOp == Operator('-')) {
+			res = x - y;
+		} else if (mOp == Operator('*')) {
+			res = x * y;
+		} else if (mOp == Operator('/')) {
+			if (y == 0.0f) {
+				return false;
+			}
+
+			res = x / y;
+		} else if (mOp == Operator('=', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x == y);
+			return true;
+		} else if (mOp == Operator('!', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x != y);
+			return true;
+		} else if (mOp == Operator('<')) {
+			newAST = std::make_shared<BoolExpressionAST>(x < y);
+			return true;
+		} else if (mOp == Operator('<', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x <= y);
+			return true;
+		} else if (mOp == Operator('>')) {
+			newAST = std::make_shared<BoolExpressionAST>(x > y);
+			return true;
+		} else if (mOp == Operator('>', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x >= y);
+			return true;
+		} else {
+			return false;
+		}
+
+		//Infinities and NaNs can't be represented as literals
+		if (!std::isfinite(res)) {
+			return false;
+		}
+
+		newAST = std::make_shared<FloatExpressionAST>(res);
+		return true;
+	}
+
+	//Bool constants
+	auto lhsBool = std::dynamic_pointer_cast<BoolExpressionAST>(mLeftHandSide);
+	auto rhsBool = std::dynamic_pointer_cast<BoolExpressionAST>(mRightHandSide);
+
+	if (lhsBool != nullptr && rhsBool != nullptr) {
+		bool x = lhsBool->value();
+		bool y = rhsBool->value();
+
+		if (mOp == Operator('=', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x == y);
+			return true;
+		} else if (mOp == Operator('!', '=')) {
+			newAST = std::make_shared<BoolExpressionAST>(x != y);
+			return true;
+		} else if (mOp == Operator('&', '&')) {
+			newAST = std::make_shared<BoolExpressionAST>(x && y);
+			return true;
+		} else if (mOp == Operator('|', '|')) {
+			newAST = std::make_shared<BoolExpressionAST>(x || y);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool BinaryOpExpressionAST::simplify(std::shared_ptr<AbstractSyntaxTree>& newAST) const {
+	//Only identities that keep the evaluation of the non-constant operand are applied
+	if (mOp == Operator('+')) {
+		if (isIntConstant(mRightHandSide, 0)) {
+			newAST = mLeftHandSide;
+			return true;
+		}
+
+		if (isIntConstant(mLeftHandSide, 0)) {
+			newAST = mRightHandSide;
+			return true;
+		}
+	} else if (mOp == Operator('-')) {
+		//x - (+0.0) is x for all floats, but x + 0.0 is not (-0.0 + 0.0 = +0.0)
+		if (isIntConstant(mRightHandSide, 0) || isFloatConstant(mRightHandSide, 0.0f)) {
+			newAST = mLeftHandSide;
+			return true;
+		}
+	} else if (mOp == Operator('*')) {
+		if (isIntConstant(mRightHandSide, 1) || isFloatConstant(mRightHandSide, 1.0f)) {
+			newAST = mLeftHandSide;
+			return true;
+		}
 
-	std::shared_ptr<AbstractSyntaxTree> newRHS;
-	while (mRightHandSide->rewriteAST(newRHS, compiler)) {
-		mRightHandSide = std::dynamic_pointer_cast<ExpressionAST>(newRHS);
+		if (isIntConstant(mLeftHandSide, 1) || isFloatConstant(mLeftHandSide, 1.0f)) {
+			newAST = mRightHandSide;
+			return true;
+		}
+	} else if (mOp == Operator('/')) {
+		if (isIntConstant(mRightHandSide, 1) || isFloatConstant(mRightHandSide, 1.0f)) {
+			newAST = mLeftHandSide;
+			return true;
+		}
+	} else if (mOp == Operator('&', '&')) {
+		auto lhsBool = std::dynamic_pointer_cast<BoolExpressionAST>(mLeftHandSide);
+		auto rhsBool = std::dynamic_pointer_cast<BoolExpressionAST>(mRightHandSide);
+
+		if (lhsBool != nullptr) {
+			//The rhs is never evaluated if the lhs is false
+			newAST = lhsBool->value() ? mRightHandSide : mLeftHandSide;
+			return true;
+		}
+
+		if (rhsBool != nullptr && rhsBool->value()) {
+			newAST = mLeftHandSide;
+			return true;
+		}
+	} else if (mOp == Operator('|', '|')) {
+		auto lhsBool = std::dynamic_pointer_cast<BoolExpressionAST>(mLeftHandSide);
+		auto rhsBool = std::dynamic_pointer_cast<BoolExpressionAST>(mRightHandSide);
+
+		if (lhsBool != nullptr) {
+			//The rhs is never evaluated if the lhs is true
+			newAST = lhsBool->value() ? mLeftHandSide : mRightHandSide;
+			return true;
+		}
+
+		if (rhsBool != nullptr && !rhsBool->value()) {
+			newAST = mLeftHandSide;
+			return true;
+		}
 	}
 
-	mLeftHandSide->rewrite(compiler);
-	mRightHandSide->rewrite(compiler);
+	return false;
 }
 
 bool BinaryOpExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
@@ -117,7 +333,7 @@ bool BinaryOpExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newA
 	if (arraySetElem != nullptr && mOp == Operator('=')) {
 		newAST = std::make_shared<ArraySetElementAST>(
 			arraySetElem->arrayRefExpression(),
-			arraySetElem->accessExpression(),
+			arraySetElem->accessExpressions(),
 			mRightHandSide);
 
 		return true;
@@ -170,6 +386,10 @@ bool BinaryOpExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newA
 		}
 	}
 
+	if (compiler.isOptimizing()) {
+		return foldConstants(newAST) || simplify(newAST);
+	}
+
 	return false;
 }
 
@@ -187,10 +407,13 @@ void BinaryOpExpressionAST::typeCheck(TypeChecker& checker) {
 	auto rhsType = mRightHandSide->expressionType(checker);
 
 	if (lhsType->name() != "Auto") {
-		checker.assertSameType(
-			*lhsType, 
-			*rhsType,
-			asString());
+		//Only create the error message when needed, as it is linear in the size of the expression
+		if (*lhsType != *rhsType) {
+			checker.assertSameType(
+				*lhsType,
+				*rhsType,
+				asString());
+		}
 	} else {
 		//Infer the type
 		auto lhsVarDec = std::dynamic_pointer_cast<VariableDeclarationExpressionAST>(mLeftHandSide);
@@ -213,6 +436,9 @@ void BinaryOpExpressionAST::typeCheck(TypeChecker& checker) {
 			checker.typeError("Auto type is only allowed in variable declaration.");
 		}
 	}
+
+	//The operands are now type checked, cache the type to avoid walking the whole expression for each use
+	mExpressionType = expressionType(checker);
 }
 
 void BinaryOpExpressionAST::verify(SemanticVerifier& verifier) {
@@ -263,6 +489,10 @@ void BinaryOpExpressionAST::verify(SemanticVerifier& verifier) {
 }
 
 std::shared_ptr<Type> BinaryOpExpressionAST::expressionType(const TypeChecker& checker) const {
+	if (mExpressionType != nullptr) {
+		return mExpressionType;
+	}
+
 	auto& boolTypes = checker.operators().binaryOpReturnTypes();
 
 	if (boolTypes.count(mOp) > 0) {
@@ -325,44 +555,42 @@ void BinaryOpExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFuncti
 	} else if(mOp == Operator('<', '=')) {
 		generateSidesCode(codeGen, func);
 		func.addInstruction("CMPLE");
-	} else if(mOp == Operator('&', '&')) {
-		//Generate with short circuit
+	} else if((mOp == Operator('&', '&') || mOp == Operator('|', '|')) && !codeGen.isOptimizing()) {
+		//Generate with short circuit, where each operator compares the value of its left hand side against true
+		bool isAnd = mOp == Operator('&', '&');
 		int resLocal = func.newLocal("$tmp$_" + std::to_string(func.numLocals()), codeGen.typeChecker().findType("Bool"));
 
 		mLeftHandSide->generateCode(codeGen, func);
 		func.addInstruction("LDTRUE");
 		int branchIndex = func.numInstructions();
-		func.addInstruction("BNE ");
+		func.addInstruction(isAnd ? "BNE" : "BEQ");
 
 		mRightHandSide->generateCode(codeGen, func);
 		func.addStoreLocal(resLocal);
 
 		int skipIndex = func.numInstructions();
-		func.addInstruction("BR ");
-		func.instruction(branchIndex) += std::to_string(func.numInstructions());
-		func.addInstruction("LDFALSE");
+		func.addInstruction("BR");
+		func.setBranchTargets({ branchIndex }, func.numInstructions());
+		func.addInstruction(isAnd ? "LDFALSE" : "LDTRUE");
 		func.addStoreLocal(resLocal);
-		func.instruction(skipIndex) += std::to_string(func.numInstructions());
+		func.setBranchTargets({ skipIndex }, func.numInstructions());
 
 		func.addLoadLocal(resLocal);
-	} else if(mOp == Operator('|', '|')) {
+	} else if(mOp == Operator('&', '&') || mOp == Operator('|', '|')) {
 		//Generate with short circuit
 		int resLocal = func.newLocal("$tmp$_" + std::to_string(func.numLocals()), codeGen.typeChecker().findType("Bool"));
 
-		mLeftHandSide->generateCode(codeGen, func);
+		std::vector<int> falseBranches;
+		generateConditionCode(codeGen, func, false, falseBranches);
 		func.addInstruction("LDTRUE");
-		int branchIndex = func.numInstructions();
-		func.addInstruction("BEQ ");
-
-		mRightHandSide->generateCode(codeGen, func);
 		func.addStoreLocal(resLocal);
 
 		int skipIndex = func.numInstructions();
-		func.addInstruction("BR ");
-		func.instruction(branchIndex) += std::to_string(func.numInstructions());
-		func.addInstruction("LDTRUE");
+		func.addInstruction("BR");
+		func.setBranchTargets(falseBranches, func.numInstructions());
+		func.addInstruction("LDFALSE");
 		func.addStoreLocal(resLocal);
-		func.instruction(skipIndex) += std::to_string(func.numInstructions());
+		func.setBranchTargets({ skipIndex }, func.numInstructions());
 
 		func.addLoadLocal(resLocal);
 	} else {
@@ -370,6 +598,45 @@ void BinaryOpExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFuncti
 	}
 }
 
+namespace {
+	//The branch instruction for each compare operator
+	const std::map<Operator, std::pair<std::string, std::string>> compareBranches = {
+		{ Operator('<'), { "BLT", "BGE" } },
+		{ Operator('>'), { "BGT", "BLE" } },
+		{ Operator('<', '='), { "BLE", "BGT" } },
+		{ Operator('>', '='), { "BGE", "BLT" } },
+		{ Operator('=', '='), { "BEQ", "BNE" } },
+		{ Operator('!', '='), { "BNE", "BEQ" } }
+	};
+}
+
+void BinaryOpExpressionAST::generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches) {
+	//Without optimizations, only comparisons branch directly
+	if ((mOp == Operator('&', '&') || mOp == Operator('|', '|')) && codeGen.isOptimizing()) {
+		//For 'a && b', branch if false when any operand is false, and if true when both are true.
+		//For 'a || b', branch if true when any operand is true, and if false when both are false.
+		bool shortCircuitValue = mOp == Operator('|', '|');
+
+		if (branchIf == shortCircuitValue) {
+			mLeftHandSide->generateConditionCode(codeGen, func, branchIf, branches);
+			mRightHandSide->generateConditionCode(codeGen, func, branchIf, branches);
+		} else {
+			std::vector<int> skipBranches;
+			mLeftHandSide->generateConditionCode(codeGen, func, shortCircuitValue, skipBranches);
+			mRightHandSide->generateConditionCode(codeGen, func, branchIf, branches);
+			func.setBranchTargets(skipBranches, func.numInstructions());
+		}
+	} else if (compareBranches.count(mOp) > 0) {
+		generateSidesCode(codeGen, func);
+		branches.push_back(func.numInstructions());
+
+		auto& branchInsts = compareBranches.at(mOp);
+		func.addInstruction(branchIf ? branchInsts.first : branchInsts.second);
+	} else {
+		ExpressionAST::generateConditionCode(codeGen, func, branchIf, branches);
+	}
+}
+
 //Unary OP expression AST
 UnaryOpExpressionAST::UnaryOpExpressionAST(std::shared_ptr<ExpressionAST> operand, Operator op)
 	: mOperand(operand), mOp(op) {
@@ -393,6 +660,10 @@ void UnaryOpExpressionAST::visit(VisitFn visitFn) const {
 	visitFn(this);
 }
 
+void UnaryOpExpressionAST::rewrite(Compiler& compiler) {
+	AST::rewriteTree(mOperand, compiler);
+}
+
 bool UnaryOpExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
 	//Rewrite -constant as a constant expression
 	if (mOp == Operator('-')) {
@@ -411,6 +682,27 @@ bool UnaryOpExpressionAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAS
 		}
 	}
 
+	if (compiler.isOptimizing()) {
+		auto operandOp = std::dynamic_pointer_cast<UnaryOpExpressionAST>(mOperand);
+
+		if (mOp == Operator('!')) {
+			auto boolExpr = std::dynamic_pointer_cast<BoolExpressionAST>(mOperand);
+
+			if (boolExpr != nullptr) {
+				newAST = std::make_shared<BoolExpressionAST>(!boolExpr->value());
+				return true;
+			}
+		}
+
+		//!!x = x and --x = x. Floats are not simplified as -(-0.0 - 0.0) is not -0.0
+		if (operandOp != nullptr && operandOp->op() == mOp) {
+			if (mOp == Operator('!') || (mOp == Operator('-') && mExpressionType != nullptr && mExpressionType->name() == "Int")) {
+				newAST = operandOp->operand();
+				return true;
+			}
+		}
+	}
+
 	return false;
 }
 
@@ -429,6 +721,8 @@ void UnaryOpExpressionAST::typeCheck(TypeChecker& checker) {
 	} else if (mOp == Operator('-') && opType != checker.findType("Int") && opType != checker.findType("Float")) {
 		checker.typeError("The '-' operator can only be applied to values/variables of type 'Int' or 'Float'.");
 	}
+
+	mExpressionType = opType;
 }
 
 void UnaryOpExpressionAST::verify(SemanticVerifier& verifier) {
@@ -436,6 +730,10 @@ void UnaryOpExpressionAST::verify(SemanticVerifier& verifier) {
 }
 
 std::shared_ptr<Type> UnaryOpExpressionAST::expressionType(const TypeChecker& checker) const {
+	if (mExpressionType != nullptr) {
+		return mExpressionType;
+	}
+
 	return mOperand->expressionType(checker);
 }
 
@@ -455,4 +753,12 @@ void UnaryOpExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunctio
 		mOperand->generateCode(codeGen, func);
 		func.addInstruction("NOT");
 	}
+}
+
+void UnaryOpExpressionAST::generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches) {
+	if (mOp == Operator('!') && codeGen.isOptimizing()) {
+		mOperand->generateConditionCode(codeGen, func, !branchIf, branches);
+	} else {
+		ExpressionAST::generateConditionCode(codeGen, func, branchIf, branches);
+	}
 }
\ No newline at end of file
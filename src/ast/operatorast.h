@@ -17,6 +17,7 @@ private:
 	std::shared_ptr<ExpressionAST> mLeftHandSide;
 	std::shared_ptr<ExpressionAST> mRightHandSide;
 	Operator mOp;
+	std::shared_ptr<Type> mExpressionType;
 
 	static std::set<std::string> arithmeticTypes;
 	static std::set<std::string> equalityTypes;
@@ -25,6 +26,12 @@ private:
 
 	//Generates the code for lhs and rhs
 	void generateSidesCode(CodeGenerator& codeGen, GeneratedFunction& func);
+
+	//Evaluates the operator if both operands are constants
+	bool foldConstants(std::shared_ptr<AbstractSyntaxTree>& newAST) const;
+
+	//Applies algebraic identities such as x + 0 = x
+	bool simplify(std::shared_ptr<AbstractSyntaxTree>& newAST) const;
 public:
 	//Creates a new binary operator expression
 	BinaryOpExpressionAST(std::shared_ptr<ExpressionAST> leftHandSide, std::shared_ptr<ExpressionAST> rightHandSide, Operator op);
@@ -55,6 +62,7 @@ public:
 	virtual std::shared_ptr<Type> expressionType(const TypeChecker& checker) const override; 
 
 	virtual void generateCode(CodeGenerator& codeGen, GeneratedFunction& func) override;
+	virtual void generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches) override;
 };
 
 //Represents a unary operator expression 
@@ -62,6 +70,7 @@ class UnaryOpExpressionAST : public ExpressionAST {
 private:
 	std::shared_ptr<ExpressionAST> mOperand;
 	Operator mOp;
+	std::shared_ptr<Type> mExpressionType;
 public:
 	//Creates a new unary operator expression
 	UnaryOpExpressionAST(std::shared_ptr<ExpressionAST> operand, Operator op);
@@ -75,6 +84,8 @@ public:
 	std::string asString() const override;
 
 	virtual void visit(VisitFn visitFn) const override;
+
+	virtual void rewrite(Compiler& compiler) override;
 	
 	virtual bool rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const override;
 
@@ -87,4 +98,5 @@ public:
 	virtual std::shared_ptr<Type> expressionType(const TypeChecker& checker) const override; 
 
 	virtual void generateCode(CodeGenerator& codeGen, GeneratedFunction& func) override;
+	virtual void generateConditionCode(CodeGenerator& codeGen, GeneratedFunction& func, bool branchIf, std::vector<int>& branches) override;
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "variableast.h"
 #include "blockast.h"
 #include "operatorast.h"
+#include "expressionast.h"
+#include "../compiler.h"
 #include "../typechecker.h"
 #include "../symboltable.h"
 #include "../type.h"
@@ -27,13 +29,7 @@ void ExpressionStatementAST::visit(VisitFn visitFn) const {
 }
 
 void ExpressionStatementAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newAST;
-
-	while (mExpression->rewriteAST(newAST, compiler)) {
-		mExpression = std::dynamic_pointer_cast<ExpressionAST>(newAST);
-	}
-
-	mExpression->rewrite(compiler);
+	AST::rewriteTree(mExpression, compiler);
 }
 
 void ExpressionStatementAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
@@ -89,14 +85,8 @@ void ReturnStatementAST::visit(VisitFn visitFn) const {
 }
 
 void ReturnStatementAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newAST;
-
-	while (mReturnExpression != nullptr && mReturnExpression->rewriteAST(newAST, compiler)) {
-		mReturnExpression = std::dynamic_pointer_cast<ExpressionAST>(newAST);
-	}
-
 	if (mReturnExpression != nullptr) {
-		mReturnExpression->rewrite(compiler);
+		AST::rewriteTree(mReturnExpression, compiler);
 	}
 }
 
@@ -123,11 +113,18 @@ void ReturnStatementAST::verify(SemanticVerifier& verifier) {
 void ReturnStatementAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
 	if (mReturnExpression != nullptr) {
 		mReturnExpression->generateCode(codeGen, func);
-		func.addInstruction("STLOC " + std::to_string(func.getLocal(CodeGenerator::returnValueLocal).first));
 	}
 
-	func.addReturnBranch(func.numInstructions());
-	func.addInstruction("BR");
+	if (codeGen.isOptimizing()) {
+		func.addInstruction("RET");
+	} else {
+		if (mReturnExpression != nullptr) {
+			func.addStoreLocal(func.getLocal(CodeGenerator::returnValueLocal).first);
+		}
+
+		func.addReturnBranch(func.numInstructions());
+		func.addInstruction("BR");
+	}
 }
 
 //If & else statement AST
@@ -164,11 +161,9 @@ void IfElseStatementAST::visit(VisitFn visitFn) const {
 }
 
 void IfElseStatementAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newAST;
+	AST::rewriteTree(mConditionExpression, compiler);
 
-	while (mConditionExpression->rewriteAST(newAST, compiler)) {
-		mConditionExpression = std::dynamic_pointer_cast<ExpressionAST>(newAST);
-	}
+	std::shared_ptr<AbstractSyntaxTree> newAST;
 
 	while (mThenBlock->rewriteAST(newAST, compiler)) {
 		mThenBlock = std::dynamic_pointer_cast<BlockAST>(newAST);
@@ -178,7 +173,6 @@ void IfElseStatementAST::rewrite(Compiler& compiler) {
 		mElseBlock = std::dynamic_pointer_cast<BlockAST>(newAST);
 	}
 
-	mConditionExpression->rewrite(compiler);
 	mThenBlock->rewrite(compiler);
 
 	if (mElseBlock != nullptr) {
@@ -186,6 +180,25 @@ void IfElseStatementAST::rewrite(Compiler& compiler) {
 	}
 }
 
+bool IfElseStatementAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
+	//Remove the branch that is never taken
+	if (compiler.isOptimizing()) {
+		if (auto boolExpr = std::dynamic_pointer_cast<BoolExpressionAST>(mConditionExpression)) {
+			if (boolExpr->value()) {
+				newAST = mThenBlock;
+			} else if (mElseBlock != nullptr) {
+				newAST = mElseBlock;
+			} else {
+				newAST = std::make_shared<BlockAST>(std::vector<std::shared_ptr<StatementAST>>());
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void IfElseStatementAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
 	AbstractSyntaxTree::generateSymbols(binder, symbolTable);
 
@@ -219,61 +232,14 @@ void IfElseStatementAST::verify(SemanticVerifier& verifier) {
 	}
 }
 
-void generateBranch(std::shared_ptr<BinaryOpExpressionAST> binOpExpr, CodeGenerator& codeGen, GeneratedFunction& func, int& condIndex) {
-	auto op = binOpExpr->op();
-
-	if (op == Operator('<')) {
-		binOpExpr->leftHandSide()->generateCode(codeGen, func);
-		binOpExpr->rightHandSide()->generateCode(codeGen, func);
-		condIndex = func.numInstructions();
-		func.addInstruction("BGE");
-	} else if (op == Operator('>')) {
-		binOpExpr->leftHandSide()->generateCode(codeGen, func);
-		binOpExpr->rightHandSide()->generateCode(codeGen, func);
-		condIndex = func.numInstructions();
-		func.addInstruction("BLE");
-	} else if (op == Operator('<', '=')) {
-		binOpExpr->leftHandSide()->generateCode(codeGen, func);
-		binOpExpr->rightHandSide()->generateCode(codeGen, func);
-		condIndex = func.numInstructions();
-		func.addInstruction("BGT");
-	} else if (op == Operator('>', '=')) {
-		binOpExpr->leftHandSide()->generateCode(codeGen, func);
-		binOpExpr->rightHandSide()->generateCode(codeGen, func);
-		condIndex = func.numInstructions();
-		func.addInstruction("BLT");
-	} else if (op == Operator('=', '=')) {
-		binOpExpr->leftHandSide()->generateCode(codeGen, func);
-		binOpExpr->rightHandSide()->generateCode(codeGen, func);
-		condIndex = func.numInstructions();
-		func.addInstruction("BNE");
-	} else if (op == Operator('!', '=')) {
-		binOpExpr->leftHandSide()->generateCode(codeGen, func);
-		binOpExpr->rightHandSide()->generateCode(codeGen, func);
-		condIndex = func.numInstructions();
-		func.addInstruction("BEQ");
-	}
-}
-
 void IfElseStatementAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
-	int condIndex = -1;
-
-	//If simple expression, use branch instructions
-	if (auto binOpExpr = std::dynamic_pointer_cast<BinaryOpExpressionAST>(mConditionExpression)) {
-		generateBranch(binOpExpr, codeGen, func, condIndex);
+	if (mConditionExpression->expressionType(codeGen.typeChecker())->name() != "Bool") {
+		codeGen.codeGenError("The condition must be a boolean expression.");
 	}
 
-	//Else use compare & jump instructions
-	if (condIndex == -1) {
-		if (mConditionExpression->expressionType(codeGen.typeChecker())->name() == "Bool") {
-			mConditionExpression->generateCode(codeGen, func);
-			func.addInstruction("LDTRUE");
-			condIndex = func.numInstructions();
-			func.addInstruction("BNE");
-		} else {
-			codeGen.codeGenError("The condition must be a boolean expression.");
-		}
-	}
+	//Branch to the else block if the condition is false
+	std::vector<int> elseBranches;
+	mConditionExpression->generateConditionCode(codeGen, func, false, elseBranches);
 
 	mThenBlock->generateCode(codeGen, func);
 	int elseIndex = -1;
@@ -283,7 +249,7 @@ void IfElseStatementAST::generateCode(CodeGenerator& codeGen, GeneratedFunction&
 		func.addInstruction("BR");
 	}
 
-	func.instruction(condIndex) += " " + std::to_string(func.numInstructions());
+	func.setBranchTargets(elseBranches, func.numInstructions());
 
 	if (mElseBlock != nullptr) {
 		mElseBlock->generateCode(codeGen, func);
@@ -316,20 +282,31 @@ void WhileLoopStatementAST::visit(VisitFn visitFn) const {
 }
 
 void WhileLoopStatementAST::rewrite(Compiler& compiler) {
-	std::shared_ptr<AbstractSyntaxTree> newAST;
+	AST::rewriteTree(mConditionExpression, compiler);
 
-	while (mConditionExpression->rewriteAST(newAST, compiler)) {
-		mConditionExpression = std::dynamic_pointer_cast<ExpressionAST>(newAST);
-	}
+	std::shared_ptr<AbstractSyntaxTree> newAST;
 
 	while (mBodyBlock->rewriteAST(newAST, compiler)) {
 		mBodyBlock = std::dynamic_pointer_cast<BlockAST>(newAST);
 	}
 
-	mConditionExpression->rewrite(compiler);
 	mBodyBlock->rewrite(compiler);
 }
 
+bool WhileLoopStatementAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
+	//Remove loops that are never entered
+	if (compiler.isOptimizing()) {
+		auto boolExpr = std::dynamic_pointer_cast<BoolExpressionAST>(mConditionExpression);
+
+		if (boolExpr != nullptr && !boolExpr->value()) {
+			newAST = std::make_shared<BlockAST>(std::vector<std::shared_ptr<StatementAST>>());
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void WhileLoopStatementAST::generateSymbols(Binder& binder, std::shared_ptr<SymbolTable> symbolTable) {
 	AbstractSyntaxTree::generateSymbols(binder, symbolTable);
 
@@ -348,30 +325,28 @@ void WhileLoopStatementAST::verify(SemanticVerifier& verifier) {
 }
 
 void WhileLoopStatementAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
-	int condStart = func.numInstructions();
-	int condIndex = -1;
-
-	//If simple expression, use branch instructions
-	if (auto binOpExpr = std::dynamic_pointer_cast<BinaryOpExpressionAST>(mConditionExpression)) {
-		generateBranch(binOpExpr, codeGen, func, condIndex);
+	if (mConditionExpression->expressionType(codeGen.typeChecker())->name() != "Bool") {
+		codeGen.codeGenError("The condition must be a boolean expression.");
 	}
 
-	//Else use compare & jump instructions
-	if (condIndex == -1) {
-		if (mConditionExpression->expressionType(codeGen.typeChecker())->name() == "Bool") {
-			mConditionExpression->generateCode(codeGen, func);
-			func.addInstruction("LDTRUE");
-			condIndex = func.numInstructions();
-			func.addInstruction("BNE");
-		} else {
-			codeGen.codeGenError("The condition must be a boolean expression.");
-		}
-	}
+	//The condition is tested before entering the loop, and then at the end of each iteration.
+	//Without optimizations, each iteration branches back to the test instead.
+	int conditionStart = func.numInstructions();
+	std::vector<int> exitBranches;
+	mConditionExpression->generateConditionCode(codeGen, func, false, exitBranches);
 
+	int bodyStart = func.numInstructions();
 	mBodyBlock->generateCode(codeGen, func);
-	func.addInstruction("BR " + std::to_string(condStart));
 
-	func.instruction(condIndex) += " " + std::to_string(func.numInstructions());
+	if (codeGen.isOptimizing()) {
+		std::vector<int> loopBranches;
+		mConditionExpression->generateConditionCode(codeGen, func, true, loopBranches);
+		func.setBranchTargets(loopBranches, bodyStart);
+	} else {
+		func.addInstruction("BR " + std::to_string(conditionStart));
+	}
+
+	func.setBranchTargets(exitBranches, func.numInstructions());
 }
 
 //For loop statement AST
@@ -402,7 +377,7 @@ std::string ForLoopStatementAST::asString() const {
 	return "for (" + mInitExpression->asString() + "; " + mConditionExpression->asString() + "; " + mChangeExpression->asString() + ") " + mBodyBlock->asString();
 }
 
-bool ForLoopStatementAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& compiler) const {
+bool ForLoopStatementAST::rewriteAST(std::shared_ptr<AbstractSyntaxTree>& newAST, Compiler& /*compiler*/) const {
 	auto bodyStatements = mBodyBlock->statements();
 	bodyStatements.push_back(std::make_shared<ExpressionStatementAST>(mChangeExpression));
 
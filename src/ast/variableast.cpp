@@ -77,7 +77,7 @@ std::shared_ptr<Type> VariableReferenceExpressionAST::expressionType(const TypeC
 	}
 }
 
-void VariableReferenceExpressionAST::generateCode(CodeGenerator& codeGen, GeneratedFunction& func) {
+void VariableReferenceExpressionAST::generateCode(CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 	auto varRefSymbol = std::dynamic_pointer_cast<VariableSymbol>(mSymbolTable->find(name()));
 	bool isFuncParam = varRefSymbol->attribute() == VariableSymbolAttribute::FUNCTION_PARAMETER;
 	bool isThis = varRefSymbol->attribute() == VariableSymbolAttribute::THIS_REFERENCE;
@@ -7,8 +7,32 @@
 #include "typechecker.h"
 #include "typename.h"
 #include "symbol.h"
+#include "passmanager.h"
 
 #include <stdexcept>
+#include <set>
+#include <algorithm>
+#include <limits>
+
+//Instructions
+namespace {
+	//The branch instructions
+	const std::set<std::string> branchInstructions = { "BR", "BEQ", "BNE", "BGT", "BGE", "BLT", "BLE" };
+}
+
+std::pair<std::string, std::string> Instructions::split(const std::string& instruction) {
+	auto opCodeEnd = instruction.find(' ');
+
+	if (opCodeEnd != std::string::npos) {
+		return { instruction.substr(0, opCodeEnd), instruction.substr(opCodeEnd + 1) };
+	} else {
+		return { instruction, "" };
+	}
+}
+
+bool Instructions::isBranch(const std::string& opCode) {
+	return branchInstructions.count(opCode) > 0;
+}
 
 //Function parameter
 FunctionParameter::FunctionParameter(std::string name, std::shared_ptr<Type> type)
@@ -23,18 +47,82 @@ FunctionParameter::FunctionParameter()
 
 //Generated function
 GeneratedFunction::GeneratedFunction(std::string functionName, std::vector<FunctionParameter> parameters, std::shared_ptr<Type> returnType,
-									 bool isMemberFunction, AccessModifiers accessModifier)
+									 bool isMemberFunction, AccessModifiers accessModifier, std::vector<std::string> attributes)
 	: mFunctionName(functionName),
 	  mParameters(parameters),
 	  mReturnType(returnType),
 	  mIsMemberFunction(isMemberFunction),
-	  mAccessModifier(accessModifier) {
+	  mAccessModifier(accessModifier),
+	  mAttributes(attributes),
+	  mEffects(FunctionEffects::SideEffecting) {
 
 }
 
 GeneratedFunction::GeneratedFunction()
-	: mFunctionName(""), mReturnType(nullptr) {
+	: mFunctionName(""), mReturnType(nullptr), mEffects(FunctionEffects::SideEffecting) {
+
+}
+
+std::string GeneratedFunction::name() const {
+	return mFunctionName;
+}
+
+std::string GeneratedFunction::signature() const {
+	std::string signature = mFunctionName + "(";
+	bool isFirst = true;
+
+	//The object reference is not part of the signature
+	for (std::size_t i = mIsMemberFunction ? 1 : 0; i < mParameters.size(); i++) {
+		if (!isFirst) {
+			signature += " ";
+		} else {
+			isFirst = false;
+		}
+
+		signature += mParameters[i].type->vmType();
+	}
+
+	return signature + ")";
+}
+
+const std::vector<FunctionParameter>& GeneratedFunction::parameters() const {
+	return mParameters;
+}
+
+std::shared_ptr<Type> GeneratedFunction::returnType() const {
+	return mReturnType;
+}
+
+bool GeneratedFunction::isMemberFunction() const {
+	return mIsMemberFunction;
+}
+
+std::string GeneratedFunction::className() const {
+	if (mIsMemberFunction) {
+		return mFunctionName.substr(0, mFunctionName.find("::"));
+	} else {
+		return "";
+	}
+}
+
+AccessModifiers GeneratedFunction::accessModifier() const {
+	return mAccessModifier;
+}
+
+const std::vector<std::string>& GeneratedFunction::attributes() const {
+	return mAttributes;
+}
+
+bool GeneratedFunction::hasAttribute(std::string name) const {
+	return std::find(mAttributes.begin(), mAttributes.end(), name) != mAttributes.end();
+}
+
+FunctionEffects GeneratedFunction::effects() const {
+	return mEffects;
+}
 
+void GeneratedFunction::setEffects(FunctionEffects effects) {
+	mEffects = effects;
 }
 
 int GeneratedFunction::numLocals() const {
@@ -47,10 +135,17 @@ const std::map<std::string, std::pair<int, std::shared_ptr<Type>>>& GeneratedFun
 
 int GeneratedFunction::newLocal(std::string name, std::shared_ptr<Type> type) {
 	int index = numLocals();
-	mLocals.insert({ name, { index, type } });
+	if (!mLocals.insert({ name, { index, type } }).second) {
+		throw std::logic_error("The local '" + name + "' is already defined.");
+	}
+
 	return index;
 }
 
+void GeneratedFunction::replaceLocals(const std::map<std::string, Local>& locals) {
+	mLocals = locals;
+}
+
 int GeneratedFunction::newLocal(std::shared_ptr<VariableSymbol> symbol, std::shared_ptr<Type> type) {
 	return newLocal("$" + symbol->scopeName() + "$_" + symbol->name(), type);
 }
@@ -97,68 +192,79 @@ std::string& GeneratedFunction::instruction(int index) {
 	return mInstructions.at(index);
 }
 
+void GeneratedFunction::setBranchTargets(const std::vector<int>& branches, int target) {
+	for (auto branch : branches) {
+		instruction(branch) += " " + std::to_string(target);
+	}
+}
+
+const std::vector<std::string>& GeneratedFunction::instructions() const {
+	return mInstructions;
+}
+
+void GeneratedFunction::replaceInstructions(const std::vector<std::string>& instructions) {
+	mInstructions = instructions;
+}
+
 void GeneratedFunction::addReturnBranch(int index) {
 	mReturnBranches.push_back(index);
 }
 
-void GeneratedFunction::outputGeneratedCode(std::ostream& os) {
-	bool isFirst = true;
-
-	if (!mIsMemberFunction) {
-		os << "func " << mFunctionName << "(";
-	} else {
-		os << "member " << mFunctionName << "(";
-	}
+void GeneratedFunction::addEndReturn() {
+	setBranchTargets(mReturnBranches, numInstructions());
 
-	int arg = 0;
-	for (auto param : mParameters) {
-		if (mIsMemberFunction && arg == 0) {
-			arg++;
-			continue;
+	if (mReturnType->name() != "Void") {
+		//Without return branches, the local is never assigned and contains the default value
+		if (mLocals.count(CodeGenerator::returnValueLocal) == 0) {
+			newLocal(CodeGenerator::returnValueLocal, mReturnType);
 		}
 
-		if (!isFirst) {
-			os << " ";
-		} else {
-			isFirst = false;
-		}
+		addLoadLocal(getLocal(CodeGenerator::returnValueLocal).first);
+	}
 
-		os << param.type->vmType();
-		arg++;
+	addInstruction("RET");
+}
+
+void GeneratedFunction::outputGeneratedCode(std::ostream& os) {
+	if (!mIsMemberFunction) {
+		os << "func ";
+	} else {
+		os << "member ";
 	}
 
-	os << ") " << mReturnType->vmType() << std::endl;
+	os << signature() << " " << mReturnType->vmType() << std::endl;
 	os << "{";
 
 	if (mIsMemberFunction) {
 		os << std::endl << "   @AccessModifier(value=" << mAccessModifier << ")";
 	}
 
-	if (mLocals.size() > 0) {
-		os << std::endl << "   .locals " << mLocals.size() << std::endl;
-
-		for (auto local : mLocals) {
-			os << "   .local " << local.second.first << " " << local.second.second->vmType() << std::endl;
-		}
+	if (mEffects == FunctionEffects::Pure) {
+		os << std::endl << "   @Pure()";
+	} else if (mEffects == FunctionEffects::ReadOnly) {
+		os << std::endl << "   @ReadOnly()";
 	}
 
-	//Handle return
-	int returnInst = mInstructions.size();
-	auto genInstructions = mInstructions;
-
-	if (mReturnType->name() != "Void") {
-		genInstructions.push_back("LDLOC " + std::to_string(getLocal(CodeGenerator::returnValueLocal).first));
-	}
+	if (mLocals.size() > 0) {
+		//Locals can share index
+		std::set<int> localIndices;
+		for (auto& local : mLocals) {
+			localIndices.insert(local.second.first);
+		}
 
-	genInstructions.push_back("RET");
+		os << std::endl << "   .locals " << localIndices.size() << std::endl;
 
-	for (auto returnBranch : mReturnBranches) {
-		genInstructions[returnBranch] += " " + std::to_string(returnInst);
+		std::set<int> outputtedIndices;
+		for (auto local : mLocals) {
+			if (outputtedIndices.insert(local.second.first).second) {
+				os << "   .local " << local.second.first << " " << local.second.second->vmType() << std::endl;
+			}
+		}
 	}
 
-	isFirst = false;
+	bool isFirst = false;
 	int i = 0;
-	for (auto inst : genInstructions) {
+	for (auto inst : mInstructions) {
 		if (!isFirst) {
 			os << std::endl;
 		} else {
@@ -204,16 +310,251 @@ void GeneratedClass::outputGeneratedCode(std::ostream& os) {
 }
 
 //Code generator
-CodeGenerator::CodeGenerator(const TypeChecker& typeChecker)
-	: mTypeChecker(typeChecker) {
+CodeGenerator::CodeGenerator(const TypeChecker& typeChecker, Statistics& statistics)
+	: mTypeChecker(typeChecker),
+	  mInstructionInfo(typeChecker),
+	  mPeepholeOptimizer(statistics),
+	  mTailCallEliminator(statistics),
+	  mInliner(statistics),
+	  mScalarReplacer(mInstructionInfo, statistics),
+	  mTreeShaker(statistics),
+	  mSpecializer(mInstructionInfo, mTreeShaker, statistics),
+	  mEffectAnalyzer(mInstructionInfo, statistics),
+	  mDeadCodeEliminator(mInstructionInfo, statistics),
+	  mLoopOptimizer(mInstructionInfo, statistics),
+	  mSubexpressionEliminator(mInstructionInfo, statistics),
+	  mSSAOptimizer(mInstructionInfo, statistics),
+	  mLocalAllocator(statistics),
+	  mIsOptimizing(true) {
 
 }
 
 const TypeChecker& CodeGenerator::typeChecker() const {
 	return mTypeChecker;
 }
-	
+
+bool CodeGenerator::isOptimizing() const {
+	return mIsOptimizing;
+}
+
+void CodeGenerator::setOptimizing(bool isOptimizing) {
+	mIsOptimizing = isOptimizing;
+}
+
+InstructionInfo& CodeGenerator::instructionInfo() {
+	return mInstructionInfo;
+}
+
+LoopOptimizer& CodeGenerator::loopOptimizer() {
+	return mLoopOptimizer;
+}
+
+TreeShaker& CodeGenerator::treeShaker() {
+	return mTreeShaker;
+}
+
+std::vector<GeneratedFunction>& CodeGenerator::functions() {
+	return mFunctions;
+}
+
+void CodeGenerator::definePasses(PassManager& passManager) {
+	//Simplify the functions before inlining, as the size decides if a function is inlined
+	passManager.addFunctionPass("simplify", 1, { "codegen" }, [&](GeneratedFunction& function) {
+		mPeepholeOptimizer.optimize(function);
+	});
+
+	passManager.addFunctionPass("tailcalls", 1, { "simplify" }, [&](GeneratedFunction& function) {
+		mTailCallEliminator.eliminate(function);
+	});
+
+	passManager.addModulePass("specialize", 2, { "tailcalls" }, [&]() {
+		mSpecializer.specialize(mFunctions);
+	});
+
+	passManager.addModulePass("inline", 2, { "specialize" }, [&]() {
+		mInliner.inlineFunctions(mFunctions, mClasses);
+	});
+
+	//Objects only escape through calls until their member functions are inlined
+	passManager.addModulePass("scalars", 2, { "inline" }, [&]() {
+		mScalarReplacer.replace(mFunctions, mClasses);
+	});
+
+	//Inlined functions are often no longer called
+	passManager.addModulePass("shake", 1, { "scalars" }, [&]() {
+		mTreeShaker.shake(mFunctions, mClasses);
+	});
+
+	//The effects are emitted as attributes, and tell the later optimizations which calls cannot write memory
+	passManager.addModulePass("effects", 1, { "shake" }, [&]() {
+		mEffectAnalyzer.analyze(mFunctions);
+	});
+
+	passManager.addFunctionPass("peephole", 1, { "effects" }, [&](GeneratedFunction& function) {
+		mPeepholeOptimizer.optimize(function);
+	});
+
+	passManager.addFunctionPass("dce", 1, { "peephole" }, [&](GeneratedFunction& function) {
+		mDeadCodeEliminator.eliminate(function);
+	});
+
+	passManager.addFunctionPass("loops", 2, { "dce" }, [&](GeneratedFunction& function) {
+		mLoopOptimizer.optimize(function);
+	});
+
+	passManager.addFunctionPass("cse", 2, { "loops" }, [&](GeneratedFunction& function) {
+		mSubexpressionEliminator.eliminate(function);
+	});
+
+	passManager.addFunctionPass("ssa", 1, { "cse" }, [&](GeneratedFunction& function) {
+		mSSAOptimizer.optimize(function);
+	});
+
+	passManager.addFunctionPass("locals", 1, { "ssa" }, [&](GeneratedFunction& function) {
+		mLocalAllocator.allocate(function);
+	});
+
+	//Sharing slots can create redundant moves
+	passManager.addFunctionPass("cleanup", 1, { "locals" }, [&](GeneratedFunction& function) {
+		mPeepholeOptimizer.optimize(function);
+	});
+}
+
+GeneratedFunction& CodeGenerator::newGeneratedFunction(std::string name, std::vector<FunctionParameter> parameters,
+													  std::shared_ptr<Type> returnType, bool isMemberFunction) {
+	mFunctions.push_back(GeneratedFunction(name, parameters, returnType, isMemberFunction, AccessModifiers::Public));
+	auto& func = mFunctions[mFunctions.size() - 1];
+	mInstructionInfo.defineFunction(func.signature(), func.returnType());
+	return func;
+}
+
+void CodeGenerator::generateRectangularArrayFunctions(std::shared_ptr<RectangularArrayType> arrayType) {
+	//The VM has no instruction to raise an error, so the errors are raised by invalid array operations
+	auto intType = mTypeChecker.findType("Int");
+	int rank = arrayType->rank();
+
+	//The size function checks the lengths and computes the number of elements
+	std::vector<FunctionParameter> sizeParameters;
+	for (int dim = 0; dim < rank; dim++) {
+		sizeParameters.push_back(FunctionParameter("length" + std::to_string(dim), intType));
+	}
+
+	auto& sizeFunc = newGeneratedFunction(arrayType->sizeFunctionName(), sizeParameters, intType);
+	int sizeLocal = sizeFunc.newLocal("size", intType);
+
+	for (int dim = 0; dim < rank; dim++) {
+		sizeFunc.addInstruction("LDARG " + std::to_string(dim));
+		sizeFunc.addInstruction("LDINT 0");
+		sizeFunc.addInstruction("BGE");
+		int validBranch = sizeFunc.numInstructions() - 1;
+
+		//Fails with a negative array length
+		sizeFunc.addInstruction("LDARG " + std::to_string(dim));
+		sizeFunc.addInstruction("NEWARR Int");
+		sizeFunc.addInstruction("POP");
+		sizeFunc.setBranchTargets({ validBranch }, sizeFunc.numInstructions());
+	}
+
+	sizeFunc.addInstruction("LDARG 0");
+	sizeFunc.addStoreLocal(sizeLocal);
+
+	for (int dim = 1; dim < rank; dim++) {
+		//The size overflows if it is greater than the maximum size divided by the length
+		std::vector<int> validBranches;
+		sizeFunc.addInstruction("LDARG " + std::to_string(dim));
+		sizeFunc.addInstruction("LDINT 0");
+		sizeFunc.addInstruction("BEQ");
+		validBranches.push_back(sizeFunc.numInstructions() - 1);
+
+		sizeFunc.addLoadLocal(sizeLocal);
+		sizeFunc.addInstruction("LDINT " + std::to_string(std::numeric_limits<int>::max()));
+		sizeFunc.addInstruction("LDARG " + std::to_string(dim));
+		sizeFunc.addInstruction("DIV");
+		sizeFunc.addInstruction("BLE");
+		validBranches.push_back(sizeFunc.numInstructions() - 1);
+
+		//Fails with a negative array length, as the size is not representable
+		sizeFunc.addInstruction("LDINT -1");
+		sizeFunc.addInstruction("NEWARR Int");
+		sizeFunc.addInstruction("POP");
+		sizeFunc.setBranchTargets(validBranches, sizeFunc.numInstructions());
+
+		sizeFunc.addLoadLocal(sizeLocal);
+		sizeFunc.addInstruction("LDARG " + std::to_string(dim));
+		sizeFunc.addInstruction("MUL");
+		sizeFunc.addStoreLocal(sizeLocal);
+	}
+
+	sizeFunc.addLoadLocal(sizeLocal);
+	sizeFunc.addInstruction("RET");
+}
+
+void CodeGenerator::generateRectangularArrays() {
+	std::vector<std::shared_ptr<RectangularArrayType>> arrayTypes;
+
+	for (auto& type : mTypeChecker.types()) {
+		if (auto arrayType = std::dynamic_pointer_cast<RectangularArrayType>(type.second)) {
+			arrayTypes.push_back(arrayType);
+		}
+	}
+
+	std::sort(arrayTypes.begin(), arrayTypes.end(), [](std::shared_ptr<RectangularArrayType> x, std::shared_ptr<RectangularArrayType> y) {
+		return x->name() < y->name();
+	});
+
+	//The size function is shared by the arrays of the same rank
+	std::set<int> ranks;
+
+	for (auto arrayType : arrayTypes) {
+		if (ranks.insert(arrayType->rank()).second) {
+			generateRectangularArrayFunctions(arrayType);
+		}
+	}
+
+	for (auto arrayType : arrayTypes) {
+		auto className = arrayType->vmClassName();
+		auto intType = mTypeChecker.findType("Int");
+
+		std::unordered_map<std::string, Field> fields;
+		fields[RectangularArrayType::elementsField] = Field(RectangularArrayType::elementsField, arrayType->elementsType());
+
+		std::vector<FunctionParameter> parameters;
+		parameters.push_back(FunctionParameter("this", arrayType));
+
+		for (int dim = 0; dim < arrayType->rank(); dim++) {
+			fields[arrayType->lengthField(dim)] = Field(arrayType->lengthField(dim), intType);
+			parameters.push_back(FunctionParameter("length" + std::to_string(dim), intType));
+		}
+
+		mClasses.push_back(GeneratedClass(className, Object(className, arrayType, fields)));
+
+		//The constructor stores the lengths and allocates the elements
+		auto& constructor = newGeneratedFunction(className + "::.constructor", parameters, mTypeChecker.findType("Void"), true);
+		std::string sizeParameters = "";
+
+		for (int dim = 0; dim < arrayType->rank(); dim++) {
+			constructor.addInstruction("LDARG 0");
+			constructor.addInstruction("LDARG " + std::to_string(dim + 1));
+			constructor.addInstruction("STFIELD " + className + "::" + arrayType->lengthField(dim));
+			sizeParameters += (dim > 0 ? " " : "") + intType->vmType();
+		}
+
+		constructor.addInstruction("LDARG 0");
+
+		for (int dim = 0; dim < arrayType->rank(); dim++) {
+			constructor.addInstruction("LDARG " + std::to_string(dim + 1));
+		}
+
+		constructor.addInstruction("CALL " + arrayType->sizeFunctionName() + "(" + sizeParameters + ")");
+		constructor.addInstruction("NEWARR " + arrayType->elementType()->vmType());
+		constructor.addInstruction("STFIELD " + className + "::" + RectangularArrayType::elementsField);
+		constructor.addInstruction("RET");
+	}
+}
+
 void CodeGenerator::generateProgram(std::shared_ptr<ProgramAST> programAST) {
+	generateRectangularArrays();
+
 	programAST->visitClasses([&](std::shared_ptr<ClassDefinitionAST> classDef) {
 		mClasses.push_back(GeneratedClass(classDef->fullName("."), mTypeChecker.getObject(classDef->fullName())));
 		auto classType = mTypeChecker.findType(classDef->fullName())->name();
@@ -232,19 +573,20 @@ void CodeGenerator::generateProgram(std::shared_ptr<ProgramAST> programAST) {
 				parameters,
 				memberFunc->prototype()->returnType());
 
-			auto& genFunc = newFunction(memberFuncPrototype, true, memberFunc->accessModifier());
+			auto& genFunc = newFunction(memberFuncPrototype, true, memberFunc->accessModifier(), memberFunc->attributes());
 			memberFunc->generateCode(*this, genFunc);
 		}
 	});
 
 	programAST->visitFunctions([&](std::shared_ptr<FunctionAST> func) {
-		auto& genFunc = newFunction(func->prototype());
+		auto& genFunc = newFunction(func->prototype(), false, AccessModifiers::Public, func->attributes());
 		func->generateCode(*this, genFunc);
 	});
 }
 
 GeneratedFunction& CodeGenerator::newFunction(std::shared_ptr<FunctionPrototypeAST> functionPrototype,
-											  bool isMemberFunction, AccessModifiers accessModifier) {
+											  bool isMemberFunction, AccessModifiers accessModifier,
+											  std::vector<std::string> attributes) {
 	std::vector<FunctionParameter> parameters;
 
 	for (auto param : functionPrototype->parameters()) {
@@ -256,38 +598,41 @@ GeneratedFunction& CodeGenerator::newFunction(std::shared_ptr<FunctionPrototypeA
 		parameters,
 		mTypeChecker.findType(functionPrototype->returnType()),
 		isMemberFunction,
-		accessModifier));
+		accessModifier,
+		attributes));
 
-	auto& newFunc = mFunctions[mFunctions.size() - 1];
+	auto& func = mFunctions[mFunctions.size() - 1];
+	mInstructionInfo.defineFunction(func.signature(), func.returnType());
 
-	if (functionPrototype->returnType() != "Void") {
-		newFunc.newLocal(CodeGenerator::returnValueLocal, mTypeChecker.findType(functionPrototype->returnType()));
+	//The return statements store the value in the return local and branch to the end of the function
+	if (!mIsOptimizing && functionPrototype->returnType() != "Void") {
+		func.newLocal(CodeGenerator::returnValueLocal, mTypeChecker.findType(functionPrototype->returnType()));
 	}
 
-	return newFunc;
+	return func;
 }
 
-void CodeGenerator::printGeneratedCode() {
+void CodeGenerator::printGeneratedCode(std::ostream& os) {
 	bool isFirst = true;
 
 	for (auto classDef : mClasses) {
 		if (!isFirst) {
-			std::cout << std::endl;
+			os << std::endl;
 		} else {
 			isFirst = false;
 		}
 
-		classDef.outputGeneratedCode(std::cout);
+		classDef.outputGeneratedCode(os);
 	}
 
 	for (auto func : mFunctions) {
 		if (!isFirst) {
-			std::cout << std::endl;
+			os << std::endl;
 		} else {
 			isFirst = false;
 		}
 
-		func.outputGeneratedCode(std::cout);
+		func.outputGeneratedCode(os);
 	}
 }
 
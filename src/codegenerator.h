@@ -1,5 +1,18 @@
 #pragma once
 #include "object.h"
+#include "peephole.h"
+#include "localallocator.h"
+#include "inliner.h"
+#include "tailcalleliminator.h"
+#include "instructioninfo.h"
+#include "loopoptimizer.h"
+#include "subexpressioneliminator.h"
+#include "ssaoptimizer.h"
+#include "deadcodeeliminator.h"
+#include "treeshaker.h"
+#include "specializer.h"
+#include "effectanalyzer.h"
+#include "scalarreplacer.h"
 
 #include <map>
 #include <vector>
@@ -11,11 +24,23 @@
 class FunctionPrototypeAST;
 class ProgramAST;
 class Type;
+class RectangularArrayType;
 class TypeChecker;
 class VariableSymbol;
+class Statistics;
+class PassManager;
 
 using Local = std::pair<int, std::shared_ptr<Type>>;
 
+//Contains functions for generated instructions
+namespace Instructions {
+	//Splits the given instruction into op code and operand
+	std::pair<std::string, std::string> split(const std::string& instruction);
+
+	//Indicates if the given op code is a branch
+	bool isBranch(const std::string& opCode);
+}
+
 //Represents a function parameter
 struct FunctionParameter {
 	const std::string name;
@@ -34,6 +59,8 @@ private:
 	std::shared_ptr<Type> mReturnType;
 	bool mIsMemberFunction;
 	AccessModifiers mAccessModifier;
+	std::vector<std::string> mAttributes;
+	FunctionEffects mEffects;
 
 	std::map<std::string, Local> mLocals;
 	std::vector<std::string> mInstructions;
@@ -41,17 +68,53 @@ private:
 public:
 	//Creates a new generated function
 	GeneratedFunction(std::string functionName, std::vector<FunctionParameter> parameters, std::shared_ptr<Type> returnType,
-					  bool isMemberFunction, AccessModifiers accessModifier);
+					  bool isMemberFunction, AccessModifiers accessModifier, std::vector<std::string> attributes = {});
 	GeneratedFunction();
 
+	//Returns the name of the function
+	std::string name() const;
+
+	//Returns the signature, which is the name used when calling the function
+	std::string signature() const;
+
+	//Returns the parameters. For member functions, the first one is the object reference.
+	const std::vector<FunctionParameter>& parameters() const;
+
+	//Returns the return type
+	std::shared_ptr<Type> returnType() const;
+
+	//Indicates if the function is a member function
+	bool isMemberFunction() const;
+
+	//Returns the name of the class for member functions
+	std::string className() const;
+
+	//Returns the access modifier
+	AccessModifiers accessModifier() const;
+
+	//Returns the attributes
+	const std::vector<std::string>& attributes() const;
+
+	//Indicates if the function has the given attribute
+	bool hasAttribute(std::string name) const;
+
+	//Returns the effects, which are emitted as attributes
+	FunctionEffects effects() const;
+
+	//Sets the effects
+	void setEffects(FunctionEffects effects);
+
 	//Returns the number of locals
 	int numLocals() const;
 
 	const std::map<std::string, std::pair<int, std::shared_ptr<Type>>>& locals() const;
 
-	//Creates a new local
+	//Creates a new local. The name must not already be defined.
 	int newLocal(std::string name, std::shared_ptr<Type> type);
 
+	//Replaces the locals. Multiple locals can share the same index.
+	void replaceLocals(const std::map<std::string, Local>& locals);
+
 	//Creates a new local
 	int newLocal(std::shared_ptr<VariableSymbol> symbol, std::shared_ptr<Type> type);
 
@@ -79,9 +142,22 @@ public:
 	//Returns the instruction at the given index
 	std::string& instruction(int index);
 
+	//Sets the target of the given branch instructions
+	void setBranchTargets(const std::vector<int>& branches, int target);
+
+	//Returns the instructions
+	const std::vector<std::string>& instructions() const;
+
+	//Replaces the instructions
+	void replaceInstructions(const std::vector<std::string>& instructions);
+
 	//Adds the instruction at the given index to the list of return branches
 	void addReturnBranch(int index);
 
+	//Adds the return at the end of the function, which is the target of the return branches.
+	//Non-void functions return the value of the return local, which is the default value of the return type if never assigned.
+	void addEndReturn();
+
 	//Outputs the generated code to the given stream
 	void outputGeneratedCode(std::ostream& os);
 };
@@ -112,26 +188,72 @@ private:
 	std::vector<GeneratedClass> mClasses;
 	std::vector<GeneratedFunction> mFunctions;
 	const TypeChecker& mTypeChecker;
+	InstructionInfo mInstructionInfo;
+	PeepholeOptimizer mPeepholeOptimizer;
+	TailCallEliminator mTailCallEliminator;
+	Inliner mInliner;
+	ScalarReplacer mScalarReplacer;
+	TreeShaker mTreeShaker;
+	Specializer mSpecializer;
+	EffectAnalyzer mEffectAnalyzer;
+	DeadCodeEliminator mDeadCodeEliminator;
+	LoopOptimizer mLoopOptimizer;
+	SubexpressionEliminator mSubexpressionEliminator;
+	SSAOptimizer mSSAOptimizer;
+	LocalAllocator mLocalAllocator;
+	bool mIsOptimizing;
+
+	//Creates a new function that is not defined in the program
+	GeneratedFunction& newGeneratedFunction(std::string name, std::vector<FunctionParameter> parameters,
+											std::shared_ptr<Type> returnType, bool isMemberFunction = false);
+
+	//Generates the size function shared by the rectangular arrays of the same rank as the given type
+	void generateRectangularArrayFunctions(std::shared_ptr<RectangularArrayType> arrayType);
+
+	//Generates the classes of the rectangular array types, and their constructors
+	void generateRectangularArrays();
 public:
-	//Creates a new type checker
-	CodeGenerator(const TypeChecker& typeChecker);
+	//Creates a new code generator
+	CodeGenerator(const TypeChecker& typeChecker, Statistics& statistics);
 
 	//Returns the type checker
 	const TypeChecker& typeChecker() const;
 
+	//Indicates if optimized code is generated. Otherwise, the code is generated as before the optimizations were added.
+	bool isOptimizing() const;
+
+	//Sets if optimized code is generated
+	void setOptimizing(bool isOptimizing);
+
+	//Returns information about the generated instructions
+	InstructionInfo& instructionInfo();
+
+	//Returns the loop optimizer
+	LoopOptimizer& loopOptimizer();
+
+	//Returns the tree shaker
+	TreeShaker& treeShaker();
+
+	//Returns the generated functions
+	std::vector<GeneratedFunction>& functions();
+
+	//Adds the passes optimizing the generated functions to the given pass manager
+	void definePasses(PassManager& passManager);
+
 	//Generates the program
 	void generateProgram(std::shared_ptr<ProgramAST> programAST);
 
 	//Creates a new function
 	GeneratedFunction& newFunction(std::shared_ptr<FunctionPrototypeAST> functionPrototype,
-								   bool isMemberFunction = false, AccessModifiers accessModifier = AccessModifiers::Public);
+								   bool isMemberFunction = false, AccessModifiers accessModifier = AccessModifiers::Public,
+								   std::vector<std::string> attributes = {});
 
-	//Prints the generated code
-	void printGeneratedCode();
+	//Prints the generated code to the given stream
+	void printGeneratedCode(std::ostream& os = std::cout);
 
 	//Indicates that a code gen error has occurred
 	void codeGenError(std::string errorMessage);
 
-	//The name of the return value local
+	//The name of the local holding the default return value
 	static std::string returnValueLocal;
 };
\ No newline at end of file
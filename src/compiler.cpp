@@ -6,17 +6,23 @@
 #include <fstream>
 
 Compiler::Compiler(
+	std::unique_ptr<Statistics> statistics,
 	std::unique_ptr<OperatorContainer> operators, 
 	std::unique_ptr<Binder> binder,
 	std::unique_ptr<TypeChecker> typeChecker, 
 	std::unique_ptr<SemanticVerifier> semanticVerifier,
 	std::unique_ptr<CodeGenerator> codeGenerator) :
 		mLexer(operators->operatorChars(), operators->twoCharOpChars()),
+		mStatistics(std::move(statistics)),
 		mOperators(std::move(operators)),
 		mBinder(std::move(binder)),
 		mTypeChecker(std::move(typeChecker)),
 		mSemanticVerifier(std::move(semanticVerifier)),
-		mCodeGenerator(std::move(codeGenerator)) {
+		mCodeGenerator(std::move(codeGenerator)),
+		mPassManager(new PassManager),
+		mEvaluator(new Evaluator(*mTypeChecker.get(), *mStatistics.get())),
+		mIsOptimizing(false),
+		mIsEvaluating(false) {
 
 }
 
@@ -47,6 +53,8 @@ Compiler Compiler::create() {
 			{ Operator('&', '&'), boolType }, { Operator('|', '|'), boolType },
 		}));
 
+	auto statistics = std::unique_ptr<Statistics>(new Statistics);
+
 	auto binder = std::unique_ptr<Binder>(new Binder);
 
 	auto typeChecker = std::unique_ptr<TypeChecker>(new TypeChecker(
@@ -59,21 +67,23 @@ Compiler Compiler::create() {
 		*typeChecker.get()));
 
 	auto codeGenerator = std::unique_ptr<CodeGenerator>(new CodeGenerator(
-		*typeChecker.get()));
+		*typeChecker.get(),
+		*statistics.get()));
 
 	//Add default objects
 	typeChecker->addObject(Object("Array", nullptr, { { "length", Field("length", intType) } }));
 
 	//Add conversions
-	typeChecker->defineExplicitConversion(floatType, intType, [](CodeGenerator& codeGen, GeneratedFunction& func) {
+	typeChecker->defineExplicitConversion(floatType, intType, [](CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 		func.addInstruction("CONVFLOATTOINT");
 	});
 
-	typeChecker->defineExplicitConversion(intType, floatType, [](CodeGenerator& codeGen, GeneratedFunction& func) {
+	typeChecker->defineExplicitConversion(intType, floatType, [](CodeGenerator& /*codeGen*/, GeneratedFunction& func) {
 		func.addInstruction("CONVINTTOFLOAT");
 	});
 
 	return Compiler(
+		std::move(statistics),
 		std::move(operators),
 		std::move(binder),
 		std::move(typeChecker),
@@ -105,9 +115,29 @@ CodeGenerator& Compiler::codeGenerator() {
 	return *mCodeGenerator.get();
 }
 
+Statistics& Compiler::statistics() {
+	return *mStatistics.get();
+}
+
+PassManager& Compiler::passManager() {
+	return *mPassManager.get();
+}
+
+Evaluator& Compiler::evaluator() {
+	return *mEvaluator.get();
+}
+
+bool Compiler::isOptimizing() const {
+	return mIsOptimizing;
+}
+
+bool Compiler::isEvaluating() const {
+	return mIsEvaluating;
+}
+
 void Compiler::load(std::vector<std::string> libraries) {
 	//Load the runtime library
-	Loader loader(binder(), typeChecker());
+	Loader loader(binder(), typeChecker(), codeGenerator().instructionInfo());
 	std::fstream nativeLibText("../StackJIT/rtlib/native.sbc");
 	loader.loadAssembly(nativeLibText);
 
@@ -129,15 +159,56 @@ void Compiler::load(std::vector<std::string> libraries) {
 	}
 }
 
-void Compiler::process(std::shared_ptr<ProgramAST> programAST) {
-	programAST->rewrite(*this);
-	mBinder->generateSymbolTable(programAST);
+void Compiler::definePasses() {
+	mPassManager->addProgramPass("rewrite", 0, {}, [&](std::shared_ptr<ProgramAST> programAST) {
+		programAST->rewrite(*this);
+	});
+
+	mPassManager->addProgramPass("symbols", 0, { "rewrite" }, [&](std::shared_ptr<ProgramAST> programAST) {
+		mBinder->generateSymbolTable(programAST);
+	});
+
+	mPassManager->addProgramPass("resolve", 0, { "symbols" }, [&](std::shared_ptr<ProgramAST> programAST) {
+		programAST->rewrite(*this);
+	});
+
+	mPassManager->addProgramPass("typecheck", 0, { "resolve" }, [&](std::shared_ptr<ProgramAST> programAST) {
+		programAST->typeCheck(*mTypeChecker.get());
+	});
 
-	programAST->rewrite(*this);
+	mPassManager->addProgramPass("verify", 0, { "typecheck" }, [&](std::shared_ptr<ProgramAST> programAST) {
+		programAST->verify(*mSemanticVerifier.get());
+	});
 
-	programAST->typeCheck(*mTypeChecker.get());
-	programAST->verify(*mSemanticVerifier.get());
+	//The program is now valid, apply optimizations such as constant folding
+	mPassManager->addProgramPass("fold", 1, { "verify" }, [&](std::shared_ptr<ProgramAST> programAST) {
+		mIsOptimizing = true;
+		programAST->rewrite(*this);
+		mIsOptimizing = false;
+	});
 
-	mCodeGenerator->generateProgram(programAST);
+	//Calls with constant arguments are evaluated after folding, and the results are folded further
+	mPassManager->addProgramPass("evaluate", 2, { "fold" }, [&](std::shared_ptr<ProgramAST> programAST) {
+		mEvaluator->findFunctions(programAST);
+		mIsOptimizing = true;
+		mIsEvaluating = true;
+		programAST->rewrite(*this);
+		mIsEvaluating = false;
+		mIsOptimizing = false;
+		mEvaluator->clear();
+	});
+
+	mPassManager->addProgramPass("codegen", 0, { "verify", "fold", "evaluate" }, [&](std::shared_ptr<ProgramAST> programAST) {
+		mCodeGenerator->setOptimizing(mPassManager->optimizationLevel() > 0);
+		mCodeGenerator->generateProgram(programAST);
+	});
+
+	mCodeGenerator->definePasses(*mPassManager.get());
+}
+
+void Compiler::process(std::shared_ptr<ProgramAST> programAST) {
+	//The passes refer to the compiler, so they are added when it is no longer moved
+	definePasses();
+	mPassManager->run(programAST, *mCodeGenerator.get());
 	mCodeGenerator->printGeneratedCode();
-}
\ No newline at end of file
+}
@@ -5,6 +5,9 @@
 #include "semantics.h"
 #include "typechecker.h"
 #include "lexer.h"
+#include "statistics.h"
+#include "passmanager.h"
+#include "evaluator.h"
 #include <memory>
 
 class ProgramAST;
@@ -13,19 +16,28 @@ class ProgramAST;
 class Compiler {
 private:
 	Lexer mLexer;
+	std::unique_ptr<Statistics> mStatistics;
 	std::unique_ptr<OperatorContainer> mOperators;
 	std::unique_ptr<Binder> mBinder;
 	std::unique_ptr<TypeChecker> mTypeChecker;
 	std::unique_ptr<SemanticVerifier> mSemanticVerifier;
 	std::unique_ptr<CodeGenerator> mCodeGenerator;
+	std::unique_ptr<PassManager> mPassManager;
+	std::unique_ptr<Evaluator> mEvaluator;
+	bool mIsOptimizing;
+	bool mIsEvaluating;
 
 	//Creates a new compiler
 	Compiler(
+		std::unique_ptr<Statistics> statistics,
 		std::unique_ptr<OperatorContainer> operators,
 		std::unique_ptr<Binder> binder,
 		std::unique_ptr<TypeChecker> typeChecker,
 		std::unique_ptr<SemanticVerifier> semanticVerifier,
 		std::unique_ptr<CodeGenerator> codeGenerator);
+
+	//Adds the passes of the compiler to the pass manager
+	void definePasses();
 public:
 	//Creates a new compiler
 	static Compiler create();
@@ -48,6 +60,21 @@ public:
 	//Returns the code generator
 	CodeGenerator& codeGenerator();
 
+	//Returns the statistics
+	Statistics& statistics();
+
+	//Returns the pass manager
+	PassManager& passManager();
+
+	//Returns the evaluator
+	Evaluator& evaluator();
+
+	//Indicates if the current rewrite pass is the optimization pass, which runs after type checking
+	bool isOptimizing() const;
+
+	//Indicates if the current rewrite pass evaluates calls with constant arguments
+	bool isEvaluating() const;
+
 	//Loads libraries
 	void load(std::vector<std::string> libraries = {});
 
@@ -0,0 +1,211 @@
+#include "deadcodeeliminator.h"
+#include "codegenerator.h"
+#include "instructioninfo.h"
+#include "localallocator.h"
+#include "peephole.h"
+#include "statistics.h"
+
+#include <map>
+#include <algorithm>
+
+DeadCodeEliminator::DeadCodeEliminator(const InstructionInfo& instructionInfo, Statistics& statistics)
+	: mInstructionInfo(instructionInfo), mStatistics(statistics) {
+	mStatistics.add("dce.unreachable", 0);
+	mStatistics.add("dce.dead-stores", 0);
+	mStatistics.add("dce.pure-values", 0);
+	mStatistics.add("dce.unused-locals", 0);
+}
+
+bool DeadCodeEliminator::removeUnreachable(GeneratedFunction& function) {
+	PeepholeFunction peepholeFunc(function);
+	std::vector<bool> isReachable(peepholeFunc.size(), false);
+	std::vector<int> worklist = { 0 };
+
+	while (!worklist.empty()) {
+		int index = worklist.back();
+		worklist.pop_back();
+
+		if (index >= peepholeFunc.size() || isReachable[index]) {
+			continue;
+		}
+
+		isReachable[index] = true;
+		auto& inst = peepholeFunc.at(index);
+
+		if (inst.isBranch()) {
+			worklist.push_back(inst.target);
+		}
+
+		if (!inst.endsBlock()) {
+			worklist.push_back(index + 1);
+		}
+	}
+
+	int numRemoved = 0;
+
+	for (int i = 0; i < peepholeFunc.size(); i++) {
+		if (!isReachable[i]) {
+			peepholeFunc.at(i).isDeleted = true;
+			numRemoved++;
+		}
+	}
+
+	if (numRemoved == 0) {
+		return false;
+	}
+
+	peepholeFunc.endPass();
+	peepholeFunc.store(function);
+	mStatistics.add("dce.unreachable", numRemoved);
+	return true;
+}
+
+bool DeadCodeEliminator::removeDeadStores(GeneratedFunction& function) {
+	auto live = LocalAllocator::liveLocals(function);
+	auto instructions = function.instructions();
+	bool changed = false;
+
+	for (std::size_t i = 0; i < instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (inst.first == "STLOC" && !live[i + 1][std::stoi(inst.second)]) {
+			instructions[i] = "POP";
+			mStatistics.add("dce.dead-stores");
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		function.replaceInstructions(instructions);
+	}
+
+	return changed;
+}
+
+bool DeadCodeEliminator::removePureValues(GeneratedFunction& function) {
+	PeepholeFunction peepholeFunc(function);
+	peepholeFunc.beginPass();
+	bool changed = false;
+
+	for (int i = 0; i < peepholeFunc.size(); i++) {
+		if (peepholeFunc.at(i).opCode != "POP") {
+			continue;
+		}
+
+		//Find the instructions computing the popped value, which must be in the same block as the pop
+		int needed = 1;
+		int start = i;
+
+		while (needed > 0 && start > 0 && !peepholeFunc.isTarget(start)) {
+			auto& inst = peepholeFunc.at(start - 1);
+
+			if (inst.isBranch() || inst.isDeleted
+				|| !InstructionInfo::isPure(inst.opCode) || InstructionInfo::canThrow(inst.opCode)) {
+				break;
+			}
+
+			auto instruction = inst.operand != "" ? inst.opCode + " " + inst.operand : inst.opCode;
+			auto effect = mInstructionInfo.stackEffect(function, instruction);
+			needed += effect.pops - effect.pushes;
+			start--;
+		}
+
+		if (needed == 0) {
+			for (int j = start; j <= i; j++) {
+				peepholeFunc.at(j).isDeleted = true;
+			}
+
+			mStatistics.add("dce.pure-values");
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		peepholeFunc.endPass();
+		peepholeFunc.store(function);
+	}
+
+	return changed;
+}
+
+void DeadCodeEliminator::removeUnusedLocals(GeneratedFunction& function) {
+	//Locals can share index, so the number of indices can be less than the number of locals
+	int numIndices = 0;
+	for (auto& local : function.locals()) {
+		numIndices = std::max(numIndices, local.second.first + 1);
+	}
+
+	std::vector<bool> isUsed(numIndices, false);
+
+	for (auto& instruction : function.instructions()) {
+		auto inst = Instructions::split(instruction);
+
+		if (inst.first == "LDLOC" || inst.first == "STLOC") {
+			isUsed[std::stoi(inst.second)] = true;
+		}
+	}
+
+	//The used locals keep their order
+	std::vector<int> newIndex(numIndices, -1);
+	int numUsed = 0;
+
+	for (int local = 0; local < numIndices; local++) {
+		if (isUsed[local]) {
+			newIndex[local] = numUsed++;
+		}
+	}
+
+	if (numUsed == numIndices) {
+		return;
+	}
+
+	mStatistics.add("dce.unused-locals", numIndices - numUsed);
+
+	std::vector<std::string> instructions;
+	instructions.reserve(function.numInstructions());
+
+	for (auto& instruction : function.instructions()) {
+		auto inst = Instructions::split(instruction);
+
+		if (inst.first == "LDLOC" || inst.first == "STLOC") {
+			instructions.push_back(inst.first + " " + std::to_string(newIndex[std::stoi(inst.second)]));
+		} else {
+			instructions.push_back(instruction);
+		}
+	}
+
+	//Temporaries are named after their index, which later passes use to create new names
+	const std::string temporaryPrefix = "$tmp$_";
+	std::map<std::string, Local> locals;
+
+	for (auto& local : function.locals()) {
+		int index = newIndex[local.second.first];
+
+		if (index != -1) {
+			auto name = local.first;
+
+			if (name.compare(0, temporaryPrefix.size(), temporaryPrefix) == 0) {
+				name = temporaryPrefix + std::to_string(index);
+			}
+
+			locals.insert({ name, { index, local.second.second } });
+		}
+	}
+
+	function.replaceInstructions(instructions);
+	function.replaceLocals(locals);
+}
+
+void DeadCodeEliminator::eliminate(GeneratedFunction& function) {
+	removeUnreachable(function);
+
+	//Removing a value can make the stores of the locals it loads dead
+	bool changed = true;
+
+	while (changed) {
+		changed = removeDeadStores(function);
+		changed = removePureValues(function) || changed;
+	}
+
+	removeUnusedLocals(function);
+}
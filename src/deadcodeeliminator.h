@@ -0,0 +1,32 @@
+#pragma once
+
+class GeneratedFunction;
+class InstructionInfo;
+class Statistics;
+
+//Removes code that is never executed or whose result is never used from generated functions.
+//This covers unreachable instructions, stores to locals that are not read afterwards, pure values that are popped
+//and the locals that are no longer used.
+class DeadCodeEliminator {
+private:
+	const InstructionInfo& mInstructionInfo;
+	Statistics& mStatistics;
+
+	//Removes the instructions that cannot be reached from the start of the function
+	bool removeUnreachable(GeneratedFunction& function);
+
+	//Replaces stores to locals that are not read before being stored again by pops
+	bool removeDeadStores(GeneratedFunction& function);
+
+	//Removes the instructions computing values without side effects that are popped, including the pops
+	bool removePureValues(GeneratedFunction& function);
+
+	//Removes the locals that are never loaded or stored
+	void removeUnusedLocals(GeneratedFunction& function);
+public:
+	//Creates a new dead code eliminator
+	DeadCodeEliminator(const InstructionInfo& instructionInfo, Statistics& statistics);
+
+	//Eliminates the dead code in the given function
+	void eliminate(GeneratedFunction& function);
+};
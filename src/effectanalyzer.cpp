@@ -0,0 +1,111 @@
+#include "effectanalyzer.h"
+#include "codegenerator.h"
+#include "statistics.h"
+
+#include <set>
+#include <algorithm>
+
+namespace {
+	//The name of the statistic counting functions with the given effects
+	std::string effectsStatistic(FunctionEffects effects) {
+		switch (effects) {
+			case FunctionEffects::Pure:
+				return "effects.pure";
+			case FunctionEffects::ReadOnly:
+				return "effects.read-only";
+			case FunctionEffects::Allocating:
+				return "effects.allocating";
+			default:
+				return "effects.side-effecting";
+		}
+	}
+}
+
+EffectAnalyzer::EffectAnalyzer(InstructionInfo& instructionInfo, Statistics& statistics)
+	: mInstructionInfo(instructionInfo), mStatistics(statistics) {
+	for (auto effects : { FunctionEffects::Pure, FunctionEffects::ReadOnly, FunctionEffects::Allocating, FunctionEffects::SideEffecting }) {
+		mStatistics.add(effectsStatistic(effects), 0);
+	}
+}
+
+FunctionEffects EffectAnalyzer::functionEffects(const GeneratedFunction& function) const {
+	auto& instructions = function.instructions();
+	bool isConstructor = function.isMemberFunction() && function.name().find("::.constructor") != std::string::npos;
+	auto effects = FunctionEffects::Pure;
+
+	std::set<int> branchTargets;
+
+	for (auto& instruction : instructions) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			branchTargets.insert(std::stoi(inst.second));
+		}
+	}
+
+	//The instruction that pushed each value on the stack, or -1 if it was computed from other values
+	std::vector<int> stack;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		//The stack is empty between basic blocks
+		if (branchTargets.count(i) > 0) {
+			stack.clear();
+		}
+
+		auto instructionEffects = mInstructionInfo.effects(instructions[i]);
+
+		if (isConstructor && inst.first == "STFIELD" && stack.size() >= 2) {
+			auto object = stack[stack.size() - 2];
+
+			if (object != -1 && instructions[object] == "LDARG 0") {
+				instructionEffects = FunctionEffects::Pure;
+			}
+		}
+
+		effects = std::max(effects, instructionEffects);
+
+		auto effect = mInstructionInfo.stackEffect(function, instructions[i]);
+		stack.resize((int)stack.size() >= effect.pops ? stack.size() - effect.pops : 0);
+
+		for (int j = 0; j < effect.pushes; j++) {
+			stack.push_back(effect.pops == 0 && effect.pushes == 1 ? i : -1);
+		}
+
+		if (Instructions::isBranch(inst.first) || inst.first == "RET") {
+			stack.clear();
+		}
+	}
+
+	return effects;
+}
+
+void EffectAnalyzer::analyze(std::vector<GeneratedFunction>& functions) {
+	//The functions are assumed to be pure, and their effects grow with the effects of the called functions until no function changes,
+	//which also handles recursive calls
+	for (auto& function : functions) {
+		mInstructionInfo.defineEffects(function.signature(), FunctionEffects::Pure);
+	}
+
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (auto& function : functions) {
+			auto effects = functionEffects(function);
+
+			if (effects != mInstructionInfo.functionEffects(function.signature())) {
+				mInstructionInfo.defineEffects(function.signature(), effects);
+				changed = true;
+			}
+		}
+	}
+
+	for (auto& function : functions) {
+		auto effects = mInstructionInfo.functionEffects(function.signature());
+		function.setEffects(effects);
+		mStatistics.add(effectsStatistic(effects));
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+
+#include "instructioninfo.h"
+
+class GeneratedFunction;
+class Statistics;
+
+//Classifies the generated functions as pure, read-only, allocating or side-effecting, bottom-up in the call graph.
+//The effects are defined in the instruction info, so that optimizations can keep values loaded before calls without side effects.
+class EffectAnalyzer {
+private:
+	InstructionInfo& mInstructionInfo;
+	Statistics& mStatistics;
+
+	//Returns the effects of the given function, given the current effects of the called functions.
+	//Constructors initializing the fields of the new object are not side effects.
+	FunctionEffects functionEffects(const GeneratedFunction& function) const;
+public:
+	//Creates a new effect analyzer
+	EffectAnalyzer(InstructionInfo& instructionInfo, Statistics& statistics);
+
+	//Analyzes the effects of the given functions
+	void analyze(std::vector<GeneratedFunction>& functions);
+};
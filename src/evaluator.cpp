@@ -0,0 +1,605 @@
+#include "evaluator.h"
+#include "ast/asts.h"
+#include "typechecker.h"
+#include "type.h"
+#include "symbol.h"
+#include "statistics.h"
+#include "helpers.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <iomanip>
+
+namespace {
+	//Performs the given integer operation with the wrap around semantics of the VM
+	int wrapIntOp(int x, int y, char op) {
+		auto ux = (std::uint32_t)x;
+		auto uy = (std::uint32_t)y;
+		std::uint32_t res = 0;
+
+		switch (op) {
+			case '+':
+				res = ux + uy;
+				break;
+			case '-':
+				res = ux - uy;
+				break;
+			case '*':
+				res = ux * uy;
+				break;
+		}
+
+		return (int)(std::int32_t)res;
+	}
+
+	//Indicates if the given expression is a constant
+	bool isConstant(std::shared_ptr<ExpressionAST> expression) {
+		return std::dynamic_pointer_cast<IntegerExpressionAST>(expression) != nullptr
+			   || std::dynamic_pointer_cast<FloatExpressionAST>(expression) != nullptr
+			   || std::dynamic_pointer_cast<BoolExpressionAST>(expression) != nullptr
+			   || std::dynamic_pointer_cast<CharExpressionAST>(expression) != nullptr;
+	}
+}
+
+Evaluator::Value::Value()
+	: type(""), intValue(0), floatValue(0.0f) {
+
+}
+
+Evaluator::Frame::Frame()
+	: hasReturned(false) {
+
+}
+
+Evaluator::Evaluator(const TypeChecker& typeChecker, Statistics& statistics)
+	: mTypeChecker(typeChecker), mStatistics(statistics), mNumSteps(0), mNumElements(0), mDepth(0) {
+	mStatistics.add("evaluate.calls", 0);
+	mStatistics.add("evaluate.budget", 0);
+}
+
+const int Evaluator::maxSteps = 100000;
+const int Evaluator::maxElements = 100000;
+const int Evaluator::maxDepth = 100;
+
+bool Evaluator::step() {
+	mNumSteps++;
+	return mNumSteps <= maxSteps;
+}
+
+bool Evaluator::defaultValue(std::string type, Value& value) const {
+	value = Value();
+	value.type = type;
+
+	//Arrays are null by default
+	if (type == "Int" || type == "Float" || type == "Bool" || type == "Char") {
+		return true;
+	}
+
+	return type.length() > 2 && type.substr(type.length() - 2) == "[]";
+}
+
+Evaluator::Value* Evaluator::findVariable(Frame& frame, std::string name) const {
+	for (auto scope = frame.scopes.rbegin(); scope != frame.scopes.rend(); ++scope) {
+		auto variable = scope->find(name);
+
+		if (variable != scope->end()) {
+			return &variable->second;
+		}
+	}
+
+	return nullptr;
+}
+
+std::string Evaluator::callKey(std::string signature, const std::vector<Value>& arguments) {
+	std::ostringstream key;
+	key << std::setprecision(std::numeric_limits<float>::max_digits10) << signature;
+
+	for (auto& argument : arguments) {
+		key << " ";
+
+		if (argument.type == "Float") {
+			key << argument.floatValue;
+		} else {
+			key << argument.intValue;
+		}
+	}
+
+	return key.str();
+}
+
+std::shared_ptr<ExpressionAST> Evaluator::constantExpression(const Value& value) {
+	if (value.type == "Int") {
+		return std::make_shared<IntegerExpressionAST>(value.intValue);
+	} else if (value.type == "Bool") {
+		return std::make_shared<BoolExpressionAST>(value.intValue != 0);
+	} else if (value.type == "Char") {
+		return std::make_shared<CharExpressionAST>((char)value.intValue);
+	} else if (value.type == "Float" && std::isfinite(value.floatValue)) {
+		return std::make_shared<FloatExpressionAST>(value.floatValue);
+	}
+
+	return nullptr;
+}
+
+bool Evaluator::call(std::string signature, const std::vector<Value>& arguments, Value& result) {
+	auto function = mFunctions.find(signature);
+
+	if (function == mFunctions.end() || mDepth >= maxDepth) {
+		return false;
+	}
+
+	auto& parameters = function->second->prototype()->parameters();
+	Frame frame;
+	frame.scopes.push_back({});
+
+	for (std::size_t i = 0; i < parameters.size(); i++) {
+		frame.scopes[0][parameters[i]->name()] = arguments[i];
+	}
+
+	mDepth++;
+	bool executed = execute(frame, function->second->body());
+	mDepth--;
+
+	if (!executed) {
+		return false;
+	}
+
+	//A function without a return statement returns void
+	result = frame.hasReturned ? frame.returnValue : Value();
+	return true;
+}
+
+bool Evaluator::evaluateBinaryOp(Frame& frame, const BinaryOpExpressionAST& binaryOp, Value& result) {
+	auto op = binaryOp.op();
+
+	if (op == Operator('=')) {
+		Value value;
+
+		if (!evaluate(frame, binaryOp.rightHandSide(), value)) {
+			return false;
+		}
+
+		Value* variable = nullptr;
+
+		if (auto varDec = std::dynamic_pointer_cast<VariableDeclarationExpressionAST>(binaryOp.leftHandSide())) {
+			variable = &frame.scopes.back()[varDec->name()];
+		} else if (auto varRef = std::dynamic_pointer_cast<VariableReferenceExpressionAST>(binaryOp.leftHandSide())) {
+			variable = findVariable(frame, varRef->name());
+		}
+
+		if (variable == nullptr) {
+			return false;
+		}
+
+		*variable = value;
+		result = value;
+		return true;
+	}
+
+	Value lhs;
+
+	if (!evaluate(frame, binaryOp.leftHandSide(), lhs)) {
+		return false;
+	}
+
+	//The rhs is only evaluated if it decides the result
+	if (op == Operator('&', '&') || op == Operator('|', '|')) {
+		if ((lhs.intValue != 0) == (op == Operator('|', '|'))) {
+			result = lhs;
+			return true;
+		}
+
+		return evaluate(frame, binaryOp.rightHandSide(), result);
+	}
+
+	Value rhs;
+
+	if (!evaluate(frame, binaryOp.rightHandSide(), rhs) || lhs.type != rhs.type) {
+		return false;
+	}
+
+	result = Value();
+	result.type = "Bool";
+
+	if (lhs.type == "Int") {
+		int x = lhs.intValue;
+		int y = rhs.intValue;
+
+		if (op == Operator('+') || op == Operator('-') || op == Operator('*')) {
+			result.type = "Int";
+			result.intValue = wrapIntOp(x, y, op.op1());
+		} else if (op == Operator('/')) {
+			//The VM raises an error for these divisions
+			if (y == 0 || (x == std::numeric_limits<int>::min() && y == -1)) {
+				return false;
+			}
+
+			result.type = "Int";
+			result.intValue = x / y;
+		} else if (op == Operator('=', '=')) {
+			result.intValue = x == y;
+		} else if (op == Operator('!', '=')) {
+			result.intValue = x != y;
+		} else if (op == Operator('<')) {
+			result.intValue = x < y;
+		} else if (op == Operator('<', '=')) {
+			result.intValue = x <= y;
+		} else if (op == Operator('>')) {
+			result.intValue = x > y;
+		} else if (op == Operator('>', '=')) {
+			result.intValue = x >= y;
+		} else {
+			return false;
+		}
+	} else if (lhs.type == "Float") {
+		float x = lhs.floatValue;
+		float y = rhs.floatValue;
+
+		if (op == Operator('+') || op == Operator('-') || op == Operator('*') || op == Operator('/')) {
+			result.type = "Float";
+
+			switch (op.op1()) {
+				case '+':
+					result.floatValue = x + y;
+					break;
+				case '-':
+					result.floatValue = x - y;
+					break;
+				case '*':
+					result.floatValue = x * y;
+					break;
+				case '/':
+					result.floatValue = x / y;
+					break;
+			}
+		} else if (op == Operator('=', '=')) {
+			result.intValue = x == y;
+		} else if (op == Operator('!', '=')) {
+			result.intValue = x != y;
+		} else if (op == Operator('<')) {
+			result.intValue = x < y;
+		} else if (op == Operator('<', '=')) {
+			result.intValue = x <= y;
+		} else if (op == Operator('>')) {
+			result.intValue = x > y;
+		} else if (op == Operator('>', '=')) {
+			result.intValue = x >= y;
+		} else {
+			return false;
+		}
+	} else if (lhs.type == "Bool" || lhs.type == "Char") {
+		if (op == Operator('=', '=')) {
+			result.intValue = lhs.intValue == rhs.intValue;
+		} else if (op == Operator('!', '=')) {
+			result.intValue = lhs.intValue != rhs.intValue;
+		} else {
+			return false;
+		}
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+bool Evaluator::evaluate(Frame& frame, std::shared_ptr<ExpressionAST> expression, Value& result) {
+	if (!step()) {
+		return false;
+	}
+
+	result = Value();
+
+	if (auto intExpr = std::dynamic_pointer_cast<IntegerExpressionAST>(expression)) {
+		result.type = "Int";
+		result.intValue = intExpr->value();
+		return true;
+	} else if (auto floatExpr = std::dynamic_pointer_cast<FloatExpressionAST>(expression)) {
+		result.type = "Float";
+		result.floatValue = floatExpr->value();
+		return true;
+	} else if (auto boolExpr = std::dynamic_pointer_cast<BoolExpressionAST>(expression)) {
+		result.type = "Bool";
+		result.intValue = boolExpr->value();
+		return true;
+	} else if (auto charExpr = std::dynamic_pointer_cast<CharExpressionAST>(expression)) {
+		result.type = "Char";
+		result.intValue = charExpr->value();
+		return true;
+	} else if (auto varRef = std::dynamic_pointer_cast<VariableReferenceExpressionAST>(expression)) {
+		auto variable = findVariable(frame, varRef->name());
+
+		if (variable == nullptr) {
+			return false;
+		}
+
+		result = *variable;
+		return true;
+	} else if (auto varDec = std::dynamic_pointer_cast<VariableDeclarationExpressionAST>(expression)) {
+		if (!defaultValue(varDec->type(), result)) {
+			return false;
+		}
+
+		frame.scopes.back()[varDec->name()] = result;
+		return true;
+	} else if (auto binaryOp = std::dynamic_pointer_cast<BinaryOpExpressionAST>(expression)) {
+		return evaluateBinaryOp(frame, *binaryOp, result);
+	} else if (auto unaryOp = std::dynamic_pointer_cast<UnaryOpExpressionAST>(expression)) {
+		if (!evaluate(frame, unaryOp->operand(), result)) {
+			return false;
+		}
+
+		if (unaryOp->op() == Operator('!') && result.type == "Bool") {
+			result.intValue = !result.intValue;
+			return true;
+		} else if (unaryOp->op() == Operator('-') && result.type == "Int") {
+			result.intValue = wrapIntOp(0, result.intValue, '-');
+			return true;
+		} else if (unaryOp->op() == Operator('-') && result.type == "Float") {
+			result.floatValue = -result.floatValue;
+			return true;
+		}
+
+		return false;
+	} else if (auto castExpr = std::dynamic_pointer_cast<CastExpressionAST>(expression)) {
+		if (!evaluate(frame, castExpr->expression(), result)) {
+			return false;
+		}
+
+		if (castExpr->typeName() == "Float" && result.type == "Int") {
+			result.type = "Float";
+			result.floatValue = (float)result.intValue;
+			return true;
+		} else if (castExpr->typeName() == "Int" && result.type == "Float") {
+			//The conversion is only defined when the value fits
+			double value = std::trunc(result.floatValue);
+
+			if (std::isfinite(value)
+				&& value >= (double)std::numeric_limits<int>::min()
+				&& value <= (double)std::numeric_limits<int>::max()) {
+				result.type = "Int";
+				result.intValue = (int)value;
+				return true;
+			}
+		}
+
+		return false;
+	} else if (auto callExpr = std::dynamic_pointer_cast<CallExpressionAST>(expression)) {
+		if (callExpr->funcSymbol() == nullptr || callExpr->funcSymbol()->isMember()) {
+			return false;
+		}
+
+		std::vector<Value> arguments;
+
+		for (auto argument : callExpr->arguments()) {
+			Value value;
+
+			if (!evaluate(frame, argument, value)) {
+				return false;
+			}
+
+			arguments.push_back(value);
+		}
+
+		return call(callExpr->signature(mTypeChecker), arguments, result);
+	} else if (auto arrayDec = std::dynamic_pointer_cast<ArrayDeclarationAST>(expression)) {
+		Value length;
+		Value element;
+
+		if (!evaluate(frame, arrayDec->lengthExpression(), length)
+			|| !defaultValue(arrayDec->elementType(), element)
+			|| length.intValue < 0) {
+			return false;
+		}
+
+		mNumElements += length.intValue;
+
+		if (mNumElements > maxElements) {
+			return false;
+		}
+
+		result.type = arrayDec->elementType() + "[]";
+		result.elements = std::make_shared<std::vector<Value>>(length.intValue, element);
+		return true;
+	} else if (auto arrayAccess = std::dynamic_pointer_cast<ArrayAccessAST>(expression)) {
+		Value array;
+		Value index;
+
+		if (arrayAccess->accessExpressions().size() != 1
+			|| !evaluate(frame, arrayAccess->arrayRefExpression(), array)
+			|| !evaluate(frame, arrayAccess->accessExpression(), index)
+			|| array.elements == nullptr
+			|| index.intValue < 0 || index.intValue >= (int)array.elements->size()) {
+			return false;
+		}
+
+		result = array.elements->at(index.intValue);
+		return true;
+	} else if (auto arraySet = std::dynamic_pointer_cast<ArraySetElementAST>(expression)) {
+		Value array;
+		Value index;
+
+		if (arraySet->accessExpressions().size() != 1
+			|| !evaluate(frame, arraySet->arrayRefExpression(), array)
+			|| !evaluate(frame, arraySet->accessExpression(), index)
+			|| !evaluate(frame, arraySet->rightHandSide(), result)
+			|| array.elements == nullptr
+			|| index.intValue < 0 || index.intValue >= (int)array.elements->size()) {
+			return false;
+		}
+
+		array.elements->at(index.intValue) = result;
+		return true;
+	} else if (auto memberAccess = std::dynamic_pointer_cast<MemberAccessAST>(expression)) {
+		//Only the length of arrays can be accessed, as objects cannot be evaluated
+		auto member = std::dynamic_pointer_cast<VariableReferenceExpressionAST>(memberAccess->memberExpression());
+		Value array;
+
+		if (member == nullptr
+			|| member->name() != "length"
+			|| !evaluate(frame, memberAccess->accessExpression(), array)
+			|| array.elements == nullptr) {
+			return false;
+		}
+
+		result = Value();
+		result.type = "Int";
+		result.intValue = array.elements->size();
+		return true;
+	}
+
+	return false;
+}
+
+bool Evaluator::execute(Frame& frame, std::shared_ptr<StatementAST> statement) {
+	if (!step()) {
+		return false;
+	}
+
+	if (auto block = std::dynamic_pointer_cast<BlockAST>(statement)) {
+		frame.scopes.push_back({});
+
+		for (auto blockStatement : block->statements()) {
+			if (!execute(frame, blockStatement)) {
+				return false;
+			}
+
+			if (frame.hasReturned) {
+				break;
+			}
+		}
+
+		frame.scopes.pop_back();
+		return true;
+	} else if (auto exprStatement = std::dynamic_pointer_cast<ExpressionStatementAST>(statement)) {
+		Value value;
+		return evaluate(frame, exprStatement->expression(), value);
+	} else if (auto returnStatement = std::dynamic_pointer_cast<ReturnStatementAST>(statement)) {
+		if (returnStatement->returnExpression() != nullptr
+			&& !evaluate(frame, returnStatement->returnExpression(), frame.returnValue)) {
+			return false;
+		}
+
+		frame.hasReturned = true;
+		return true;
+	} else if (auto ifElse = std::dynamic_pointer_cast<IfElseStatementAST>(statement)) {
+		Value condition;
+
+		if (!evaluate(frame, ifElse->conditionExpression(), condition)) {
+			return false;
+		}
+
+		if (condition.intValue != 0) {
+			return execute(frame, ifElse->thenBlock());
+		} else if (ifElse->elseBlock() != nullptr) {
+			return execute(frame, ifElse->elseBlock());
+		}
+
+		return true;
+	} else if (auto whileLoop = std::dynamic_pointer_cast<WhileLoopStatementAST>(statement)) {
+		while (!frame.hasReturned) {
+			Value condition;
+
+			if (!evaluate(frame, whileLoop->conditionExpression(), condition)) {
+				return false;
+			}
+
+			if (condition.intValue == 0) {
+				break;
+			}
+
+			if (!execute(frame, whileLoop->bodyBlock())) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void Evaluator::findFunctions(std::shared_ptr<ProgramAST> programAST) {
+	mFunctions.clear();
+	mResults.clear();
+
+	programAST->visitFunctions([&](std::shared_ptr<FunctionAST> function) {
+		if (function->hasAttribute("NoInline")) {
+			return;
+		}
+
+		auto signature = function->prototype()->fullName(".") + "(" + Helpers::join<std::shared_ptr<VariableDeclarationExpressionAST>>(
+			function->prototype()->parameters(),
+			[&](std::shared_ptr<VariableDeclarationExpressionAST> parameter) {
+				return mTypeChecker.findType(parameter->type())->vmType();
+			}, " ") + ")";
+
+		mFunctions[signature] = function;
+	});
+}
+
+std::shared_ptr<ExpressionAST> Evaluator::evaluateCall(const CallExpressionAST& call) {
+	if (call.funcSymbol() == nullptr || call.funcSymbol()->isMember()) {
+		return nullptr;
+	}
+
+	//Only calls with constant arguments are evaluated
+	std::vector<Value> arguments;
+
+	for (auto argument : call.arguments()) {
+		Frame frame;
+		Value value;
+
+		if (!isConstant(argument)) {
+			return nullptr;
+		}
+
+		evaluate(frame, argument, value);
+		arguments.push_back(value);
+	}
+
+	auto signature = call.signature(mTypeChecker);
+
+	if (mFunctions.count(signature) == 0) {
+		return nullptr;
+	}
+
+	auto key = callKey(signature, arguments);
+	auto cachedResult = mResults.find(key);
+
+	if (cachedResult == mResults.end()) {
+		mNumSteps = 0;
+		mNumElements = 0;
+		mDepth = 0;
+
+		std::shared_ptr<Value> result = std::make_shared<Value>();
+
+		if (!this->call(signature, arguments, *result)) {
+			if (mNumSteps > maxSteps) {
+				mStatistics.add("evaluate.budget");
+			}
+
+			result = nullptr;
+		}
+
+		cachedResult = mResults.insert({ key, result }).first;
+	}
+
+	if (cachedResult->second == nullptr) {
+		return nullptr;
+	}
+
+	auto constant = constantExpression(*cachedResult->second);
+
+	if (constant != nullptr) {
+		mStatistics.add("evaluate.calls");
+	}
+
+	return constant;
+}
+
+void Evaluator::clear() {
+	mFunctions.clear();
+	mResults.clear();
+}
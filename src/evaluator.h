@@ -0,0 +1,102 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+class ProgramAST;
+class FunctionAST;
+class ExpressionAST;
+class StatementAST;
+class CallExpressionAST;
+class BinaryOpExpressionAST;
+class TypeChecker;
+class Statistics;
+
+//Evaluates calls of functions with constant arguments at compile time, by interpreting the AST of the called function.
+//A function can only be evaluated if it has no effects outside of the call: it may only call other functions that can be evaluated
+//and allocate arrays that do not escape, which excludes I/O, objects and native functions. The evaluation is bounded by a number of steps.
+class Evaluator {
+private:
+	//A value computed by the evaluator. Bools and chars are stored as integers, and arrays as their elements.
+	struct Value {
+		std::string type;
+		int intValue;
+		float floatValue;
+		std::shared_ptr<std::vector<Value>> elements;
+
+		Value();
+	};
+
+	//The state of an evaluated call
+	struct Frame {
+		//The variables in each enclosing block, where the first contains the parameters
+		std::vector<std::map<std::string, Value>> scopes;
+
+		bool hasReturned;
+		Value returnValue;
+
+		Frame();
+	};
+
+	const TypeChecker& mTypeChecker;
+	Statistics& mStatistics;
+
+	std::map<std::string, std::shared_ptr<FunctionAST>> mFunctions;
+
+	//The results of the evaluated calls, where a null result indicates that the call cannot be evaluated
+	std::map<std::string, std::shared_ptr<Value>> mResults;
+
+	int mNumSteps;
+	int mNumElements;
+	int mDepth;
+
+	//Indicates if the evaluation of the current call may continue, and counts the step
+	bool step();
+
+	//Returns the default value of the given type. False if the type cannot be evaluated.
+	bool defaultValue(std::string type, Value& value) const;
+
+	//Finds the variable with the given name
+	Value* findVariable(Frame& frame, std::string name) const;
+
+	//Returns the key of the call of the given function with the given arguments
+	static std::string callKey(std::string signature, const std::vector<Value>& arguments);
+
+	//Returns the given value as a constant expression, or null if it cannot be represented as a constant
+	static std::shared_ptr<ExpressionAST> constantExpression(const Value& value);
+
+	//Calls the function with the given signature
+	bool call(std::string signature, const std::vector<Value>& arguments, Value& result);
+
+	//Evaluates the given expression. False if it cannot be evaluated.
+	bool evaluate(Frame& frame, std::shared_ptr<ExpressionAST> expression, Value& result);
+
+	//Evaluates the given binary operator
+	bool evaluateBinaryOp(Frame& frame, const BinaryOpExpressionAST& binaryOp, Value& result);
+
+	//Executes the given statement. False if it cannot be executed.
+	bool execute(Frame& frame, std::shared_ptr<StatementAST> statement);
+public:
+	//Creates a new evaluator
+	Evaluator(const TypeChecker& typeChecker, Statistics& statistics);
+
+	//The maximum number of steps of an evaluation
+	static const int maxSteps;
+
+	//The maximum number of array elements allocated in an evaluation
+	static const int maxElements;
+
+	//The maximum depth of nested calls in an evaluation
+	static const int maxDepth;
+
+	//Finds the functions that can be evaluated in the given program. Functions with the 'NoInline' attribute are always called.
+	void findFunctions(std::shared_ptr<ProgramAST> programAST);
+
+	//Evaluates the given call. Returns the constant result, or null if the call cannot be evaluated.
+	std::shared_ptr<ExpressionAST> evaluateCall(const CallExpressionAST& call);
+
+	//Releases the found functions and the results. The functions refer to the AST, which must be destroyed
+	//on the stack that it was created on, as its destruction is as deep as the AST.
+	void clear();
+};
@@ -1,6 +1,10 @@
 #include "helpers.h"
 #include "symbol.h"
 #include "symboltable.h"
+#include <exception>
+#include <stdexcept>
+#include <cstring>
+#include <pthread.h>
 
 std::vector<std::string> Helpers::splitString(std::string str, std::string delimiter) {
 	std::vector<std::string> parts;
@@ -54,4 +58,57 @@ std::shared_ptr<Symbol> Helpers::findSymbolInNamespace(std::shared_ptr<SymbolTab
 	} else {
 		return symbolTable->find(name);
 	}
+}
+
+namespace {
+	//The state shared with a thread started by runWithStackSize
+	struct StackThreadState {
+		std::function<void()> fn;
+		std::exception_ptr exception;
+	};
+
+	void* runStackThread(void* arg) {
+		auto state = static_cast<StackThreadState*>(arg);
+
+		try {
+			state->fn();
+		} catch (...) {
+			state->exception = std::current_exception();
+		}
+
+		return nullptr;
+	}
+}
+
+void Helpers::runWithStackSize(std::size_t stackSize, std::function<void()> fn) {
+	//The stack size must be a multiple of the page size on some platforms
+	const std::size_t alignment = 1024 * 1024;
+	stackSize = ((stackSize + alignment - 1) / alignment) * alignment;
+
+	StackThreadState state { fn, nullptr };
+	pthread_attr_t attributes;
+	pthread_t thread;
+	int error = pthread_attr_init(&attributes);
+
+	if (error == 0) {
+		error = pthread_attr_setstacksize(&attributes, stackSize);
+
+		if (error == 0) {
+			error = pthread_create(&thread, &attributes, &runStackThread, &state);
+		}
+
+		pthread_attr_destroy(&attributes);
+	}
+
+	//The current stack may be too small for the given function, so it is not used instead
+	if (error != 0) {
+		throw std::runtime_error(
+			"Could not create a thread with a stack of " + std::to_string(stackSize) + " bytes: " + std::strerror(error) + ".");
+	}
+
+	pthread_join(thread, nullptr);
+
+	if (state.exception != nullptr) {
+		std::rethrow_exception(state.exception);
+	}
 }
\ No newline at end of file
@@ -36,4 +36,8 @@ namespace Helpers {
 
 	//Finds a symbol defined a namespace
 	std::shared_ptr<Symbol> findSymbolInNamespace(std::shared_ptr<SymbolTable> symbolTable, std::string name);
+
+	//Runs the given function on a new thread with a stack of (at least) the given size. Exceptions are rethrown in the calling thread.
+	//Throws if the thread cannot be created.
+	void runWithStackSize(std::size_t stackSize, std::function<void()> fn);
 };
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "inliner.h"
+#include "codegenerator.h"
+#include "localallocator.h"
+#include "instructioninfo.h"
+#include "statistics.h"
+#include "object.h"
+
+#include <algorithm>
+
+namespace {
+	//The possible inlining decisions
+	const std::vector<std::string> decisions = {
+		"inlined",
+		"no-inline",
+		"recursive",
+		"control-flow",
+		"null-check",
+		"uninitialized-locals",
+		"access",
+		"depth",
+		"too-large"
+	};
+
+	//The instructions that pushes a value without any side effects
+	const std::vector<std::string> pureLoads = {
+		"LDINT", "LDFLOAT", "LDCHAR", "LDTRUE", "LDFALSE", "LDNULL", "LDARG", "LDLOC"
+	};
+
+	//Returns the owner class of the given member reference, which is of the form 'class::member'
+	std::string memberClass(const std::string& member) {
+		return member.substr(0, member.find("::"));
+	}
+
+	//Returns the name of the given member reference
+	std::string memberName(const std::string& member) {
+		return member.substr(member.find("::") + 2);
+	}
+
+	//Indicates if the first instruction with side effects in the given member function dereferences the object
+	bool dereferencesObjectFirst(const GeneratedFunction& function) {
+		std::vector<std::string> loads;
+
+		for (auto& instruction : function.instructions()) {
+			auto inst = Instructions::split(instruction);
+
+			if (std::find(pureLoads.begin(), pureLoads.end(), inst.first) != pureLoads.end()) {
+				loads.push_back(instruction);
+				continue;
+			}
+
+			//The position from the top of the stack of the dereferenced object
+			int objectPosition = -1;
+
+			if (inst.first == "LDFIELD") {
+				objectPosition = 0;
+			} else if (inst.first == "STFIELD") {
+				objectPosition = 1;
+			} else if (inst.first == "CALLINST") {
+				objectPosition = InstructionInfo::numParameters(inst.second);
+			}
+
+			return objectPosition != -1
+				   && objectPosition < (int)loads.size()
+				   && loads[loads.size() - 1 - objectPosition] == "LDARG 0";
+		}
+
+		return false;
+	}
+}
+
+Inliner::Inliner(Statistics& statistics)
+	: mStatistics(statistics), mNumInlined(0) {
+	for (auto& decision : decisions) {
+		mStatistics.add("inline." + decision, 0);
+	}
+}
+
+const int Inliner::maxSize = 12;
+const int Inliner::maxDepth = 3;
+
+bool Inliner::accessesPrivateMembers(const GeneratedFunction& caller, const GeneratedFunction& callee) const {
+	//Only the class of the callee can have private members that it accesses, since the program is type checked
+	auto calleeClass = callee.className();
+
+	if (!callee.isMemberFunction() || calleeClass == caller.className()) {
+		return false;
+	}
+
+	for (auto& instruction : callee.instructions()) {
+		auto inst = Instructions::split(instruction);
+
+		if (inst.first == "LDFIELD" || inst.first == "STFIELD") {
+			if (memberClass(inst.second) == calleeClass) {
+				auto& objectLayout = mClasses.at(calleeClass)->objectLayout();
+				auto& field = objectLayout.getField(memberName(inst.second));
+
+				if (field.accessModifier() != AccessModifiers::Public) {
+					return true;
+				}
+			}
+		} else if (inst.first == "CALLINST" || inst.first == "NEWOBJ") {
+			if (memberClass(inst.second) == calleeClass) {
+				auto func = mFunctions.find(inst.second);
+
+				if (func == mFunctions.end() || func->second->accessModifier() != AccessModifiers::Public) {
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+std::string Inliner::decide(const GeneratedFunction& caller, const GeneratedFunction& callee) const {
+	if (callee.hasAttribute("NoInline")) {
+		return "no-inline";
+	}
+
+	if (mStates.at(&callee) == State::InProgress) {
+		return "recursive";
+	}
+
+	//The body must be a single block ending with the only return
+	auto& instructions = callee.instructions();
+	int size = instructions.size();
+
+	for (int i = 0; i < size; i++) {
+		auto opCode = Instructions::split(instructions[i]).first;
+
+		if (Instructions::isBranch(opCode) || (opCode == "RET" && i != size - 1)) {
+			return "control-flow";
+		}
+	}
+
+	//Calling a member function on null throws, so the body must dereference the object before anything else
+	if (callee.isMemberFunction() && !dereferencesObjectFirst(callee)) {
+		return "null-check";
+	}
+
+	//Locals are only zero initialized at the start of the function
+	auto liveAtEntry = LocalAllocator::liveLocals(callee)[0];
+	if (std::find(liveAtEntry.begin(), liveAtEntry.end(), true) != liveAtEntry.end()) {
+		return "uninitialized-locals";
+	}
+
+	if (accessesPrivateMembers(caller, callee)) {
+		return "access";
+	}
+
+	if (mDepths.at(&callee) + 1 > maxDepth) {
+		return "depth";
+	}
+
+	if (size - 1 > maxSize && !callee.hasAttribute("Inline")) {
+		return "too-large";
+	}
+
+	return "inlined";
+}
+
+void Inliner::expand(GeneratedFunction& caller, const GeneratedFunction& callee, std::vector<std::string>& instructions) {
+	auto prefix = "$inlined" + std::to_string(mNumInlined) + "$";
+	mNumInlined++;
+
+	//The arguments are on the stack, with the last one on top
+	auto& parameters = callee.parameters();
+	std::vector<int> parameterLocals;
+
+	for (auto& param : parameters) {
+		parameterLocals.push_back(caller.newLocal(prefix + param.name, param.type));
+	}
+
+	for (int i = parameters.size() - 1; i >= 0; i--) {
+		instructions.push_back("STLOC " + std::to_string(parameterLocals[i]));
+	}
+
+	std::map<int, int> localMapping;
+	for (auto& local : callee.locals()) {
+		if (localMapping.count(local.second.first) == 0) {
+			localMapping[local.second.first] = caller.newLocal(prefix + local.first, local.second.second);
+		}
+	}
+
+	//The return is the last instruction, and leaves the return value on the stack
+	for (int i = 0; i < callee.numInstructions() - 1; i++) {
+		auto inst = Instructions::split(callee.instructions()[i]);
+
+		if (inst.first == "LDARG") {
+			instructions.push_back("LDLOC " + std::to_string(parameterLocals[std::stoi(inst.second)]));
+		} else if (inst.first == "LDLOC" || inst.first == "STLOC") {
+			instructions.push_back(inst.first + " " + std::to_string(localMapping[std::stoi(inst.second)]));
+		} else {
+			instructions.push_back(callee.instructions()[i]);
+		}
+	}
+}
+
+void Inliner::process(GeneratedFunction& function) {
+	mStates[&function] = State::InProgress;
+
+	std::vector<std::string> instructions;
+	std::vector<int> newIndices;
+	int depth = 0;
+
+	for (auto& instruction : function.instructions()) {
+		newIndices.push_back(instructions.size());
+		auto inst = Instructions::split(instruction);
+
+		if ((inst.first == "CALL" || inst.first == "CALLINST") && mFunctions.count(inst.second) > 0) {
+			auto& callee = *mFunctions[inst.second];
+
+			if (mStates[&callee] == State::NotVisited) {
+				process(callee);
+			}
+
+			auto decision = decide(function, callee);
+			mStatistics.add("inline." + decision);
+
+			if (decision == "inlined") {
+				expand(function, callee, instructions);
+				depth = std::max(depth, mDepths[&callee] + 1);
+				continue;
+			}
+		}
+
+		instructions.push_back(instruction);
+	}
+
+	newIndices.push_back(instructions.size());
+
+	//The inlined code contains no branches, so all branches refer to the original instructions
+	for (auto& instruction : instructions) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			instruction = inst.first + " " + std::to_string(newIndices[std::stoi(inst.second)]);
+		}
+	}
+
+	function.replaceInstructions(instructions);
+	mDepths[&function] = depth;
+	mStates[&function] = State::Done;
+}
+
+void Inliner::inlineFunctions(std::vector<GeneratedFunction>& functions, const std::vector<GeneratedClass>& classes) {
+	mFunctions.clear();
+	mClasses.clear();
+	mStates.clear();
+	mDepths.clear();
+
+	for (auto& func : functions) {
+		mFunctions[func.signature()] = &func;
+		mStates[&func] = State::NotVisited;
+	}
+
+	for (auto& classDef : classes) {
+		mClasses[classDef.name()] = &classDef;
+	}
+
+	for (auto& func : functions) {
+		if (mStates[&func] == State::NotVisited) {
+			process(func);
+		}
+	}
+}
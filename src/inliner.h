@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+
+class GeneratedFunction;
+class GeneratedClass;
+class Statistics;
+
+//Replaces calls to small functions generated in the same program with the body of the called function.
+//Only functions without branches are inlined, which means that the stack is never split by the inlined code.
+class Inliner {
+private:
+	//The state of a function being processed
+	enum class State {
+		NotVisited,
+		InProgress,
+		Done
+	};
+
+	Statistics& mStatistics;
+	std::map<std::string, GeneratedFunction*> mFunctions;
+	std::map<std::string, const GeneratedClass*> mClasses;
+	std::map<const GeneratedFunction*, State> mStates;
+	std::map<const GeneratedFunction*, int> mDepths;
+	int mNumInlined;
+
+	//Decides if the given call can be inlined. Returns the reason for the decision.
+	std::string decide(const GeneratedFunction& caller, const GeneratedFunction& callee) const;
+
+	//Indicates if the given callee accesses members that the caller cannot access
+	bool accessesPrivateMembers(const GeneratedFunction& caller, const GeneratedFunction& callee) const;
+
+	//Inlines the calls in the given function. The called functions are processed first.
+	void process(GeneratedFunction& function);
+
+	//Adds the inlined body of the given callee to the given instructions
+	void expand(GeneratedFunction& caller, const GeneratedFunction& callee, std::vector<std::string>& instructions);
+public:
+	//Creates a new inliner
+	Inliner(Statistics& statistics);
+
+	//Inlines calls in the given functions
+	void inlineFunctions(std::vector<GeneratedFunction>& functions, const std::vector<GeneratedClass>& classes);
+
+	//The maximum number of instructions of a function that is inlined without the 'Inline' attribute
+	static const int maxSize;
+
+	//The maximum number of nested inlined calls
+	static const int maxDepth;
+};
@@ -0,0 +1,220 @@
+#include "instructioninfo.h"
+#include "codegenerator.h"
+#include "typechecker.h"
+#include "type.h"
+#include "helpers.h"
+
+#include <set>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+	//The instructions that push a value without popping any
+	const std::set<std::string> loadInstructions = {
+		"LDINT", "LDFLOAT", "LDCHAR", "LDTRUE", "LDFALSE", "LDNULL", "LDSTR", "LDLOC", "LDARG"
+	};
+
+	//The instructions that pop one value and push one value
+	const std::set<std::string> unaryInstructions = {
+		"NOT", "CONVINTTOFLOAT", "CONVFLOATTOINT", "LDLEN", "LDFIELD", "NEWARR"
+	};
+
+	//The instructions that pop two values and push one value
+	const std::set<std::string> binaryInstructions = {
+		"ADD", "SUB", "MUL", "DIV", "CMPEQ", "CMPNE", "CMPGT", "CMPGE", "CMPLT", "CMPLE", "LDELEM"
+	};
+
+	//The instructions that only computes a value from their operands. String loads creates a new object.
+	const std::set<std::string> pureInstructions = {
+		"LDINT", "LDFLOAT", "LDCHAR", "LDTRUE", "LDFALSE", "LDNULL", "LDLOC", "LDARG",
+		"NOT", "CONVINTTOFLOAT", "CONVFLOATTOINT", "LDLEN", "LDFIELD", "LDELEM",
+		"ADD", "SUB", "MUL", "DIV", "CMPEQ", "CMPNE", "CMPGT", "CMPGE", "CMPLT", "CMPLE"
+	};
+
+	//The instructions that can throw. Integer division throws when dividing by zero.
+	const std::set<std::string> throwingInstructions = {
+		"DIV", "LDLEN", "LDFIELD", "STFIELD", "LDELEM", "STELEM", "NEWARR", "CALL", "CALLINST", "NEWOBJ"
+	};
+
+	//The instructions that read memory
+	const std::set<std::string> readInstructions = {
+		"LDFIELD", "LDELEM"
+	};
+
+	//The instructions that write memory
+	const std::set<std::string> writeInstructions = {
+		"STFIELD", "STELEM"
+	};
+
+	//The instructions that allocate memory
+	const std::set<std::string> allocationInstructions = {
+		"NEWARR", "NEWOBJ", "LDSTR"
+	};
+
+	//The compare instructions
+	const std::set<std::string> compareInstructions = {
+		"CMPEQ", "CMPNE", "CMPGT", "CMPGE", "CMPLT", "CMPLE", "NOT"
+	};
+}
+
+InstructionInfo::InstructionInfo(const TypeChecker& typeChecker)
+	: mTypeChecker(typeChecker) {
+
+}
+
+void InstructionInfo::defineFunction(std::string signature, std::shared_ptr<Type> returnType) {
+	mReturnTypes[signature] = returnType;
+}
+
+void InstructionInfo::defineEffects(std::string signature, FunctionEffects effects) {
+	mEffects[signature] = effects;
+}
+
+FunctionEffects InstructionInfo::functionEffects(std::string signature) const {
+	auto effects = mEffects.find(signature);
+
+	if (effects == mEffects.end()) {
+		return FunctionEffects::SideEffecting;
+	}
+
+	return effects->second;
+}
+
+FunctionEffects InstructionInfo::effects(const std::string& instruction) const {
+	auto inst = Instructions::split(instruction);
+	auto& opCode = inst.first;
+
+	if (opCode == "CALL" || opCode == "CALLINST") {
+		return functionEffects(inst.second);
+	} else if (opCode == "NEWOBJ") {
+		//The constructor is called on the new object
+		return std::max(FunctionEffects::Allocating, functionEffects(inst.second));
+	} else if (writeInstructions.count(opCode) > 0) {
+		return FunctionEffects::SideEffecting;
+	} else if (allocationInstructions.count(opCode) > 0) {
+		return FunctionEffects::Allocating;
+	} else if (readInstructions.count(opCode) > 0) {
+		return FunctionEffects::ReadOnly;
+	}
+
+	return FunctionEffects::Pure;
+}
+
+StackEffect InstructionInfo::stackEffect(const GeneratedFunction& function, const std::string& instruction) const {
+	auto inst = Instructions::split(instruction);
+	auto& opCode = inst.first;
+
+	if (loadInstructions.count(opCode) > 0) {
+		return { 0, 1 };
+	} else if (unaryInstructions.count(opCode) > 0) {
+		return { 1, 1 };
+	} else if (binaryInstructions.count(opCode) > 0) {
+		return { 2, 1 };
+	} else if (opCode == "STLOC" || opCode == "POP") {
+		return { 1, 0 };
+	} else if (opCode == "STFIELD") {
+		return { 2, 0 };
+	} else if (opCode == "STELEM") {
+		return { 3, 0 };
+	} else if (opCode == "BR") {
+		return { 0, 0 };
+	} else if (Instructions::isBranch(opCode)) {
+		return { 2, 0 };
+	} else if (opCode == "RET") {
+		return { function.returnType()->name() != "Void" ? 1 : 0, 0 };
+	} else if (opCode == "NEWOBJ") {
+		return { numParameters(inst.second), 1 };
+	} else if (opCode == "CALL" || opCode == "CALLINST") {
+		int pops = numParameters(inst.second) + (opCode == "CALLINST" ? 1 : 0);
+		auto returnType = mReturnTypes.find(inst.second);
+
+		if (returnType == mReturnTypes.end()) {
+			throw std::out_of_range("The function '" + inst.second + "' is not defined.");
+		}
+
+		return { pops, returnType->second->name() != "Void" ? 1 : 0 };
+	}
+
+	throw std::out_of_range("The instruction '" + opCode + "' is not defined.");
+}
+
+std::shared_ptr<Type> InstructionInfo::resultType(const GeneratedFunction& function,
+												  const std::string& instruction,
+												  const std::vector<std::shared_ptr<Type>>& operandTypes) const {
+	auto inst = Instructions::split(instruction);
+	auto& opCode = inst.first;
+
+	if (opCode == "LDINT" || opCode == "LDLEN" || opCode == "CONVFLOATTOINT") {
+		return mTypeChecker.findType("Int");
+	} else if (opCode == "LDFLOAT" || opCode == "CONVINTTOFLOAT") {
+		return mTypeChecker.findType("Float");
+	} else if (opCode == "LDCHAR") {
+		return mTypeChecker.findType("Char");
+	} else if (opCode == "LDTRUE" || opCode == "LDFALSE" || compareInstructions.count(opCode) > 0) {
+		return mTypeChecker.findType("Bool");
+	} else if (opCode == "LDLOC") {
+		int index = std::stoi(inst.second);
+
+		for (auto& local : function.locals()) {
+			if (local.second.first == index) {
+				return local.second.second;
+			}
+		}
+	} else if (opCode == "LDARG") {
+		return function.parameters().at(std::stoi(inst.second)).type;
+	} else if (opCode == "ADD" || opCode == "SUB" || opCode == "MUL" || opCode == "DIV") {
+		return operandTypes.at(0);
+	} else if (opCode == "LDFIELD") {
+		auto separator = inst.second.find("::");
+		auto className = Helpers::replaceString(inst.second.substr(0, separator), ".", "::");
+		auto fieldName = inst.second.substr(separator + 2);
+
+		if (mTypeChecker.objectExists(className)) {
+			auto& object = mTypeChecker.getObject(className);
+
+			if (object.fieldExists(fieldName)) {
+				return object.getField(fieldName).type();
+			}
+		}
+	} else if (opCode == "LDELEM") {
+		return mTypeChecker.findType(TypeSystem::fromVMType(inst.second));
+	} else if (opCode == "LDSTR") {
+		return mTypeChecker.findType("std::String");
+	} else if (opCode == "NEWARR") {
+		auto elementType = Helpers::replaceString(TypeSystem::fromVMType(inst.second), ".", "::");
+		return mTypeChecker.findType(elementType + "[]");
+	} else if (opCode == "NEWOBJ") {
+		auto className = Helpers::replaceString(inst.second.substr(0, inst.second.find("::.constructor")), ".", "::");
+		return mTypeChecker.findType(className);
+	} else if (opCode == "CALL" || opCode == "CALLINST") {
+		auto returnType = mReturnTypes.find(inst.second);
+
+		if (returnType != mReturnTypes.end()) {
+			return returnType->second;
+		}
+	}
+
+	return nullptr;
+}
+
+bool InstructionInfo::isPure(const std::string& opCode) {
+	return pureInstructions.count(opCode) > 0;
+}
+
+bool InstructionInfo::canThrow(const std::string& opCode) {
+	return throwingInstructions.count(opCode) > 0;
+}
+
+bool InstructionInfo::isCall(const std::string& opCode) {
+	return opCode == "CALL" || opCode == "CALLINST" || opCode == "NEWOBJ";
+}
+
+int InstructionInfo::numParameters(const std::string& signature) {
+	auto start = signature.find('(');
+
+	if (signature[start + 1] == ')') {
+		return 0;
+	}
+
+	return std::count(signature.begin() + start, signature.end(), ' ') + 1;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+
+class GeneratedFunction;
+class TypeChecker;
+class Type;
+
+//The effect of an instruction on the operand stack
+struct StackEffect {
+	int pops;
+	int pushes;
+};
+
+//The effects of a function, ordered from the fewest to the most effects. Functions with any effects can throw.
+enum class FunctionEffects {
+	//Only computes the result from the arguments
+	Pure,
+	//Can also read fields and array elements
+	ReadOnly,
+	//Can also allocate objects and arrays, but not write memory that existed before the call
+	Allocating,
+	//Can write memory or perform I/O
+	SideEffecting
+};
+
+//Provides information about generated instructions, such as their stack effect and the type of the value they push
+class InstructionInfo {
+private:
+	const TypeChecker& mTypeChecker;
+	std::map<std::string, std::shared_ptr<Type>> mReturnTypes;
+	std::map<std::string, FunctionEffects> mEffects;
+public:
+	//Creates a new instruction info
+	InstructionInfo(const TypeChecker& typeChecker);
+
+	//Defines the return type of the function with the given signature
+	void defineFunction(std::string signature, std::shared_ptr<Type> returnType);
+
+	//Defines the effects of the function with the given signature
+	void defineEffects(std::string signature, FunctionEffects effects);
+
+	//Returns the effects of the function with the given signature. Functions with unknown effects have side effects.
+	FunctionEffects functionEffects(std::string signature) const;
+
+	//Returns the effects of the given instruction. Calls have the effects of the called function.
+	FunctionEffects effects(const std::string& instruction) const;
+
+	//Returns the stack effect of the given instruction in the given function
+	StackEffect stackEffect(const GeneratedFunction& function, const std::string& instruction) const;
+
+	//Returns the type of the value pushed by the given instruction, given the types of the operands.
+	//Nullptr if the instruction does not push a value or the type is not known.
+	std::shared_ptr<Type> resultType(const GeneratedFunction& function,
+									 const std::string& instruction,
+									 const std::vector<std::shared_ptr<Type>>& operandTypes) const;
+
+	//Indicates if the given op code only computes a value from its operands, which may throw
+	static bool isPure(const std::string& opCode);
+
+	//Indicates if the given op code can throw an exception
+	static bool canThrow(const std::string& opCode);
+
+	//Indicates if the given op code calls a function, which can have any side effect
+	static bool isCall(const std::string& opCode);
+
+	//Returns the number of parameters in the given function signature
+	static int numParameters(const std::string& signature);
+};
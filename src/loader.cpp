@@ -6,10 +6,11 @@
 #include "type.h"
 #include "helpers.h"
 #include "assemblyparser.h"
+#include "instructioninfo.h"
 #include <stdexcept>
 
-Loader::Loader(Binder& binder, TypeChecker& typeChecker)
-	: mBinder(binder), mTypeChecker(typeChecker) {
+Loader::Loader(Binder& binder, TypeChecker& typeChecker, InstructionInfo& instructionInfo)
+	: mBinder(binder), mTypeChecker(typeChecker), mInstructionInfo(instructionInfo) {
 
 }
 
@@ -219,6 +220,20 @@ void Loader::defineMemberFunction(const AssemblyParser::Function& memberDef) {
 	}
 }
 
+void Loader::defineEffects(const AssemblyParser::Function& funcDef) {
+	auto attributes = funcDef.attributes.attributes;
+
+	//The object reference is not part of the signature
+	std::vector<std::string> parameters(funcDef.parameters.begin() + (funcDef.isMemberFunction ? 1 : 0), funcDef.parameters.end());
+	auto signature = funcDef.name + "(" + Helpers::join<std::string>(parameters, [](std::string param) { return param; }, " ") + ")";
+
+	if (attributes.count("Pure") > 0) {
+		mInstructionInfo.defineEffects(signature, FunctionEffects::Pure);
+	} else if (attributes.count("ReadOnly") > 0) {
+		mInstructionInfo.defineEffects(signature, FunctionEffects::ReadOnly);
+	}
+}
+
 void Loader::loadAssembly(std::istream& stream) {
 	//Parse
 	AssemblyParser::Assembly assembly;
@@ -236,5 +251,7 @@ void Loader::loadAssembly(std::istream& stream) {
 		} else {
 			defineFunction(currentFunc);
 		}
+
+		defineEffects(currentFunc);
 	}
 }
\ No newline at end of file
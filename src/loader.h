@@ -7,6 +7,7 @@ class Binder;
 class TypeChecker;
 class Type;
 class SymbolTable;
+class InstructionInfo;
 
 namespace AssemblyParser {
 	struct Function;
@@ -18,6 +19,7 @@ class Loader {
 private:
 	Binder& mBinder;
 	TypeChecker& mTypeChecker;
+	InstructionInfo& mInstructionInfo;
 
 	//Returns the type for the given VM type
 	std::shared_ptr<Type> getType(std::string vmTypeName);
@@ -30,9 +32,13 @@ private:
 
 	//Defines the given member function
 	void defineMemberFunction(const AssemblyParser::Function& memberDef);
+
+	//Defines the effects given by the 'Pure' and 'ReadOnly' attributes of the given function.
+	//Functions without these attributes are assumed to have side effects.
+	void defineEffects(const AssemblyParser::Function& funcDef);
 public:
 	//Creates a new loader
-	Loader(Binder& binder, TypeChecker& typeChecker);
+	Loader(Binder& binder, TypeChecker& typeChecker, InstructionInfo& instructionInfo);
 
 	//Loads an assembly from the given stream
 	void loadAssembly(std::istream& stream);
@@ -0,0 +1,180 @@
+#include "localallocator.h"
+#include "codegenerator.h"
+#include "statistics.h"
+#include "type.h"
+
+#include <set>
+#include <map>
+
+LocalAllocator::LocalAllocator(Statistics& statistics)
+	: mStatistics(statistics) {
+
+}
+
+std::vector<std::vector<bool>> LocalAllocator::liveLocals(const GeneratedFunction& function) {
+	int numInsts = function.numInstructions();
+	int numLocals = function.numLocals();
+
+	//Compute the successors, uses and definitions of each instruction
+	std::vector<std::vector<int>> successors(numInsts);
+	std::vector<int> uses(numInsts, -1);
+	std::vector<int> defs(numInsts, -1);
+
+	for (int i = 0; i < numInsts; i++) {
+		auto inst = Instructions::split(function.instructions()[i]);
+
+		if (Instructions::isBranch(inst.first)) {
+			successors[i].push_back(std::stoi(inst.second));
+
+			if (inst.first != "BR") {
+				successors[i].push_back(i + 1);
+			}
+		} else if (inst.first != "RET") {
+			successors[i].push_back(i + 1);
+		}
+
+		if (inst.first == "LDLOC") {
+			uses[i] = std::stoi(inst.second);
+		} else if (inst.first == "STLOC") {
+			defs[i] = std::stoi(inst.second);
+		}
+	}
+
+	std::vector<std::vector<bool>> live(numInsts + 1, std::vector<bool>(numLocals, false));
+
+	//Iterate backwards until a fixed point is reached
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (int i = numInsts - 1; i >= 0; i--) {
+			std::vector<bool> liveIn(numLocals, false);
+
+			for (auto succ : successors[i]) {
+				for (int local = 0; local < numLocals; local++) {
+					if (live[succ][local]) {
+						liveIn[local] = true;
+					}
+				}
+			}
+
+			if (defs[i] != -1) {
+				liveIn[defs[i]] = false;
+			}
+
+			if (uses[i] != -1) {
+				liveIn[uses[i]] = true;
+			}
+
+			if (liveIn != live[i]) {
+				live[i] = std::move(liveIn);
+				changed = true;
+			}
+		}
+	}
+
+	return live;
+}
+
+void LocalAllocator::allocate(GeneratedFunction& function) {
+	int numLocals = function.numLocals();
+
+	if (numLocals == 0) {
+		return;
+	}
+
+	auto live = liveLocals(function);
+
+	//Two locals interfere if one is stored while the other is live
+	std::vector<std::set<int>> interferences(numLocals);
+	std::vector<bool> isUsed(numLocals, false);
+
+	for (int i = 0; i < function.numInstructions(); i++) {
+		auto inst = Instructions::split(function.instructions()[i]);
+
+		if (inst.first == "LDLOC" || inst.first == "STLOC") {
+			isUsed[std::stoi(inst.second)] = true;
+		}
+
+		if (inst.first == "STLOC") {
+			int def = std::stoi(inst.second);
+
+			//The locals live after the store
+			auto& liveAfter = live[i + 1];
+
+			for (int local = 0; local < numLocals; local++) {
+				if (local != def && liveAfter[local]) {
+					interferences[def].insert(local);
+					interferences[local].insert(def);
+				}
+			}
+		}
+	}
+
+	//Assign slots in the order of the locals, using the first free slot of the same type.
+	//Locals that are never used are removed.
+	std::vector<std::string> localTypes(numLocals);
+
+	for (auto& local : function.locals()) {
+		localTypes[local.second.first] = local.second.second->vmType();
+	}
+
+	std::vector<std::string> slotTypes;
+	std::vector<int> slots(numLocals, -1);
+
+	for (int local = 0; local < numLocals; local++) {
+		if (!isUsed[local]) {
+			continue;
+		}
+
+		std::set<int> usedSlots;
+		for (auto other : interferences[local]) {
+			if (slots[other] != -1) {
+				usedSlots.insert(slots[other]);
+			}
+		}
+
+		for (int slot = 0; slot < (int)slotTypes.size(); slot++) {
+			if (slotTypes[slot] == localTypes[local] && usedSlots.count(slot) == 0) {
+				slots[local] = slot;
+				break;
+			}
+		}
+
+		if (slots[local] == -1) {
+			slots[local] = slotTypes.size();
+			slotTypes.push_back(localTypes[local]);
+		}
+	}
+
+	mStatistics.add("locals.original", numLocals);
+	mStatistics.add("locals.allocated", slotTypes.size());
+
+	//Update the instructions and the locals
+	std::vector<std::string> instructions;
+	instructions.reserve(function.numInstructions());
+
+	for (auto& instruction : function.instructions()) {
+		auto inst = Instructions::split(instruction);
+
+		if (inst.first == "LDLOC" || inst.first == "STLOC") {
+			instructions.push_back(inst.first + " " + std::to_string(slots[std::stoi(inst.second)]));
+		} else {
+			instructions.push_back(instruction);
+		}
+	}
+
+	std::map<std::string, Local> locals;
+
+	for (auto& local : function.locals()) {
+		int slot = slots[local.second.first];
+
+		if (slot != -1) {
+			locals.insert({ local.first, { slot, local.second.second } });
+		}
+	}
+
+	function.replaceInstructions(instructions);
+	function.replaceLocals(locals);
+}
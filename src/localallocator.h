@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include <string>
+
+class GeneratedFunction;
+class Statistics;
+
+//Assigns the locals of generated functions to slots. Locals of the same type that are never live at the same time share slot.
+class LocalAllocator {
+private:
+	Statistics& mStatistics;
+public:
+	//Creates a new local allocator
+	LocalAllocator(Statistics& statistics);
+
+	//Computes which locals are live before each instruction in the given function.
+	//The returned list contains one element per instruction, and one for the end of the function.
+	static std::vector<std::vector<bool>> liveLocals(const GeneratedFunction& function);
+
+	//Allocates the locals of the given function
+	void allocate(GeneratedFunction& function);
+};
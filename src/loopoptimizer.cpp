@@ -0,0 +1,1128 @@
+#include "loopoptimizer.h"
+#include "codegenerator.h"
+#include "instructioninfo.h"
+#include "statistics.h"
+#include "type.h"
+
+#include <set>
+#include <map>
+#include <algorithm>
+#include <limits>
+
+namespace {
+	//Represents a value on the stack when analyzing a loop
+	struct StackValue {
+		int start;
+		int end;
+		bool isInvariant;
+		bool canThrow;
+		int numOperations;
+		std::shared_ptr<Type> type;
+	};
+
+	//Returns the instructions without side effects of the test that guards the entry of the given loop.
+	//A rotated loop is only entered after testing the condition right before it. Empty if there is no such test.
+	std::vector<std::string> guardInstructions(const GeneratedFunction& function, const Loop& loop) {
+		auto& instructions = function.instructions();
+		std::set<int> branchTargets;
+
+		for (int i = 0; i < (int)instructions.size(); i++) {
+			auto inst = Instructions::split(instructions[i]);
+
+			if (Instructions::isBranch(inst.first)) {
+				int target = std::stoi(inst.second);
+
+				//The loop must only be entered from the test
+				if (target == loop.header && !loop.contains(i)) {
+					return {};
+				}
+
+				branchTargets.insert(target);
+			}
+		}
+
+		if (loop.header == 0) {
+			return {};
+		}
+
+		auto last = Instructions::split(instructions[loop.header - 1]).first;
+		if (!Instructions::isBranch(last) || last == "BR") {
+			return {};
+		}
+
+		int start = loop.header - 1;
+		while (start > 0 && branchTargets.count(start) == 0) {
+			auto prevOpCode = Instructions::split(instructions[start - 1]).first;
+
+			if (Instructions::isBranch(prevOpCode) || !InstructionInfo::isPure(prevOpCode)) {
+				break;
+			}
+
+			start--;
+		}
+
+		return std::vector<std::string>(instructions.begin() + start, instructions.begin() + loop.header);
+	}
+
+	//The branches that continue a counted loop, and the branches with the inverted condition
+	const std::map<std::string, std::string> invertedBranches = {
+		{ "BLT", "BGE" },
+		{ "BLE", "BGT" }
+	};
+
+	//Appends a copy of the instructions in [start, end) to the given instructions, whose first instruction is at the given offset.
+	//Branches are relocated to the copy, where branches to the end go to the end of the copy.
+	//If a counter value is given, loads of the counter are replaced by loading the value.
+	void copyInstructions(const std::vector<std::string>& instructions, int start, int end, int offset,
+						  std::vector<std::string>& newInstructions,
+						  const std::string& counterLoad = "", const std::string& counterValue = "") {
+		int copyStart = offset + newInstructions.size();
+
+		for (int i = start; i < end; i++) {
+			auto inst = Instructions::split(instructions[i]);
+
+			if (Instructions::isBranch(inst.first)) {
+				newInstructions.push_back(inst.first + " " + std::to_string(copyStart + std::stoi(inst.second) - start));
+			} else if (counterValue != "" && instructions[i] == counterLoad) {
+				newInstructions.push_back(counterValue);
+			} else {
+				newInstructions.push_back(instructions[i]);
+			}
+		}
+	}
+}
+
+//Loop
+int Loop::size() const {
+	return latch - header + 1;
+}
+
+bool Loop::contains(int index) const {
+	return index >= header && index <= latch;
+}
+
+//Loop optimizer
+LoopOptimizer::LoopOptimizer(const InstructionInfo& instructionInfo, Statistics& statistics)
+	: mInstructionInfo(instructionInfo), mStatistics(statistics), mUnrollFactor(defaultUnrollFactor) {
+	mStatistics.add("loops.hoisted", 0);
+	mStatistics.add("loops.unrolled", 0);
+	mStatistics.add("loops.fully-unrolled", 0);
+	mStatistics.add("loops.promoted", 0);
+	mStatistics.add("loops.strength-reduced", 0);
+	mStatistics.add("loops.dead-variables", 0);
+}
+
+const int LoopOptimizer::defaultUnrollFactor = 4;
+const int LoopOptimizer::maxUnrolledSize = 64;
+
+void LoopOptimizer::setUnrollFactor(int factor) {
+	mUnrollFactor = factor;
+}
+
+std::vector<Loop> LoopOptimizer::findLoops(const GeneratedFunction& function) {
+	auto& instructions = function.instructions();
+
+	//The last branch back to each header
+	std::map<int, int> latches;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (Instructions::isBranch(inst.first)) {
+			int target = std::stoi(inst.second);
+
+			if (target <= i) {
+				latches[target] = std::max(latches[target], i);
+			}
+		}
+	}
+
+	std::vector<Loop> loops;
+
+	for (auto& latch : latches) {
+		Loop loop = { latch.first, latch.second };
+		bool isEnteredAtHeader = true;
+
+		for (int i = 0; i < (int)instructions.size() && isEnteredAtHeader; i++) {
+			auto inst = Instructions::split(instructions[i]);
+
+			if (Instructions::isBranch(inst.first) && !loop.contains(i)) {
+				int target = std::stoi(inst.second);
+				isEnteredAtHeader = !(loop.contains(target) && target != loop.header);
+			}
+		}
+
+		if (isEnteredAtHeader) {
+			loops.push_back(loop);
+		}
+	}
+
+	std::stable_sort(loops.begin(), loops.end(), [](const Loop& x, const Loop& y) {
+		return x.size() < y.size();
+	});
+
+	return loops;
+}
+
+bool LoopOptimizer::findInvariantValues(const GeneratedFunction& function, const Loop& loop, std::vector<InvariantValue>& values) const {
+	auto& instructions = function.instructions();
+
+	//Find what is modified in the loop. Calls with side effects can modify any field.
+	std::set<int> branchTargets;
+	std::set<int> storedLocals;
+	std::set<std::string> storedFields;
+	bool hasCalls = false;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (Instructions::isBranch(inst.first)) {
+			branchTargets.insert(std::stoi(inst.second));
+		}
+
+		if (loop.contains(i)) {
+			if (inst.first == "STLOC") {
+				storedLocals.insert(std::stoi(inst.second));
+			} else if (inst.first == "STFIELD") {
+				storedFields.insert(inst.second);
+			} else if (InstructionInfo::isCall(inst.first)
+					   && mInstructionInfo.effects(instructions[i]) == FunctionEffects::SideEffecting) {
+				hasCalls = true;
+			}
+		}
+	}
+
+	//The stack is empty between basic blocks
+	std::vector<StackValue> stack;
+
+	for (int i = loop.header; i <= loop.latch; i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (i > loop.header) {
+			auto prevOpCode = Instructions::split(instructions[i - 1]).first;
+			bool isBlockStart = branchTargets.count(i) > 0 || Instructions::isBranch(prevOpCode) || prevOpCode == "RET";
+
+			if (isBlockStart && !stack.empty()) {
+				return false;
+			}
+		}
+
+		auto effect = mInstructionInfo.stackEffect(function, instructions[i]);
+
+		if ((int)stack.size() < effect.pops) {
+			return false;
+		}
+
+		std::vector<StackValue> operands(stack.end() - effect.pops, stack.end());
+		stack.resize(stack.size() - effect.pops);
+
+		bool isInvariant = InstructionInfo::isPure(inst.first);
+		bool canThrow = InstructionInfo::canThrow(inst.first);
+		int numOperations = effect.pops > 0 ? 1 : 0;
+		std::vector<std::shared_ptr<Type>> operandTypes;
+
+		for (auto& operand : operands) {
+			isInvariant = isInvariant && operand.isInvariant;
+			canThrow = canThrow || operand.canThrow;
+			numOperations += operand.numOperations;
+			operandTypes.push_back(operand.type);
+		}
+
+		if (inst.first == "LDLOC") {
+			isInvariant = storedLocals.count(std::stoi(inst.second)) == 0;
+		} else if (inst.first == "LDFIELD") {
+			isInvariant = isInvariant && storedFields.count(inst.second) == 0 && !hasCalls;
+		}
+
+		if (!isInvariant || effect.pushes == 0) {
+			//As the operands are used by a non-invariant instruction, they are maximal
+			for (auto& operand : operands) {
+				if (operand.isInvariant && operand.numOperations > 0 && operand.type != nullptr) {
+					values.push_back({ operand.start, operand.end, operand.canThrow, operand.type });
+				}
+			}
+		}
+
+		if (effect.pushes > 0) {
+			int start = operands.empty() ? i : operands.front().start;
+
+			if (isInvariant) {
+				auto type = mInstructionInfo.resultType(function, instructions[i], operandTypes);
+				stack.push_back({ start, i, true, canThrow, numOperations, type });
+			} else {
+				stack.push_back({ start, i, false, canThrow, numOperations, nullptr });
+			}
+		}
+	}
+
+	std::sort(values.begin(), values.end(), [](const InvariantValue& x, const InvariantValue& y) {
+		return x.start < y.start;
+	});
+
+	return true;
+}
+
+bool LoopOptimizer::hoistInvariants(GeneratedFunction& function, const Loop& loop) {
+	std::vector<InvariantValue> values;
+
+	if (!findInvariantValues(function, loop, values) || values.empty()) {
+		return false;
+	}
+
+	auto& instructions = function.instructions();
+
+	//Values that can throw are only hoisted if nothing observable happens before them in the loop.
+	//As the loop is only entered at the header, they would then be computed in the first iteration anyway.
+	//They are also hoisted if they are computed by the test before the loop, as they then cannot throw.
+	auto guard = guardInstructions(function, loop);
+	std::vector<InvariantValue> hoisted;
+	bool isPrefix = true;
+	int next = loop.header;
+
+	for (auto& value : values) {
+		for (; next < value.start; next++) {
+			auto opCode = Instructions::split(instructions[next]).first;
+
+			if (!InstructionInfo::isPure(opCode) || InstructionInfo::canThrow(opCode)) {
+				isPrefix = false;
+			}
+		}
+
+		bool isComputedByGuard = std::search(
+			guard.begin(), guard.end(),
+			instructions.begin() + value.start, instructions.begin() + value.end + 1) != guard.end();
+
+		if (!value.canThrow || isPrefix || isComputedByGuard) {
+			hoisted.push_back(value);
+			next = value.end + 1;
+		}
+	}
+
+	if (hoisted.empty()) {
+		return false;
+	}
+
+	//Compute the values before the loop, and load them in the loop
+	std::vector<std::string> newInstructions(instructions.begin(), instructions.begin() + loop.header);
+	std::vector<int> valueLocals;
+
+	for (auto& value : hoisted) {
+		int local = function.newLocal("$tmp$_" + std::to_string(function.numLocals()), value.type);
+		valueLocals.push_back(local);
+
+		for (int i = value.start; i <= value.end; i++) {
+			newInstructions.push_back(instructions[i]);
+		}
+
+		newInstructions.push_back("STLOC " + std::to_string(local));
+	}
+
+	std::vector<int> newIndices;
+	std::vector<std::pair<int, int>> branches;
+	int hoistedIndex = 0;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		if (i < loop.header) {
+			newIndices.push_back(i);
+		} else {
+			newIndices.push_back(newInstructions.size());
+		}
+
+		if (hoistedIndex < (int)hoisted.size() && i == hoisted[hoistedIndex].start) {
+			newInstructions.push_back("LDLOC " + std::to_string(valueLocals[hoistedIndex]));
+
+			for (; i < hoisted[hoistedIndex].end; i++) {
+				newIndices.push_back(newIndices.back());
+			}
+
+			hoistedIndex++;
+		} else if (i >= loop.header) {
+			newInstructions.push_back(instructions[i]);
+		}
+
+		if (Instructions::isBranch(Instructions::split(instructions[i]).first)) {
+			branches.push_back({ i, newIndices.back() });
+		}
+	}
+
+	newIndices.push_back(newInstructions.size());
+
+	//Branches from outside the loop enter at the start of the hoisted values
+	for (auto& branch : branches) {
+		auto inst = Instructions::split(instructions[branch.first]);
+		int target = std::stoi(inst.second);
+		int newTarget = newIndices[target];
+
+		if (target == loop.header && !loop.contains(branch.first)) {
+			newTarget = loop.header;
+		}
+
+		newInstructions[branch.second] = inst.first + " " + std::to_string(newTarget);
+	}
+
+	function.replaceInstructions(newInstructions);
+	mStatistics.add("loops.hoisted", hoisted.size());
+	return true;
+}
+
+bool LoopOptimizer::promoteFields(GeneratedFunction& function, const Loop& loop) {
+	if (!function.isMemberFunction()) {
+		return false;
+	}
+
+	auto& instructions = function.instructions();
+	std::set<int> branchTargets;
+
+	for (auto& instruction : instructions) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			branchTargets.insert(std::stoi(inst.second));
+		}
+	}
+
+	//The accesses of each field through the object, as the index of the object load and the access.
+	//Fields accessed through other objects might be the same field, and calls that are not pure can access any field.
+	std::map<std::string, std::vector<std::pair<int, int>>> accesses;
+	std::set<std::string> storedFields;
+	std::set<std::string> aliasedFields;
+
+	//The stack is empty between basic blocks
+	std::vector<std::pair<int, int>> stack;
+
+	for (int i = loop.header; i <= loop.latch; i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (i > loop.header) {
+			auto prevOpCode = Instructions::split(instructions[i - 1]).first;
+			bool isBlockStart = branchTargets.count(i) > 0 || Instructions::isBranch(prevOpCode) || prevOpCode == "RET";
+
+			if (isBlockStart && !stack.empty()) {
+				return false;
+			}
+		}
+
+		if (InstructionInfo::isCall(inst.first) && mInstructionInfo.effects(instructions[i]) != FunctionEffects::Pure) {
+			return false;
+		}
+
+		auto effect = mInstructionInfo.stackEffect(function, instructions[i]);
+
+		if ((int)stack.size() < effect.pops) {
+			return false;
+		}
+
+		std::vector<std::pair<int, int>> operands(stack.end() - effect.pops, stack.end());
+		stack.resize(stack.size() - effect.pops);
+
+		if (inst.first == "LDFIELD" || inst.first == "STFIELD") {
+			auto& object = operands[0];
+
+			if (object.first == object.second && instructions[object.first] == "LDARG 0") {
+				accesses[inst.second].push_back({ object.first, i });
+			} else {
+				aliasedFields.insert(inst.second);
+			}
+
+			if (inst.first == "STFIELD") {
+				storedFields.insert(inst.second);
+			}
+		}
+
+		if (effect.pushes > 0) {
+			stack.push_back({ operands.empty() ? i : operands.front().first, i });
+		}
+	}
+
+	std::map<std::string, int> fieldLocals;
+	std::set<int> removed;
+	std::map<int, std::string> replaced;
+
+	for (auto& field : storedFields) {
+		if (aliasedFields.count(field) > 0) {
+			continue;
+		}
+
+		auto type = mInstructionInfo.resultType(function, "LDFIELD " + field, {});
+		if (type == nullptr) {
+			continue;
+		}
+
+		int local = function.newLocal("$tmp$_" + std::to_string(function.numLocals()), type);
+		fieldLocals[field] = local;
+
+		for (auto& access : accesses[field]) {
+			auto opCode = Instructions::split(instructions[access.second]).first;
+			removed.insert(access.first);
+			replaced[access.second] = (opCode == "LDFIELD" ? "LDLOC " : "STLOC ") + std::to_string(local);
+		}
+	}
+
+	if (fieldLocals.empty()) {
+		return false;
+	}
+
+	auto addStores = [&](std::vector<std::string>& newInstructions) {
+		for (auto& field : fieldLocals) {
+			newInstructions.push_back("LDARG 0");
+			newInstructions.push_back("LDLOC " + std::to_string(field.second));
+			newInstructions.push_back("STFIELD " + field.first);
+		}
+	};
+
+	//Load the fields before the loop
+	std::vector<std::string> newInstructions(instructions.begin(), instructions.begin() + loop.header);
+	std::vector<int> newIndices;
+
+	for (int i = 0; i < loop.header; i++) {
+		newIndices.push_back(i);
+	}
+
+	for (auto& field : fieldLocals) {
+		newInstructions.push_back("LDARG 0");
+		newInstructions.push_back("LDFIELD " + field.first);
+		newInstructions.push_back("STLOC " + std::to_string(field.second));
+	}
+
+	//Returns in the loop branch to a return after the loop that stores the fields, with the return value in a local.
+	//The index of the return is used as the target of these branches.
+	int returnLocal = -1;
+	std::set<int> exitTargets;
+	std::vector<std::pair<int, int>> exitBranches;
+
+	for (int i = loop.header; i <= loop.latch; i++) {
+		newIndices.push_back(newInstructions.size());
+		auto inst = Instructions::split(instructions[i]);
+
+		if (removed.count(i) > 0) {
+			continue;
+		}
+
+		if (inst.first == "RET") {
+			if (function.returnType()->name() != "Void") {
+				if (returnLocal == -1) {
+					returnLocal = function.newLocal("$tmp$_" + std::to_string(function.numLocals()), function.returnType());
+				}
+
+				newInstructions.push_back("STLOC " + std::to_string(returnLocal));
+			}
+
+			exitTargets.insert(-1);
+			exitBranches.push_back({ (int)newInstructions.size(), -1 });
+			newInstructions.push_back("BR");
+			continue;
+		}
+
+		if (Instructions::isBranch(inst.first) && !loop.contains(std::stoi(inst.second))) {
+			exitTargets.insert(std::stoi(inst.second));
+		}
+
+		if (replaced.count(i) > 0) {
+			newInstructions.push_back(replaced[i]);
+		} else {
+			newInstructions.push_back(instructions[i]);
+		}
+	}
+
+	//Store the fields when leaving the loop at the end, and at the other exits
+	auto latchOpCode = Instructions::split(instructions[loop.latch]).first;
+
+	if (latchOpCode != "BR" && latchOpCode != "RET") {
+		addStores(newInstructions);
+
+		if (!exitTargets.empty()) {
+			exitBranches.push_back({ (int)newInstructions.size(), loop.latch + 1 });
+			newInstructions.push_back("BR");
+		}
+	}
+
+	std::map<int, int> exitStarts;
+
+	for (int target : exitTargets) {
+		exitStarts[target] = newInstructions.size();
+		addStores(newInstructions);
+
+		if (target == -1) {
+			if (returnLocal != -1) {
+				newInstructions.push_back("LDLOC " + std::to_string(returnLocal));
+			}
+
+			newInstructions.push_back("RET");
+		} else {
+			exitBranches.push_back({ (int)newInstructions.size(), target });
+			newInstructions.push_back("BR");
+		}
+	}
+
+	for (int i = loop.latch + 1; i < (int)instructions.size(); i++) {
+		newIndices.push_back(newInstructions.size());
+		newInstructions.push_back(instructions[i]);
+	}
+
+	newIndices.push_back(newInstructions.size());
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (Instructions::isBranch(inst.first)) {
+			int target = std::stoi(inst.second);
+			int newTarget = newIndices[target];
+
+			if (loop.contains(i) && !loop.contains(target)) {
+				newTarget = exitStarts[target];
+			} else if (!loop.contains(i) && target == loop.header) {
+				newTarget = loop.header;
+			}
+
+			newInstructions[newIndices[i]] = inst.first + " " + std::to_string(newTarget);
+		}
+	}
+
+	for (auto& branch : exitBranches) {
+		int target = branch.second == -1 ? exitStarts[-1] : newIndices[branch.second];
+		newInstructions[branch.first] += " " + std::to_string(target);
+	}
+
+	function.replaceInstructions(newInstructions);
+	mStatistics.add("loops.promoted", fieldLocals.size());
+	return true;
+}
+
+bool LoopOptimizer::reduceStrength(GeneratedFunction& function, const Loop& loop) {
+	auto& instructions = function.instructions();
+
+	//The induction variables are only stored by adding a constant: LDLOC i; LDINT c; ADD; STLOC i
+	std::map<int, std::vector<int>> increments;
+	std::set<int> storedLocals;
+	std::set<int> inductionVariables;
+
+	for (int i = loop.header; i <= loop.latch; i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (inst.first == "STLOC") {
+			int local = std::stoi(inst.second);
+			storedLocals.insert(local);
+
+			if (i - 3 >= loop.header
+				&& instructions[i - 3] == "LDLOC " + inst.second
+				&& Instructions::split(instructions[i - 2]).first == "LDINT"
+				&& instructions[i - 1] == "ADD") {
+				increments[local].push_back(i);
+			}
+		}
+	}
+
+	for (int local : storedLocals) {
+		auto type = mInstructionInfo.resultType(function, "LDLOC " + std::to_string(local), {});
+		int numStores = 0;
+
+		for (int i = loop.header; i <= loop.latch; i++) {
+			if (instructions[i] == "STLOC " + std::to_string(local)) {
+				numStores++;
+			}
+		}
+
+		if (type != nullptr && type->name() == "Int" && numStores == (int)increments[local].size()) {
+			inductionVariables.insert(local);
+		}
+	}
+
+	//Find the multiplications by an invariant stride, which is a constant, an argument or a local not stored in the loop.
+	//As integer arithmetic wraps around, (i + c) * s = i * s + c * s holds for all values.
+	auto isStride = [&](const std::string& instruction) {
+		auto inst = Instructions::split(instruction);
+		return inst.first == "LDINT" || inst.first == "LDARG"
+			   || (inst.first == "LDLOC" && storedLocals.count(std::stoi(inst.second)) == 0);
+	};
+
+	std::map<std::pair<int, std::string>, std::vector<int>> products;
+
+	for (int i = loop.header; i + 2 <= loop.latch; i++) {
+		if (instructions[i + 2] != "MUL") {
+			continue;
+		}
+
+		for (int variableIndex = i; variableIndex <= i + 1; variableIndex++) {
+			auto variable = Instructions::split(instructions[variableIndex]);
+			auto& stride = instructions[variableIndex == i ? i + 1 : i];
+
+			if (variable.first == "LDLOC" && inductionVariables.count(std::stoi(variable.second)) > 0 && isStride(stride)) {
+				products[{ std::stoi(variable.second), stride }].push_back(i);
+				break;
+			}
+		}
+	}
+
+	if (products.empty()) {
+		return false;
+	}
+
+	//Compute the products before the loop, and increment them after the variable
+	std::vector<std::string> newInstructions(instructions.begin(), instructions.begin() + loop.header);
+	std::map<int, int> replacedProducts;
+	std::map<int, std::vector<std::string>> addedIncrements;
+	auto intType = mInstructionInfo.resultType(function, "LDINT 0", {});
+
+	for (auto& product : products) {
+		int variable = product.first.first;
+		auto& stride = product.first.second;
+		int local = function.newLocal("$tmp$_" + std::to_string(function.numLocals()), intType);
+
+		newInstructions.push_back("LDLOC " + std::to_string(variable));
+		newInstructions.push_back(stride);
+		newInstructions.push_back("MUL");
+		newInstructions.push_back("STLOC " + std::to_string(local));
+
+		for (int start : product.second) {
+			replacedProducts[start] = local;
+		}
+
+		for (int increment : increments[variable]) {
+			auto step = std::stoll(Instructions::split(instructions[increment - 2]).second);
+			auto& added = addedIncrements[increment];
+			added.push_back("LDLOC " + std::to_string(local));
+
+			if (Instructions::split(stride).first == "LDINT") {
+				added.push_back("LDINT " + std::to_string((int)(step * std::stoll(Instructions::split(stride).second))));
+			} else if (step == 1) {
+				added.push_back(stride);
+			} else {
+				added.push_back("LDINT " + std::to_string(step));
+				added.push_back(stride);
+				added.push_back("MUL");
+			}
+
+			added.push_back("ADD");
+			added.push_back("STLOC " + std::to_string(local));
+		}
+	}
+
+	std::vector<int> newIndices;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		newIndices.push_back(i < loop.header ? i : newInstructions.size());
+
+		if (i < loop.header) {
+			continue;
+		}
+
+		auto product = replacedProducts.find(i);
+		if (product != replacedProducts.end()) {
+			newInstructions.push_back("LDLOC " + std::to_string(product->second));
+			newIndices.push_back(newIndices.back());
+			newIndices.push_back(newIndices.back());
+			i += 2;
+			continue;
+		}
+
+		newInstructions.push_back(instructions[i]);
+
+		auto added = addedIncrements.find(i);
+		if (added != addedIncrements.end()) {
+			newInstructions.insert(newInstructions.end(), added->second.begin(), added->second.end());
+		}
+	}
+
+	newIndices.push_back(newInstructions.size());
+
+	//Branches from outside the loop enter at the start of the computed products
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (Instructions::isBranch(inst.first)) {
+			int target = std::stoi(inst.second);
+			int newTarget = newIndices[target];
+
+			if (target == loop.header && !loop.contains(i)) {
+				newTarget = loop.header;
+			}
+
+			newInstructions[newIndices[i]] = inst.first + " " + std::to_string(newTarget);
+		}
+	}
+
+	function.replaceInstructions(newInstructions);
+	mStatistics.add("loops.strength-reduced", replacedProducts.size());
+	return true;
+}
+
+void LoopOptimizer::removeDeadVariables(GeneratedFunction& function) {
+	auto& instructions = function.instructions();
+
+	//Loads of each local, and the loads that are part of an increment: LDLOC x; <load>; ADD; STLOC x
+	std::map<int, int> numLoads;
+	std::map<int, std::vector<int>> increments;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (inst.first == "LDLOC") {
+			int local = std::stoi(inst.second);
+			numLoads[local]++;
+
+			if (i + 3 < (int)instructions.size()
+				&& InstructionInfo::isPure(Instructions::split(instructions[i + 1]).first)
+				&& mInstructionInfo.stackEffect(function, instructions[i + 1]).pops == 0
+				&& instructions[i + 2] == "ADD"
+				&& instructions[i + 3] == "STLOC " + inst.second) {
+				increments[local].push_back(i);
+			}
+		}
+	}
+
+	//The increments of a local that is only loaded by its increments are removed, and the remaining stores are popped
+	std::set<int> removedIncrements;
+	std::set<std::string> deadStores;
+	int numDead = 0;
+
+	for (auto& local : function.locals()) {
+		int index = local.second.first;
+
+		if (numLoads[index] == (int)increments[index].size() && deadStores.count("STLOC " + std::to_string(index)) == 0) {
+			removedIncrements.insert(increments[index].begin(), increments[index].end());
+			deadStores.insert("STLOC " + std::to_string(index));
+			numDead += numLoads[index] > 0 ? 1 : 0;
+		}
+	}
+
+	if (numDead == 0) {
+		return;
+	}
+
+	std::vector<std::string> newInstructions;
+	std::vector<int> newIndices;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		newIndices.push_back(newInstructions.size());
+
+		if (removedIncrements.count(i) > 0) {
+			for (int j = 0; j < 3; j++) {
+				newIndices.push_back(newInstructions.size());
+			}
+
+			i += 3;
+		} else if (deadStores.count(instructions[i]) > 0) {
+			newInstructions.push_back("POP");
+		} else {
+			newInstructions.push_back(instructions[i]);
+		}
+	}
+
+	newIndices.push_back(newInstructions.size());
+
+	for (auto& instruction : newInstructions) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			instruction = inst.first + " " + std::to_string(newIndices[std::stoi(inst.second)]);
+		}
+	}
+
+	function.replaceInstructions(newInstructions);
+	mStatistics.add("loops.dead-variables", numDead);
+}
+
+bool LoopOptimizer::findCountedLoop(const GeneratedFunction& function, const Loop& loop, CountedLoop& countedLoop) {
+	auto& instructions = function.instructions();
+	auto latch = Instructions::split(instructions[loop.latch]);
+
+	if (invertedBranches.count(latch.first) == 0) {
+		return false;
+	}
+
+	//The increment of the counter is followed by the test of the latch
+	int storeIndex = loop.latch - 1;
+	while (storeIndex > loop.header && Instructions::split(instructions[storeIndex]).first != "STLOC") {
+		storeIndex--;
+	}
+
+	int incrementStart = storeIndex - 3;
+	if (incrementStart < loop.header) {
+		return false;
+	}
+
+	auto counter = Instructions::split(instructions[storeIndex]).second;
+	auto step = Instructions::split(instructions[incrementStart + 1]);
+
+	if (instructions[incrementStart] != "LDLOC " + counter
+		|| step.first != "LDINT"
+		|| instructions[incrementStart + 2] != "ADD"
+		|| instructions[storeIndex + 1] != "LDLOC " + counter) {
+		return false;
+	}
+
+	countedLoop.variable = std::stoi(counter);
+	countedLoop.step = std::stoi(step.second);
+	countedLoop.bodyEnd = incrementStart;
+	countedLoop.bound = std::vector<std::string>(instructions.begin() + storeIndex + 2, instructions.begin() + loop.latch);
+	countedLoop.branch = latch.first;
+
+	if (countedLoop.step <= 0) {
+		return false;
+	}
+
+	std::set<int> storedLocals;
+	std::set<int> branchTargets;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (inst.first == "STLOC" && loop.contains(i)) {
+			//The counter is only modified by the increment
+			if (i != storeIndex && inst.second == counter) {
+				return false;
+			}
+
+			storedLocals.insert(std::stoi(inst.second));
+		}
+
+		if (Instructions::isBranch(inst.first) && i != loop.latch) {
+			int target = std::stoi(inst.second);
+
+			//The body must not contain other loops, or leave the loop other than by returning
+			if (loop.contains(i) && (target <= i || target > incrementStart)) {
+				return false;
+			}
+
+			branchTargets.insert(target);
+		}
+	}
+
+	//The bound must be an invariant value that cannot have side effects
+	int boundStackSize = 0;
+
+	for (auto& instruction : countedLoop.bound) {
+		auto inst = Instructions::split(instruction);
+
+		if (inst.first == "LDINT" || inst.first == "LDARG") {
+			boundStackSize++;
+		} else if (inst.first == "LDLOC" && storedLocals.count(std::stoi(inst.second)) == 0) {
+			boundStackSize++;
+		} else if (inst.first != "LDLEN" || boundStackSize == 0) {
+			return false;
+		}
+	}
+
+	if (boundStackSize != 1) {
+		return false;
+	}
+
+	//The loop must be guarded by the same test as in the latch, that exits the loop
+	countedLoop.guardStart = loop.header - countedLoop.bound.size() - 2;
+	if (countedLoop.guardStart < 0
+		|| instructions[countedLoop.guardStart] != "LDLOC " + counter
+		|| !std::equal(countedLoop.bound.begin(), countedLoop.bound.end(), instructions.begin() + countedLoop.guardStart + 1)
+		|| instructions[loop.header - 1] != invertedBranches.at(latch.first) + " " + std::to_string(loop.latch + 1)) {
+		return false;
+	}
+
+	//Find the constant that the counter is set to before the guard, without any other path to the loop
+	int index = countedLoop.guardStart;
+
+	while (true) {
+		if (branchTargets.count(index) > 0 || index == 0) {
+			return false;
+		}
+
+		index--;
+
+		auto opCode = Instructions::split(instructions[index]).first;
+		if (opCode == "BR" || opCode == "RET") {
+			return false;
+		}
+
+		if (instructions[index] == "STLOC " + counter) {
+			break;
+		}
+	}
+
+	auto initial = Instructions::split(instructions[index > 0 ? index - 1 : index]);
+	if (index == 0 || initial.first != "LDINT") {
+		return false;
+	}
+
+	countedLoop.initial = std::stoi(initial.second);
+	return true;
+}
+
+bool LoopOptimizer::unroll(GeneratedFunction& function, const Loop& loop) {
+	CountedLoop countedLoop;
+
+	if (mUnrollFactor <= 1 || !findCountedLoop(function, loop, countedLoop)) {
+		return false;
+	}
+
+	auto& instructions = function.instructions();
+	auto& bound = countedLoop.bound;
+	auto counterLoad = "LDLOC " + std::to_string(countedLoop.variable);
+	auto counterStore = "STLOC " + std::to_string(countedLoop.variable);
+	int bodySize = countedLoop.bodyEnd - loop.header;
+	int iterationEnd = countedLoop.bodyEnd + 4;
+	long long step = countedLoop.step;
+	long long initial = countedLoop.initial;
+
+	//The number of iterations is known if the bound is a constant
+	long long tripCount = -1;
+
+	if (bound.size() == 1 && Instructions::split(bound[0]).first == "LDINT") {
+		long long end = std::stoll(Instructions::split(bound[0]).second);
+
+		if (countedLoop.branch == "BLE") {
+			end++;
+		}
+
+		//The loop is never entered
+		if (initial >= end) {
+			return false;
+		}
+
+		tripCount = (end - initial + step - 1) / step;
+
+		if (initial + tripCount * step > std::numeric_limits<int>::max()) {
+			return false;
+		}
+	}
+
+	auto constant = [](long long value) {
+		return "LDINT " + std::to_string(value);
+	};
+
+	//The unrolled code replaces the guard and the loop
+	std::vector<std::string> unrolled;
+	std::vector<int> exitBranches;
+	int offset = countedLoop.guardStart;
+
+	if (tripCount != -1 && tripCount * bodySize <= maxUnrolledSize) {
+		//Every iteration is known, so the loop is replaced by the bodies with the counter as a constant
+		for (long long i = 0; i < tripCount; i++) {
+			copyInstructions(instructions, loop.header, countedLoop.bodyEnd, offset, unrolled, counterLoad, constant(initial + i * step));
+		}
+
+		unrolled.push_back(constant(initial + tripCount * step));
+		unrolled.push_back(counterStore);
+		mStatistics.add("loops.fully-unrolled");
+	} else if (mUnrollFactor * (bodySize + 4) > maxUnrolledSize) {
+		return false;
+	} else if (tripCount >= mUnrollFactor) {
+		//The iterations that are not a multiple of the factor are done before the loop
+		int peeled = tripCount % mUnrollFactor;
+
+		for (int i = 0; i < peeled; i++) {
+			copyInstructions(instructions, loop.header, countedLoop.bodyEnd, offset, unrolled, counterLoad, constant(initial + i * step));
+		}
+
+		if (peeled > 0) {
+			unrolled.push_back(constant(initial + peeled * step));
+			unrolled.push_back(counterStore);
+		}
+
+		int loopStart = offset + unrolled.size();
+
+		for (int i = 0; i < mUnrollFactor; i++) {
+			copyInstructions(instructions, loop.header, iterationEnd, offset, unrolled);
+		}
+
+		unrolled.insert(unrolled.end(), instructions.begin() + countedLoop.bodyEnd + 4, instructions.begin() + loop.latch);
+		unrolled.push_back(countedLoop.branch + " " + std::to_string(loopStart));
+		mStatistics.add("loops.unrolled");
+	} else {
+		//The unrolled loop runs while there are enough iterations left, and the remaining are done by a loop of single iterations.
+		//As the counter starts at the initial value and is less than the bound, subtracting from the bound cannot overflow.
+		long long boundOffset = (mUnrollFactor - 1) * step;
+
+		if (boundOffset > std::numeric_limits<int>::max()
+			|| initial - boundOffset < std::numeric_limits<int>::min()) {
+			return false;
+		}
+
+		auto invertedBranch = invertedBranches.at(countedLoop.branch);
+
+		auto addTest = [&](bool hasOffset) {
+			unrolled.push_back(counterLoad);
+			unrolled.insert(unrolled.end(), bound.begin(), bound.end());
+
+			if (hasOffset) {
+				unrolled.push_back(constant(boundOffset));
+				unrolled.push_back("SUB");
+			}
+		};
+
+		addTest(false);
+		exitBranches.push_back(unrolled.size());
+		unrolled.push_back(invertedBranch);
+
+		addTest(true);
+		int remainderBranch = unrolled.size();
+		unrolled.push_back(invertedBranch);
+
+		int loopStart = offset + unrolled.size();
+
+		for (int i = 0; i < mUnrollFactor; i++) {
+			copyInstructions(instructions, loop.header, iterationEnd, offset, unrolled);
+		}
+
+		addTest(true);
+		unrolled.push_back(countedLoop.branch + " " + std::to_string(loopStart));
+
+		unrolled[remainderBranch] += " " + std::to_string(offset + unrolled.size());
+		addTest(false);
+		exitBranches.push_back(unrolled.size());
+		unrolled.push_back(invertedBranch);
+
+		int remainderStart = offset + unrolled.size();
+		copyInstructions(instructions, loop.header, iterationEnd, offset, unrolled);
+		addTest(false);
+		unrolled.push_back(countedLoop.branch + " " + std::to_string(remainderStart));
+		mStatistics.add("loops.unrolled");
+	}
+
+	int exit = offset + unrolled.size();
+	for (int branch : exitBranches) {
+		unrolled[branch] += " " + std::to_string(exit);
+	}
+
+	//Only the instructions after the loop are moved
+	int delta = exit - (loop.latch + 1);
+	std::vector<std::string> newInstructions(instructions.begin(), instructions.begin() + offset);
+	newInstructions.insert(newInstructions.end(), unrolled.begin(), unrolled.end());
+	newInstructions.insert(newInstructions.end(), instructions.begin() + loop.latch + 1, instructions.end());
+
+	for (int i = 0; i < (int)newInstructions.size(); i++) {
+		if (i >= offset && i < exit) {
+			continue;
+		}
+
+		auto inst = Instructions::split(newInstructions[i]);
+
+		if (Instructions::isBranch(inst.first) && std::stoi(inst.second) > loop.latch) {
+			newInstructions[i] = inst.first + " " + std::to_string(std::stoi(inst.second) + delta);
+		}
+	}
+
+	function.replaceInstructions(newInstructions);
+	return true;
+}
+
+void LoopOptimizer::transformLoops(GeneratedFunction& function, bool (LoopOptimizer::*transform)(GeneratedFunction&, const Loop&)) {
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (auto& loop : findLoops(function)) {
+			if ((this->*transform)(function, loop)) {
+				changed = true;
+				break;
+			}
+		}
+	}
+}
+
+void LoopOptimizer::optimize(GeneratedFunction& function) {
+	//Unroll before hoisting, as the tests of the unrolled loops guard the invariant bounds
+	transformLoops(function, &LoopOptimizer::unroll);
+	transformLoops(function, &LoopOptimizer::promoteFields);
+	transformLoops(function, &LoopOptimizer::reduceStrength);
+	transformLoops(function, &LoopOptimizer::hoistInvariants);
+	removeDeadVariables(function);
+}
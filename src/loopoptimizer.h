@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+
+class GeneratedFunction;
+class Type;
+class InstructionInfo;
+class Statistics;
+
+//Represents a loop in the instructions of a function. The loop consists of the instructions between the header and latch.
+struct Loop {
+	int header;
+	int latch;
+
+	//Returns the number of instructions in the loop
+	int size() const;
+
+	//Indicates if the given instruction is in the loop
+	bool contains(int index) const;
+};
+
+//Optimizes the loops in generated functions
+class LoopOptimizer {
+private:
+	const InstructionInfo& mInstructionInfo;
+	Statistics& mStatistics;
+	int mUnrollFactor;
+
+	//Represents an invariant value that is computed in a loop
+	struct InvariantValue {
+		int start;
+		int end;
+		bool canThrow;
+		std::shared_ptr<Type> type;
+	};
+
+	//Represents a loop that increments a local by a constant step while it is less than a bound:
+	//  LDLOC <variable>; <bound>; <inverted branch> <exit>  (the guard, starting at guardStart)
+	//  <body>                                              (from the header until bodyEnd)
+	//  LDLOC <variable>; LDINT <step>; ADD; STLOC <variable>
+	//  LDLOC <variable>; <bound>; <branch> <header>         (the latch)
+	struct CountedLoop {
+		int variable;
+		int initial;
+		int step;
+		int guardStart;
+		int bodyEnd;
+		std::vector<std::string> bound;
+		std::string branch;
+	};
+
+	//Finds the maximal invariant values in the given loop. Returns false if the loop could not be analyzed.
+	bool findInvariantValues(const GeneratedFunction& function, const Loop& loop, std::vector<InvariantValue>& values) const;
+
+	//Hoists the invariant values in the given loop. Returns true if any value was hoisted.
+	bool hoistInvariants(GeneratedFunction& function, const Loop& loop);
+
+	//Promotes the fields of the object of a member function that are stored in the given loop to locals.
+	//The fields are loaded before the loop and stored at each exit. Returns true if any field was promoted.
+	bool promoteFields(GeneratedFunction& function, const Loop& loop);
+
+	//Replaces multiplications of an integer induction variable by an invariant stride in the given loop with a local
+	//that is incremented together with the variable. Returns true if any multiplication was replaced.
+	bool reduceStrength(GeneratedFunction& function, const Loop& loop);
+
+	//Removes the increments of locals that are not used for anything else, and the stores to locals that are never loaded
+	void removeDeadVariables(GeneratedFunction& function);
+
+	//Recognizes the given loop as a counted loop with a known initial value. Returns false if it is not one.
+	static bool findCountedLoop(const GeneratedFunction& function, const Loop& loop, CountedLoop& countedLoop);
+
+	//Unrolls the given loop. Returns true if the loop was unrolled.
+	bool unroll(GeneratedFunction& function, const Loop& loop);
+
+	//Applies the given transformation to the loops in the given function, until it does not change any loop
+	void transformLoops(GeneratedFunction& function, bool (LoopOptimizer::*transform)(GeneratedFunction&, const Loop&));
+public:
+	//Creates a new loop optimizer
+	LoopOptimizer(const InstructionInfo& instructionInfo, Statistics& statistics);
+
+	//The number of iterations that are combined when unrolling a loop by default
+	static const int defaultUnrollFactor;
+
+	//The maximum number of instructions in the body of an unrolled loop
+	static const int maxUnrolledSize;
+
+	//Sets the number of iterations that are combined when unrolling a loop. A factor of 1 disables unrolling.
+	void setUnrollFactor(int factor);
+
+	//Finds the loops in the given function, where inner loops are before outer loops.
+	//A loop is a range of instructions with branches back to its first instruction, which is only entered at the first instruction.
+	static std::vector<Loop> findLoops(const GeneratedFunction& function);
+
+	//Optimizes the loops in the given function
+	void optimize(GeneratedFunction& function);
+};
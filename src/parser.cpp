@@ -109,6 +109,21 @@ std::string Parser::parseNamespaceName() {
 	return namespaceName;
 }
 
+std::string Parser::parseArrayRank() {
+	std::string rank = "[";
+
+	//Rectangular arrays have a ',' between each dimension
+	while (isSingleCharToken(',')) {
+		nextToken(); //Eat the ','
+		rank += ",";
+	}
+
+	assertCurrentTokenAsChar(']', "Expected ']'");
+	nextToken(); //Eat the ']'
+
+	return rank + "]";
+}
+
 std::string Parser::parseTypeName(bool allowArray) {
 	std::string typeName = currentToken.strValue;
 
@@ -121,16 +136,38 @@ std::string Parser::parseTypeName(bool allowArray) {
 		//Check if array type
 		while (isSingleCharToken('[')) {
 			nextToken(); //Eat the '['
-			assertCurrentTokenAsChar(']', "Expected ']'");
-			nextToken(); //Eat the ']'
-
-			typeName += "[]";
+			typeName += parseArrayRank();
 		}
 	}
 
 	return typeName;
 }
 
+std::vector<std::shared_ptr<ExpressionAST>> Parser::parseAccessExpressions() {
+	std::vector<std::shared_ptr<ExpressionAST>> accessExpressions;
+
+	while (true) {
+		auto accessExpression = parseExpression();
+
+		if (accessExpression == nullptr) {
+			return {};
+		}
+
+		accessExpressions.push_back(accessExpression);
+
+		if (!isSingleCharToken(',')) {
+			break;
+		}
+
+		nextToken(); //Eat the ','
+	}
+
+	assertCurrentTokenAsChar(']', "Expected ']'");
+	nextToken(); //Eat the ']'
+
+	return accessExpressions;
+}
+
 std::shared_ptr<ExpressionAST> Parser::parseIntegerExpression() {
 	auto intAst = std::make_shared<IntegerExpressionAST>(currentToken.intValue);
 	nextToken(); //Consume the int
@@ -244,44 +281,36 @@ std::shared_ptr<ExpressionAST> Parser::parseIdentifierExpression(bool allowDecla
 		if (isSingleCharToken('[')) {
 			nextToken(); //Eat the '['
 
-			//If not ']', its an array access
-			std::shared_ptr<ExpressionAST> accessExpression = nullptr;
-			if (!isSingleCharToken(']')) {
-				accessExpression = parseExpression();
-			}
+			//If not ']' or ',', its an array access
+			if (!isSingleCharToken(']') && !isSingleCharToken(',')) {
+				auto accessExpressions = parseAccessExpressions();
+
+				if (accessExpressions.empty()) {
+					return nullptr;
+				}
 
-			assertCurrentTokenAsChar(']', "Expected ']'");
-			nextToken(); //Eat the ']'
-	
-			if (accessExpression != nullptr) {
 				std::shared_ptr<ExpressionAST> refExpression = std::make_shared<VariableReferenceExpressionAST>(identifier);
-				std::shared_ptr<ExpressionAST> arrayAccess = std::make_shared<ArrayAccessAST>(refExpression, accessExpression);
+				std::shared_ptr<ExpressionAST> arrayAccess = std::make_shared<ArrayAccessAST>(refExpression, accessExpressions);
 
 				while (isSingleCharToken('[')) {
 					nextToken(); //Eat the '['
-					accessExpression = parseExpression();
+					accessExpressions = parseAccessExpressions();
 
-					if (accessExpression == nullptr) {
+					if (accessExpressions.empty()) {
 						return nullptr;
 					}
 
-					arrayAccess = std::make_shared<ArrayAccessAST>(arrayAccess, accessExpression);
-
-					assertCurrentTokenAsChar(']', "Expected ']'");
-					nextToken(); //Eat the ']'
+					arrayAccess = std::make_shared<ArrayAccessAST>(arrayAccess, accessExpressions);
 				}
 
 				identExpr = arrayAccess;
 			} else {
 				//Array type
-				identifier += "[]";
+				identifier += parseArrayRank();
 
 				while (isSingleCharToken('[')) {
 					nextToken(); //Eat the '['
-					assertCurrentTokenAsChar(']', "Expected ']'");
-					nextToken(); //Eat the ']'
-
-					identifier += "[]";
+					identifier += parseArrayRank();
 				}
 			}
 		}
@@ -399,6 +428,34 @@ std::shared_ptr<ExpressionAST> Parser::parseNewObjectExpression(std::string type
 
 std::shared_ptr<ExpressionAST> Parser::parseNewArrayExpression(std::string elementTypeName) {
 	nextToken(); //Eat the '['
+
+	//Rectangular arrays are created as 'new T[,](length0, length1)'
+	if (isSingleCharToken(',')) {
+		int rank = parseArrayRank().length() - 1;
+		assertCurrentTokenAsChar('(', "Expected '('.");
+		nextToken(); //Eat the '('
+
+		std::vector<std::shared_ptr<ExpressionAST>> lengthExpressions;
+
+		while (!isSingleCharToken(')')) {
+			auto lengthExpression = parseExpression();
+
+			if (lengthExpression == nullptr) {
+				return nullptr;
+			}
+
+			lengthExpressions.push_back(lengthExpression);
+
+			if (isSingleCharToken(',')) {
+				nextToken(); //Eat the ','
+			} else {
+				assertCurrentTokenAsChar(')', "Expected ',' or ')' in length list.");
+			}
+		}
+
+		nextToken(); //Eat the ')'
+		return std::make_shared<RectangularArrayDeclarationAST>(elementTypeName, rank, lengthExpressions);
+	}
 	
 	// //Get the length expression
 	// auto lengthExpression = parseExpression();
@@ -803,15 +860,46 @@ std::shared_ptr<FunctionPrototypeAST> Parser::parseFunctionPrototype() {
 	return std::make_shared<FunctionPrototypeAST>(name, parameters, returnType);
 }
 
+bool Parser::isFunctionDefStart() {
+	return currentToken.type() == TokenType::Func || isSingleCharToken('@');
+}
+
+std::vector<std::string> Parser::parseFunctionAttributes() {
+	std::vector<std::string> attributes;
+
+	while (isSingleCharToken('@')) {
+		nextToken(); //Eat the '@'
+
+		if (currentToken.type() != TokenType::Identifier) {
+			error("Expected identifier after '@'.");
+		}
+
+		attributes.push_back(currentToken.strValue);
+		nextToken(); //Eat the name
+	}
+
+	if (currentToken.type() != TokenType::Func) {
+		error("Expected function definition after attributes.");
+	}
+
+	return attributes;
+}
+
 std::shared_ptr<FunctionAST> Parser::parseFunctionDef() {
-	return std::make_shared<FunctionAST>(parseFunctionPrototype(), parseBlock());
+	auto attributes = parseFunctionAttributes();
+	auto prototype = parseFunctionPrototype();
+	auto body = parseBlock();
+	return std::make_shared<FunctionAST>(prototype, body, attributes);
 }
 
 std::shared_ptr<MemberFunctionAST> Parser::parseMemberFunctionDef(AccessModifiers accessModifier) {
-	return std::make_shared<MemberFunctionAST>(parseFunctionPrototype(), parseBlock(), accessModifier);
+	auto attributes = parseFunctionAttributes();
+	auto prototype = parseFunctionPrototype();
+	auto body = parseBlock();
+	return std::make_shared<MemberFunctionAST>(prototype, body, accessModifier, attributes);
 }
 
-std::shared_ptr<MemberFunctionAST> Parser::parseConstructorDef(std::string className, AccessModifiers accessModifier) {
+std::shared_ptr<MemberFunctionAST> Parser::parseConstructorDef(std::string /*className*/, AccessModifiers accessModifier) {
 	//Eat the class name
 	nextToken();
 
@@ -857,7 +945,7 @@ std::shared_ptr<ClassDefinitionAST> Parser::parseClassDef() {
 		} else if (currentToken.type() == TokenType::Private) {
 			memberAccessModifier = AccessModifiers::Private;
 			nextToken();
-		} else if (currentToken.type() == TokenType::Func) {
+		} else if (isFunctionDefStart()) {
 			functions.push_back(parseMemberFunctionDef(memberAccessModifier));
 			nextToken();
 			memberAccessModifier = AccessModifiers::Public;
@@ -914,7 +1002,7 @@ std::shared_ptr<NamespaceDeclarationAST> Parser::parseNamespaceDef() {
 	std::vector<std::shared_ptr<AbstractSyntaxTree>> members;
 
 	while (true) {
-		if (currentToken.type() == TokenType::Func) {
+		if (isFunctionDefStart()) {
 			members.push_back(parseFunctionDef());
 			nextToken();
 		} if (currentToken.type() == TokenType::Class) {
@@ -959,6 +1047,14 @@ std::shared_ptr<ProgramAST> Parser::parse() {
 				globalMembers.push_back(parseFunctionDef());
 				nextToken();
 				break;
+			case TokenType::SingleChar:
+				if (isFunctionDefStart()) {
+					globalMembers.push_back(parseFunctionDef());
+					nextToken();
+				} else {
+					error("Invalid token: " + currentToken.asString());
+				}
+				break;
 			case TokenType::Class:
 				globalMembers.push_back(parseClassDef());
 				nextToken();
@@ -54,9 +54,15 @@ private:
 	//Parses a namespace name
 	std::string parseNamespaceName();
 
+	//Parses the rank of an array type after the '[', such as ']' or ',]' for rectangular arrays. Returns the type suffix.
+	std::string parseArrayRank();
+
 	//Parses a type name
 	std::string parseTypeName(bool allowArray = true);
 
+	//Parses the indices of an array access after the '[', which are separated by ','. Empty if an index cannot be parsed.
+	std::vector<std::shared_ptr<ExpressionAST>> parseAccessExpressions();
+
 	//Parses an integer expression
 	std::shared_ptr<ExpressionAST> parseIntegerExpression();
 
@@ -129,6 +135,12 @@ private:
 	//Parses a function prototype
 	std::shared_ptr<FunctionPrototypeAST> parseFunctionPrototype();
 
+	//Indicates if the current token starts a function definition
+	bool isFunctionDefStart();
+
+	//Parses the attributes of a function definition
+	std::vector<std::string> parseFunctionAttributes();
+
 	//Parses a function definition
 	std::shared_ptr<FunctionAST> parseFunctionDef();
 
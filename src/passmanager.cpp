@@ -0,0 +1,247 @@
+#include "passmanager.h"
+#include "codegenerator.h"
+#include "ast/programast.h"
+
+#include <stdexcept>
+#include <chrono>
+#include <iomanip>
+
+namespace {
+	//Measures the time spent in the given function, in seconds
+	double measureTime(std::function<void()> function) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		return duration.count();
+	}
+}
+
+PassManager::PassManager(std::ostream& dumpStream)
+	: mOptimizationLevel(defaultOptimizationLevel), mBisectLimit(-1), mNumOptionalPasses(0), mDumpStream(dumpStream) {
+
+}
+
+const int PassManager::defaultOptimizationLevel = 2;
+const int PassManager::maxOptimizationLevel = 2;
+
+void PassManager::addPass(Pass pass) {
+	for (auto& existing : mPasses) {
+		if (existing.name == pass.name) {
+			throw std::runtime_error("The pass '" + pass.name + "' is already defined.");
+		}
+	}
+
+	pass.time = 0;
+	mPasses.push_back(pass);
+}
+
+Pass& PassManager::getPass(std::string name) {
+	for (auto& pass : mPasses) {
+		if (pass.name == name) {
+			return pass;
+		}
+	}
+
+	throw std::runtime_error("The pass '" + name + "' is not defined.");
+}
+
+void PassManager::addProgramPass(std::string name, int level, std::vector<std::string> dependencies,
+								 std::function<void(std::shared_ptr<ProgramAST>)> run) {
+	Pass pass;
+	pass.name = name;
+	pass.kind = PassKind::Program;
+	pass.level = level;
+	pass.dependencies = dependencies;
+	pass.runProgram = run;
+	addPass(pass);
+}
+
+void PassManager::addModulePass(std::string name, int level, std::vector<std::string> dependencies,
+								std::function<void()> run) {
+	Pass pass;
+	pass.name = name;
+	pass.kind = PassKind::Module;
+	pass.level = level;
+	pass.dependencies = dependencies;
+	pass.runModule = run;
+	addPass(pass);
+}
+
+void PassManager::addFunctionPass(std::string name, int level, std::vector<std::string> dependencies,
+								  std::function<void(GeneratedFunction&)> run) {
+	Pass pass;
+	pass.name = name;
+	pass.kind = PassKind::Function;
+	pass.level = level;
+	pass.dependencies = dependencies;
+	pass.runFunction = run;
+	addPass(pass);
+}
+
+int PassManager::optimizationLevel() const {
+	return mOptimizationLevel;
+}
+
+void PassManager::setOptimizationLevel(int level) {
+	if (level < 0 || level > maxOptimizationLevel) {
+		throw std::runtime_error("Invalid optimization level: " + std::to_string(level) + ".");
+	}
+
+	mOptimizationLevel = level;
+}
+
+void PassManager::disablePass(std::string name) {
+	mDisabledPasses.insert(name);
+}
+
+void PassManager::printBefore(std::string name) {
+	mPrintBefore.insert(name);
+}
+
+void PassManager::printAfter(std::string name) {
+	mPrintAfter.insert(name);
+}
+
+void PassManager::setBisectLimit(int limit) {
+	mBisectLimit = limit;
+}
+
+void PassManager::verifyOptions() {
+	for (auto& name : mDisabledPasses) {
+		if (getPass(name).level == 0) {
+			throw std::runtime_error("The pass '" + name + "' is required and cannot be disabled.");
+		}
+	}
+
+	for (auto& name : mPrintBefore) {
+		getPass(name);
+	}
+
+	for (auto& name : mPrintAfter) {
+		getPass(name);
+	}
+}
+
+std::vector<Pass*> PassManager::orderPasses() {
+	std::vector<Pass*> order;
+	std::set<std::string> ordered;
+
+	for (auto& pass : mPasses) {
+		for (auto& dependency : pass.dependencies) {
+			getPass(dependency);
+		}
+	}
+
+	//Take the first pass in the order they were added whose dependencies have been ordered
+	while (order.size() < mPasses.size()) {
+		Pass* next = nullptr;
+
+		for (auto& pass : mPasses) {
+			if (ordered.count(pass.name) > 0) {
+				continue;
+			}
+
+			bool isReady = true;
+			for (auto& dependency : pass.dependencies) {
+				isReady = isReady && ordered.count(dependency) > 0;
+			}
+
+			if (isReady) {
+				next = &pass;
+				break;
+			}
+		}
+
+		if (next == nullptr) {
+			throw std::runtime_error("The dependencies of the passes are cyclic.");
+		}
+
+		order.push_back(next);
+		ordered.insert(next->name);
+	}
+
+	return order;
+}
+
+bool PassManager::shouldRun(const Pass& pass, std::string unit) {
+	if (pass.level == 0) {
+		return true;
+	}
+
+	if (pass.level > mOptimizationLevel || mDisabledPasses.count(pass.name) > 0) {
+		return false;
+	}
+
+	mNumOptionalPasses++;
+
+	if (mBisectLimit < 0) {
+		return true;
+	}
+
+	bool isRunning = mNumOptionalPasses <= mBisectLimit;
+
+	mDumpStream
+		<< "BISECT: " << (isRunning ? "running" : "NOT running")
+		<< " pass (" << mNumOptionalPasses << ") " << pass.name << " on " << unit
+		<< std::endl;
+
+	return isRunning;
+}
+
+void PassManager::print(const std::set<std::string>& passes, std::string when, const Pass& pass,
+						std::function<void(std::ostream&)> printUnit) {
+	if (passes.count(pass.name) > 0) {
+		mDumpStream << "*** " << when << " " << pass.name << " ***" << std::endl;
+		printUnit(mDumpStream);
+		mDumpStream << std::endl;
+	}
+}
+
+void PassManager::run(std::shared_ptr<ProgramAST> programAST, CodeGenerator& codeGenerator) {
+	verifyOptions();
+
+	for (auto pass : orderPasses()) {
+		if (pass->kind == PassKind::Function) {
+			for (auto& function : codeGenerator.functions()) {
+				if (!shouldRun(*pass, function.signature())) {
+					continue;
+				}
+
+				auto printFunction = [&](std::ostream& os) {
+					function.outputGeneratedCode(os);
+				};
+
+				print(mPrintBefore, "Before", *pass, printFunction);
+				pass->time += measureTime([&]() {
+					pass->runFunction(function);
+				});
+				print(mPrintAfter, "After", *pass, printFunction);
+			}
+		} else if (shouldRun(*pass, "program")) {
+			//Passes on the AST print the program, the others print the generated code
+			auto printProgram = [&](std::ostream& os) {
+				if (pass->kind == PassKind::Program) {
+					os << programAST->asString() << std::endl;
+				} else {
+					codeGenerator.printGeneratedCode(os);
+				}
+			};
+
+			print(mPrintBefore, "Before", *pass, printProgram);
+			pass->time += measureTime([&]() {
+				if (pass->kind == PassKind::Program) {
+					pass->runProgram(programAST);
+				} else {
+					pass->runModule();
+				}
+			});
+			print(mPrintAfter, "After", *pass, printProgram);
+		}
+	}
+}
+
+void PassManager::printTimes(std::ostream& os) {
+	for (auto pass : orderPasses()) {
+		os << pass->name << ": " << std::fixed << std::setprecision(3) << pass->time * 1000 << " ms" << std::endl;
+	}
+}
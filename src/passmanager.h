@@ -0,0 +1,115 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <functional>
+#include <iostream>
+
+class ProgramAST;
+class GeneratedFunction;
+class CodeGenerator;
+
+//The kinds of passes
+enum class PassKind {
+	Program,
+	Module,
+	Function
+};
+
+//Represents a pass of the compiler. Program passes run on the AST, module passes on all generated functions
+//and function passes on each generated function.
+struct Pass {
+	std::string name;
+	PassKind kind;
+
+	//The lowest optimization level the pass runs at. Passes at level 0 are required.
+	int level;
+
+	//The passes that must run before this pass, if they run
+	std::vector<std::string> dependencies;
+
+	std::function<void(std::shared_ptr<ProgramAST>)> runProgram;
+	std::function<void()> runModule;
+	std::function<void(GeneratedFunction&)> runFunction;
+
+	//The time spent in the pass, in seconds
+	double time;
+};
+
+//Runs the passes of the compiler in the order given by their dependencies
+class PassManager {
+private:
+	std::vector<Pass> mPasses;
+	int mOptimizationLevel;
+	std::set<std::string> mDisabledPasses;
+	std::set<std::string> mPrintBefore;
+	std::set<std::string> mPrintAfter;
+	int mBisectLimit;
+	int mNumOptionalPasses;
+	std::ostream& mDumpStream;
+
+	//Adds the given pass
+	void addPass(Pass pass);
+
+	//Returns the pass with the given name
+	Pass& getPass(std::string name);
+
+	//Verifies that the passes given in the options exist, and that the disabled passes are optional
+	void verifyOptions();
+
+	//Returns the passes in the order they run
+	std::vector<Pass*> orderPasses();
+
+	//Indicates if the given pass should run on the given unit. Optional passes are counted for bisection.
+	bool shouldRun(const Pass& pass, std::string unit);
+
+	//Prints the given unit before or after the given pass, if requested
+	void print(const std::set<std::string>& passes, std::string when, const Pass& pass,
+			   std::function<void(std::ostream&)> printUnit);
+public:
+	//Creates a new pass manager. The dumps and bisection steps are written to the given stream.
+	PassManager(std::ostream& dumpStream = std::cerr);
+
+	//The optimization level used by default
+	static const int defaultOptimizationLevel;
+
+	//The highest optimization level
+	static const int maxOptimizationLevel;
+
+	//Adds a pass running on the program
+	void addProgramPass(std::string name, int level, std::vector<std::string> dependencies,
+						std::function<void(std::shared_ptr<ProgramAST>)> run);
+
+	//Adds a pass running once on all generated functions
+	void addModulePass(std::string name, int level, std::vector<std::string> dependencies, std::function<void()> run);
+
+	//Adds a pass running on each generated function
+	void addFunctionPass(std::string name, int level, std::vector<std::string> dependencies,
+						 std::function<void(GeneratedFunction&)> run);
+
+	//Returns the optimization level
+	int optimizationLevel() const;
+
+	//Sets the optimization level. Level 0 only runs the required passes, level 1 also the optimizations within functions
+	//and level 2 also inlines functions and optimizes loops and common subexpressions.
+	void setOptimizationLevel(int level);
+
+	//Disables the given optional pass
+	void disablePass(std::string name);
+
+	//Prints the program or functions before the given pass runs
+	void printBefore(std::string name);
+
+	//Prints the program or functions after the given pass has run
+	void printAfter(std::string name);
+
+	//Only runs the given number of optional passes, where each run on a function counts. A negative limit disables this.
+	void setBisectLimit(int limit);
+
+	//Runs the passes on the given program
+	void run(std::shared_ptr<ProgramAST> programAST, CodeGenerator& codeGenerator);
+
+	//Prints the time spent in each pass, in the order they ran
+	void printTimes(std::ostream& os);
+};
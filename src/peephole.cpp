@@ -0,0 +1,408 @@
+#include "peephole.h"
+#include "codegenerator.h"
+#include "statistics.h"
+
+#include <set>
+#include <cstdint>
+
+namespace {
+	//The instructions that only pushes a value
+	const std::set<std::string> pureLoadInstructions = {
+		"LDINT", "LDFLOAT", "LDCHAR", "LDTRUE", "LDFALSE", "LDNULL", "LDLOC", "LDARG"
+	};
+
+	//The branch instruction for each compare instruction
+	const std::map<std::string, std::string> compareBranches = {
+		{ "CMPEQ", "BEQ" }, { "CMPNE", "BNE" },
+		{ "CMPGT", "BGT" }, { "CMPGE", "BGE" },
+		{ "CMPLT", "BLT" }, { "CMPLE", "BLE" }
+	};
+
+	//The negated branch for each conditional branch
+	const std::map<std::string, std::string> negatedBranches = {
+		{ "BEQ", "BNE" }, { "BNE", "BEQ" },
+		{ "BGT", "BLE" }, { "BGE", "BLT" },
+		{ "BLT", "BGE" }, { "BLE", "BGT" }
+	};
+
+	//Indicates if the given instruction is 'LDINT 0'
+	bool isZeroInt(const PeepholeInstruction& inst) {
+		return inst.opCode == "LDINT" && inst.operand == "0";
+	}
+}
+
+//Peephole instruction
+PeepholeInstruction::PeepholeInstruction(std::string opCode, std::string operand)
+	: opCode(opCode), operand(operand), target(-1), isDeleted(false) {
+
+}
+
+PeepholeInstruction::PeepholeInstruction(std::string opCode, int target)
+	: opCode(opCode), operand(""), target(target), isDeleted(false) {
+
+}
+
+bool PeepholeInstruction::isBranch() const {
+	return target != -1;
+}
+
+bool PeepholeInstruction::isUnconditionalBranch() const {
+	return isBranch() && opCode == "BR";
+}
+
+bool PeepholeInstruction::endsBlock() const {
+	return isUnconditionalBranch() || opCode == "RET";
+}
+
+bool PeepholeInstruction::isPureLoad() const {
+	return pureLoadInstructions.count(opCode) > 0;
+}
+
+//Peephole function
+PeepholeFunction::PeepholeFunction(const GeneratedFunction& function) {
+	for (auto& instruction : function.instructions()) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			mInstructions.push_back(PeepholeInstruction(inst.first, std::stoi(inst.second)));
+		} else {
+			mInstructions.push_back(PeepholeInstruction(inst.first, inst.second));
+		}
+	}
+}
+
+int PeepholeFunction::size() const {
+	return mInstructions.size();
+}
+
+PeepholeInstruction& PeepholeFunction::at(int index) {
+	return mInstructions.at(index);
+}
+
+bool PeepholeFunction::isTarget(int index) const {
+	return mIsTarget.at(index);
+}
+
+int PeepholeFunction::loadCount(std::string local) const {
+	if (mLoadCounts.count(local) > 0) {
+		return mLoadCounts.at(local);
+	}
+
+	return 0;
+}
+
+int PeepholeFunction::previous(int index) const {
+	for (int i = index - 1; i >= 0; i--) {
+		if (!mInstructions[i].isDeleted) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void PeepholeFunction::replace(int index, int count, std::vector<PeepholeInstruction> replacement) {
+	for (int i = 0; i < count; i++) {
+		if (i < (int)replacement.size()) {
+			mInstructions[index + i] = replacement[i];
+		} else {
+			mInstructions[index + i].isDeleted = true;
+		}
+	}
+}
+
+void PeepholeFunction::beginPass() {
+	mIsTarget.assign(mInstructions.size() + 1, false);
+	mLoadCounts.clear();
+
+	for (auto& inst : mInstructions) {
+		if (inst.isBranch()) {
+			mIsTarget[inst.target] = true;
+		}
+
+		if (inst.opCode == "LDLOC") {
+			mLoadCounts[inst.operand]++;
+		}
+	}
+}
+
+void PeepholeFunction::endPass() {
+	//Map each index to the first non-deleted instruction at or after it
+	std::vector<int> newIndex(mInstructions.size() + 1);
+	int numLive = 0;
+
+	for (int i = 0; i < (int)mInstructions.size(); i++) {
+		newIndex[i] = numLive;
+
+		if (!mInstructions[i].isDeleted) {
+			numLive++;
+		}
+	}
+
+	newIndex[mInstructions.size()] = numLive;
+
+	std::vector<PeepholeInstruction> instructions;
+	instructions.reserve(numLive);
+
+	for (auto& inst : mInstructions) {
+		if (!inst.isDeleted) {
+			instructions.push_back(inst);
+
+			if (inst.isBranch()) {
+				instructions.back().target = newIndex[inst.target];
+			}
+		}
+	}
+
+	mInstructions = std::move(instructions);
+}
+
+void PeepholeFunction::store(GeneratedFunction& function) const {
+	std::vector<std::string> instructions;
+
+	for (auto& inst : mInstructions) {
+		if (inst.isBranch()) {
+			instructions.push_back(inst.opCode + " " + std::to_string(inst.target));
+		} else if (inst.operand != "") {
+			instructions.push_back(inst.opCode + " " + inst.operand);
+		} else {
+			instructions.push_back(inst.opCode);
+		}
+	}
+
+	function.replaceInstructions(instructions);
+}
+
+//Peephole optimizer
+PeepholeOptimizer::PeepholeOptimizer(Statistics& statistics)
+	: mRules(defaultRules()), mStatistics(statistics) {
+	for (auto& rule : mRules) {
+		mStatistics.add("peephole." + rule.name, 0);
+	}
+}
+
+const std::vector<PeepholeRule>& PeepholeOptimizer::rules() const {
+	return mRules;
+}
+
+void PeepholeOptimizer::optimize(GeneratedFunction& function) {
+	PeepholeFunction peepholeFunc(function);
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+		peepholeFunc.beginPass();
+
+		int i = 0;
+		while (i < peepholeFunc.size()) {
+			bool applied = false;
+
+			for (auto& rule : mRules) {
+				if (i + rule.windowSize > peepholeFunc.size()) {
+					continue;
+				}
+
+				//Only the first instruction in the window may be a branch target
+				bool isBasicBlock = true;
+				for (int j = i + 1; j < i + rule.windowSize; j++) {
+					if (peepholeFunc.isTarget(j)) {
+						isBasicBlock = false;
+						break;
+					}
+				}
+
+				if (isBasicBlock && rule.apply(peepholeFunc, i)) {
+					mStatistics.add("peephole." + rule.name);
+					i += rule.windowSize;
+					applied = true;
+					changed = true;
+					break;
+				}
+			}
+
+			if (!applied) {
+				i++;
+			}
+		}
+
+		peepholeFunc.endPass();
+	}
+
+	peepholeFunc.store(function);
+}
+
+std::vector<PeepholeRule> PeepholeOptimizer::defaultRules() {
+	std::vector<PeepholeRule> rules;
+
+	//a + (0 - x) -> a - x
+	rules.push_back({ "negate-add", 4, [](PeepholeFunction& func, int i) {
+		if (isZeroInt(func.at(i)) && func.at(i + 1).isPureLoad()
+			&& func.at(i + 2).opCode == "SUB" && func.at(i + 3).opCode == "ADD") {
+			func.replace(i, 4, { func.at(i + 1), PeepholeInstruction("SUB") });
+			return true;
+		}
+
+		return false;
+	} });
+
+	//a - (0 - x) -> a + x
+	rules.push_back({ "negate-sub", 4, [](PeepholeFunction& func, int i) {
+		if (isZeroInt(func.at(i)) && func.at(i + 1).isPureLoad()
+			&& func.at(i + 2).opCode == "SUB" && func.at(i + 3).opCode == "SUB") {
+			func.replace(i, 4, { func.at(i + 1), PeepholeInstruction("ADD") });
+			return true;
+		}
+
+		return false;
+	} });
+
+	//CMPxx; LDTRUE; BEQ/BNE -> Bxx
+	rules.push_back({ "compare-branch", 3, [](PeepholeFunction& func, int i) {
+		auto& compare = func.at(i);
+		auto& branch = func.at(i + 2);
+
+		if (compareBranches.count(compare.opCode) > 0 && func.at(i + 1).opCode == "LDTRUE"
+			&& (branch.opCode == "BEQ" || branch.opCode == "BNE")) {
+			auto branchOpCode = compareBranches.at(compare.opCode);
+
+			if (branch.opCode == "BNE") {
+				branchOpCode = negatedBranches.at(branchOpCode);
+			}
+
+			func.replace(i, 3, { PeepholeInstruction(branchOpCode, branch.target) });
+			return true;
+		}
+
+		return false;
+	} });
+
+	//NOT; LDTRUE; BEQ/BNE -> LDTRUE; BNE/BEQ
+	rules.push_back({ "not-branch", 3, [](PeepholeFunction& func, int i) {
+		auto& branch = func.at(i + 2);
+
+		if (func.at(i).opCode == "NOT" && func.at(i + 1).opCode == "LDTRUE"
+			&& (branch.opCode == "BEQ" || branch.opCode == "BNE")) {
+			func.replace(i, 3, {
+				PeepholeInstruction("LDTRUE"),
+				PeepholeInstruction(negatedBranches.at(branch.opCode), branch.target)
+			});
+			return true;
+		}
+
+		return false;
+	} });
+
+	//LDINT 0; LDINT c; SUB -> LDINT -c
+	rules.push_back({ "negate-constant", 3, [](PeepholeFunction& func, int i) {
+		if (isZeroInt(func.at(i)) && func.at(i + 1).opCode == "LDINT" && func.at(i + 2).opCode == "SUB") {
+			auto value = (std::uint32_t)std::stoi(func.at(i + 1).operand);
+			auto negated = (std::int32_t)(0u - value);
+			func.replace(i, 3, { PeepholeInstruction("LDINT", std::to_string(negated)) });
+			return true;
+		}
+
+		return false;
+	} });
+
+	//STLOC n; LDLOC n -> nothing, if the local is not loaded anywhere else
+	rules.push_back({ "store-load", 2, [](PeepholeFunction& func, int i) {
+		auto& store = func.at(i);
+		auto& load = func.at(i + 1);
+
+		if (store.opCode == "STLOC" && load.opCode == "LDLOC" && store.operand == load.operand
+			&& func.loadCount(load.operand) == 1) {
+			func.replace(i, 2, {});
+			return true;
+		}
+
+		return false;
+	} });
+
+	//LDLOC n; STLOC n -> nothing, which happens when locals share slot
+	rules.push_back({ "self-move", 2, [](PeepholeFunction& func, int i) {
+		auto& load = func.at(i);
+		auto& store = func.at(i + 1);
+
+		if (load.opCode == "LDLOC" && store.opCode == "STLOC" && load.operand == store.operand) {
+			func.replace(i, 2, {});
+			return true;
+		}
+
+		return false;
+	} });
+
+	//Loading a value that is popped directly
+	rules.push_back({ "load-pop", 2, [](PeepholeFunction& func, int i) {
+		if (func.at(i).isPureLoad() && func.at(i + 1).opCode == "POP") {
+			func.replace(i, 2, {});
+			return true;
+		}
+
+		return false;
+	} });
+
+	//Branches to unconditional branches are retargeted to the final target
+	rules.push_back({ "branch-chain", 1, [](PeepholeFunction& func, int i) {
+		auto& branch = func.at(i);
+
+		if (branch.isBranch() && branch.target < func.size()) {
+			auto& targetInst = func.at(branch.target);
+
+			if (!targetInst.isDeleted && targetInst.isUnconditionalBranch() && targetInst.target != branch.target) {
+				branch.target = targetInst.target;
+				return true;
+			}
+		}
+
+		return false;
+	} });
+
+	//BR to RET -> RET
+	rules.push_back({ "branch-return", 1, [](PeepholeFunction& func, int i) {
+		auto& branch = func.at(i);
+
+		if (branch.isUnconditionalBranch() && branch.target < func.size()) {
+			auto& targetInst = func.at(branch.target);
+
+			if (!targetInst.isDeleted && targetInst.opCode == "RET") {
+				func.replace(i, 1, { PeepholeInstruction("RET") });
+				return true;
+			}
+		}
+
+		return false;
+	} });
+
+	//BR to the next instruction
+	rules.push_back({ "branch-next", 1, [](PeepholeFunction& func, int i) {
+		auto& branch = func.at(i);
+
+		if (branch.isUnconditionalBranch() && branch.target == i + 1) {
+			func.replace(i, 1, {});
+			return true;
+		}
+
+		return false;
+	} });
+
+	//Instructions after an unconditional branch or return, which are not branch targets, are never executed
+	rules.push_back({ "unreachable", 1, [](PeepholeFunction& func, int i) {
+		int prev = func.previous(i);
+
+		if (prev == -1 || !func.at(prev).endsBlock()) {
+			return false;
+		}
+
+		//Branches to removed instructions refer to the next instruction
+		for (int j = prev + 1; j <= i; j++) {
+			if (func.isTarget(j)) {
+				return false;
+			}
+		}
+
+		func.replace(i, 1, {});
+		return true;
+	} });
+
+	return rules;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+
+class GeneratedFunction;
+class Statistics;
+
+//Represents an instruction in the peephole optimizer
+struct PeepholeInstruction {
+	std::string opCode;
+	std::string operand;
+	int target;
+	bool isDeleted;
+
+	//Creates a new non-branch instruction
+	PeepholeInstruction(std::string opCode, std::string operand = "");
+
+	//Creates a new branch instruction to the given target
+	PeepholeInstruction(std::string opCode, int target);
+
+	//Indicates if the instruction is a branch
+	bool isBranch() const;
+
+	//Indicates if the instruction is an unconditional branch
+	bool isUnconditionalBranch() const;
+
+	//Indicates if the instruction is never followed by the next instruction
+	bool endsBlock() const;
+
+	//Indicates if the instruction only pushes a value without any side effects
+	bool isPureLoad() const;
+};
+
+//Represents the instructions of a function being optimized.
+//Within a pass, removed instructions are only marked as deleted, so that branch targets remain valid.
+class PeepholeFunction {
+private:
+	std::vector<PeepholeInstruction> mInstructions;
+	std::vector<bool> mIsTarget;
+	std::map<std::string, int> mLoadCounts;
+public:
+	//Creates a new peephole function from the given function
+	PeepholeFunction(const GeneratedFunction& function);
+
+	//Returns the number of instructions, including deleted
+	int size() const;
+
+	//Returns the instruction at the given index
+	PeepholeInstruction& at(int index);
+
+	//Indicates if the given instruction is the target of a branch
+	bool isTarget(int index) const;
+
+	//Returns the number of loads of the given local in the function
+	int loadCount(std::string local) const;
+
+	//Returns the index of the closest instruction before the given one that is not deleted, or -1
+	int previous(int index) const;
+
+	//Replaces the given number of instructions starting at the given index
+	void replace(int index, int count, std::vector<PeepholeInstruction> replacement);
+
+	//Computes branch targets and local usages. Must be called before each pass.
+	void beginPass();
+
+	//Removes the deleted instructions and retargets the branches
+	void endPass();
+
+	//Stores the instructions in the given function
+	void store(GeneratedFunction& function) const;
+};
+
+//Represents a peephole rule
+struct PeepholeRule {
+	std::string name;
+	int windowSize;
+
+	//Tries to apply the rule on the window starting at the given index. Returns true if applied.
+	std::function<bool(PeepholeFunction& function, int index)> apply;
+};
+
+//Represents a peephole optimizer that works on the generated instructions of a function
+class PeepholeOptimizer {
+private:
+	std::vector<PeepholeRule> mRules;
+	Statistics& mStatistics;
+public:
+	//Creates a new peephole optimizer using the default rules
+	PeepholeOptimizer(Statistics& statistics);
+
+	//Returns the rules
+	const std::vector<PeepholeRule>& rules() const;
+
+	//Optimizes the given function
+	void optimize(GeneratedFunction& function);
+
+	//The default rules
+	static std::vector<PeepholeRule> defaultRules();
+};
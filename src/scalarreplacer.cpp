@@ -0,0 +1,463 @@
+#include "scalarreplacer.h"
+#include "codegenerator.h"
+#include "instructioninfo.h"
+#include "localallocator.h"
+#include "statistics.h"
+#include "object.h"
+#include "type.h"
+
+#include <algorithm>
+#include <set>
+
+namespace {
+	//Returns the owner class of the given member reference, which is of the form 'class::member'
+	std::string memberClass(const std::string& member) {
+		return member.substr(0, member.find("::"));
+	}
+
+	//Returns the name of the given member reference
+	std::string memberName(const std::string& member) {
+		return member.substr(member.find("::") + 2);
+	}
+
+	//Returns the instruction that loads the default value of the given type, which is the value of new fields
+	std::string defaultValue(std::shared_ptr<Type> type) {
+		auto name = type->name();
+
+		if (name == "Int") {
+			return "LDINT 0";
+		} else if (name == "Float") {
+			return "LDFLOAT 0";
+		} else if (name == "Char") {
+			return "LDCHAR 0";
+		} else if (name == "Bool") {
+			return "LDFALSE";
+		} else {
+			return "LDNULL";
+		}
+	}
+
+	//Returns the instructions that start a block
+	std::vector<bool> blockStarts(const GeneratedFunction& function) {
+		std::vector<bool> isStart(function.numInstructions() + 1, false);
+		isStart[0] = true;
+
+		for (int i = 0; i < function.numInstructions(); i++) {
+			auto inst = Instructions::split(function.instructions()[i]);
+
+			if (Instructions::isBranch(inst.first)) {
+				isStart[std::stoi(inst.second)] = true;
+				isStart[i + 1] = true;
+			} else if (inst.first == "RET") {
+				isStart[i + 1] = true;
+			}
+		}
+
+		return isStart;
+	}
+}
+
+ScalarReplacer::ScalarReplacer(InstructionInfo& instructionInfo, Statistics& statistics)
+	: mInstructionInfo(instructionInfo), mStatistics(statistics), mNumReplaced(0) {
+	mStatistics.add("scalars.replaced", 0);
+	mStatistics.add("scalars.escaped", 0);
+}
+
+bool ScalarReplacer::followStack(const GeneratedFunction& function, std::vector<Consumer>& consumers,
+								 std::vector<std::vector<int>>& operands) const {
+	auto isStart = blockStarts(function);
+	consumers.assign(function.numInstructions(), { -1, -1 });
+	operands.assign(function.numInstructions(), {});
+
+	//The instruction that pushed each value on the stack, or -1 if it pushed more than one value
+	std::vector<int> stack;
+
+	for (int i = 0; i < function.numInstructions(); i++) {
+		if (isStart[i]) {
+			stack.clear();
+		}
+
+		auto effect = mInstructionInfo.stackEffect(function, function.instructions()[i]);
+
+		if (effect.pops > (int)stack.size()) {
+			return false;
+		}
+
+		for (int j = 0; j < effect.pops; j++) {
+			int producer = stack[stack.size() - effect.pops + j];
+			operands[i].push_back(producer);
+
+			if (producer != -1) {
+				consumers[producer] = { i, j };
+			}
+		}
+
+		stack.resize(stack.size() - effect.pops);
+
+		for (int j = 0; j < effect.pushes; j++) {
+			stack.push_back(effect.pushes == 1 ? i : -1);
+		}
+	}
+
+	return true;
+}
+
+bool ScalarReplacer::canExpand(const GeneratedFunction& constructor) const {
+	//The body must be a single block ending with the only return, as for inlined functions
+	auto& instructions = constructor.instructions();
+	int size = instructions.size();
+
+	for (int i = 0; i < size; i++) {
+		auto opCode = Instructions::split(instructions[i]).first;
+
+		if (Instructions::isBranch(opCode) || (opCode == "RET" && i != size - 1)) {
+			return false;
+		}
+	}
+
+	auto liveAtEntry = LocalAllocator::liveLocals(constructor)[0];
+	if (std::find(liveAtEntry.begin(), liveAtEntry.end(), true) != liveAtEntry.end()) {
+		return false;
+	}
+
+	std::vector<Consumer> consumers;
+	std::vector<std::vector<int>> operands;
+
+	if (!followStack(constructor, consumers, operands)) {
+		return false;
+	}
+
+	//The object may only be used to access its own fields
+	auto className = memberClass(constructor.name());
+
+	for (int i = 0; i < size; i++) {
+		if (instructions[i] != "LDARG 0") {
+			continue;
+		}
+
+		auto consumer = consumers[i];
+
+		if (consumer.index == -1 || consumer.operand != 0) {
+			return false;
+		}
+
+		auto inst = Instructions::split(instructions[consumer.index]);
+
+		if ((inst.first != "LDFIELD" && inst.first != "STFIELD") || memberClass(inst.second) != className) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ScalarReplacer::expand(GeneratedFunction& function, const GeneratedFunction& constructor,
+							const std::map<std::string, int>& fieldLocals, std::vector<std::string>& instructions) {
+	auto prefix = "$replaced" + std::to_string(mNumReplaced) + "$";
+	mNumReplaced++;
+
+	//The arguments are on the stack, with the last one on top. The object reference is not passed.
+	auto& parameters = constructor.parameters();
+	std::vector<int> parameterLocals(parameters.size(), -1);
+
+	for (int i = 1; i < (int)parameters.size(); i++) {
+		parameterLocals[i] = function.newLocal(prefix + parameters[i].name, parameters[i].type);
+	}
+
+	for (int i = parameters.size() - 1; i >= 1; i--) {
+		instructions.push_back("STLOC " + std::to_string(parameterLocals[i]));
+	}
+
+	//The fields of a new object have the default values, which also resets them when allocating in a loop
+	auto& objectLayout = mClasses.at(memberClass(constructor.name()))->objectLayout();
+
+	for (auto& field : fieldLocals) {
+		instructions.push_back(defaultValue(objectLayout.getField(field.first).type()));
+		instructions.push_back("STLOC " + std::to_string(field.second));
+	}
+
+	std::map<int, int> localMapping;
+	for (auto& local : constructor.locals()) {
+		if (localMapping.count(local.second.first) == 0) {
+			localMapping[local.second.first] = function.newLocal(prefix + local.first, local.second.second);
+		}
+	}
+
+	std::vector<Consumer> consumers;
+	std::vector<std::vector<int>> operands;
+	followStack(constructor, consumers, operands);
+
+	//The return is the last instruction
+	for (int i = 0; i < constructor.numInstructions() - 1; i++) {
+		auto& instruction = constructor.instructions()[i];
+		auto inst = Instructions::split(instruction);
+
+		if (instruction == "LDARG 0") {
+			continue;
+		}
+
+		if (inst.first == "LDARG") {
+			instructions.push_back("LDLOC " + std::to_string(parameterLocals[std::stoi(inst.second)]));
+		} else if (inst.first == "LDLOC" || inst.first == "STLOC") {
+			instructions.push_back(inst.first + " " + std::to_string(localMapping[std::stoi(inst.second)]));
+		} else if ((inst.first == "LDFIELD" || inst.first == "STFIELD")
+				   && operands[i][0] != -1 && constructor.instructions()[operands[i][0]] == "LDARG 0") {
+			auto opCode = inst.first == "LDFIELD" ? "LDLOC " : "STLOC ";
+			instructions.push_back(opCode + std::to_string(fieldLocals.at(memberName(inst.second))));
+		} else {
+			instructions.push_back(instruction);
+		}
+	}
+}
+
+void ScalarReplacer::replaceObjects(GeneratedFunction& function) {
+	std::vector<Consumer> consumers;
+	std::vector<std::vector<int>> operands;
+
+	if (!followStack(function, consumers, operands)) {
+		return;
+	}
+
+	auto& instructions = function.instructions();
+	int size = instructions.size();
+	auto isStart = blockStarts(function);
+	auto liveLocals = LocalAllocator::liveLocals(function);
+
+	std::map<int, std::vector<int>> stores;
+	std::map<int, std::vector<int>> loads;
+
+	for (int i = 0; i < size; i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (inst.first == "STLOC") {
+			stores[std::stoi(inst.second)].push_back(i);
+		} else if (inst.first == "LDLOC") {
+			loads[std::stoi(inst.second)].push_back(i);
+		}
+	}
+
+	//The locals that are only assigned new objects, which are the roots, and the locals that are only assigned copies of a root
+	std::map<int, int> rootOf;
+	std::map<int, std::string> rootClass;
+	std::map<std::string, bool> expandable;
+
+	for (auto& local : stores) {
+		std::string className = "";
+		bool isRoot = !liveLocals[0][local.first];
+
+		for (int store : local.second) {
+			if (!isRoot || operands[store][0] != store - 1) {
+				isRoot = false;
+				break;
+			}
+
+			auto allocation = Instructions::split(instructions[store - 1]);
+			auto constructor = mConstructors.find(allocation.second);
+
+			if (allocation.first != "NEWOBJ" || constructor == mConstructors.end()
+				|| (!className.empty() && memberClass(allocation.second) != className)) {
+				isRoot = false;
+				break;
+			}
+
+			if (expandable.count(allocation.second) == 0) {
+				expandable[allocation.second] = canExpand(*constructor->second);
+			}
+
+			isRoot = expandable[allocation.second];
+			className = memberClass(allocation.second);
+		}
+
+		if (isRoot) {
+			rootOf[local.first] = local.first;
+			rootClass[local.first] = className;
+		}
+	}
+
+	//Inlined member functions copy the object to a local that is only used within the block
+	bool changed = true;
+	while (changed) {
+		changed = false;
+
+		for (auto& local : stores) {
+			if (rootOf.count(local.first) > 0) {
+				continue;
+			}
+
+			int root = -1;
+			bool isCopy = true;
+
+			for (int store : local.second) {
+				int producer = operands[store][0];
+				auto inst = producer != -1 ? Instructions::split(instructions[producer]) : std::make_pair(std::string(""), std::string(""));
+
+				if (inst.first != "LDLOC" || rootOf.count(std::stoi(inst.second)) == 0
+					|| (root != -1 && rootOf[std::stoi(inst.second)] != root)) {
+					isCopy = false;
+					break;
+				}
+
+				root = rootOf[std::stoi(inst.second)];
+			}
+
+			for (int i = 0; i < size && isCopy; i++) {
+				if (isStart[i] && liveLocals[i][local.first]) {
+					isCopy = false;
+				}
+			}
+
+			//The root must not be assigned a new object between the copy and the uses of the copy
+			for (int load : loads[local.first]) {
+				if (!isCopy) {
+					break;
+				}
+
+				int store = load - 1;
+				while (store >= 0 && instructions[store] != "STLOC " + std::to_string(local.first)) {
+					store--;
+				}
+
+				if (store < 0) {
+					isCopy = false;
+					break;
+				}
+
+				for (int i = operands[store][0] + 1; i < load; i++) {
+					if (instructions[i] == "STLOC " + std::to_string(root)) {
+						isCopy = false;
+					}
+				}
+			}
+
+			if (isCopy) {
+				rootOf[local.first] = root;
+				changed = true;
+			}
+		}
+	}
+
+	//The loads must only be used to access fields or to make copies
+	std::set<int> escaped;
+
+	for (auto& local : rootOf) {
+		int root = local.second;
+
+		for (int load : loads[local.first]) {
+			auto consumer = consumers[load];
+			auto inst = consumer.index != -1 ? Instructions::split(instructions[consumer.index]) : std::make_pair(std::string(""), std::string(""));
+
+			bool isFieldAccess = (inst.first == "LDFIELD" || inst.first == "STFIELD")
+								 && consumer.operand == 0 && memberClass(inst.second) == rootClass[root];
+			bool isCopy = inst.first == "STLOC" && rootOf.count(std::stoi(inst.second)) > 0
+						  && rootOf[std::stoi(inst.second)] == root;
+
+			if (!isFieldAccess && !isCopy) {
+				escaped.insert(root);
+			}
+		}
+	}
+
+	mStatistics.add("scalars.escaped", escaped.size());
+
+	//The locals holding the fields of each replaced object
+	std::map<int, std::map<std::string, int>> fieldLocals;
+
+	for (auto& root : rootClass) {
+		if (escaped.count(root.first) > 0) {
+			continue;
+		}
+
+		auto prefix = "$replaced" + std::to_string(mNumReplaced) + "$";
+		mNumReplaced++;
+
+		//The fields are sorted, so that the locals are created in the same order
+		auto& objectLayout = mClasses.at(root.second)->objectLayout();
+		std::vector<std::string> fieldNames;
+
+		for (auto& field : objectLayout.fields()) {
+			fieldNames.push_back(field.first);
+		}
+
+		std::sort(fieldNames.begin(), fieldNames.end());
+
+		for (auto& field : fieldNames) {
+			fieldLocals[root.first][field] = function.newLocal(prefix + field, objectLayout.getField(field).type());
+		}
+	}
+
+	if (fieldLocals.empty()) {
+		return;
+	}
+
+	//Returns the replaced object that the given instruction loads or stores, or -1
+	auto replacedRoot = [&](int index) {
+		auto inst = Instructions::split(instructions[index]);
+
+		if ((inst.first == "LDLOC" || inst.first == "STLOC") && rootOf.count(std::stoi(inst.second)) > 0
+			&& fieldLocals.count(rootOf[std::stoi(inst.second)]) > 0) {
+			return rootOf[std::stoi(inst.second)];
+		}
+
+		return -1;
+	};
+
+	std::vector<std::string> newInstructions;
+	std::vector<int> newIndices;
+
+	for (int i = 0; i < size; i++) {
+		newIndices.push_back(newInstructions.size());
+		auto inst = Instructions::split(instructions[i]);
+
+		//The allocation is replaced by the constructor, and the loads, stores and copies of the object are removed
+		if (replacedRoot(i) != -1) {
+			continue;
+		}
+
+		if (inst.first == "NEWOBJ" && consumers[i].index != -1 && replacedRoot(consumers[i].index) != -1) {
+			expand(function, *mConstructors.at(inst.second), fieldLocals[replacedRoot(consumers[i].index)], newInstructions);
+			mStatistics.add("scalars.replaced");
+			continue;
+		}
+
+		if ((inst.first == "LDFIELD" || inst.first == "STFIELD") && operands[i][0] != -1 && replacedRoot(operands[i][0]) != -1) {
+			auto opCode = inst.first == "LDFIELD" ? "LDLOC " : "STLOC ";
+			auto& fields = fieldLocals[replacedRoot(operands[i][0])];
+			newInstructions.push_back(opCode + std::to_string(fields.at(memberName(inst.second))));
+			continue;
+		}
+
+		newInstructions.push_back(instructions[i]);
+	}
+
+	newIndices.push_back(newInstructions.size());
+
+	for (auto& instruction : newInstructions) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			instruction = inst.first + " " + std::to_string(newIndices[std::stoi(inst.second)]);
+		}
+	}
+
+	function.replaceInstructions(newInstructions);
+}
+
+void ScalarReplacer::replace(std::vector<GeneratedFunction>& functions, const std::vector<GeneratedClass>& classes) {
+	mConstructors.clear();
+	mClasses.clear();
+
+	for (auto& classDef : classes) {
+		mClasses[classDef.name()] = &classDef;
+	}
+
+	for (auto& func : functions) {
+		if (func.isMemberFunction() && func.name().find("::.constructor") != std::string::npos
+			&& mClasses.count(memberClass(func.name())) > 0) {
+			mConstructors[func.signature()] = &func;
+		}
+	}
+
+	for (auto& func : functions) {
+		replaceObjects(func);
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+
+class GeneratedFunction;
+class GeneratedClass;
+class InstructionInfo;
+class Statistics;
+
+//Replaces objects that do not escape the function creating them by one local per field, which removes the allocation
+//and the field accesses. An object escapes if it is stored to a field or array, returned, compared or passed to a call,
+//so it must run after inlining. Copies of the object created by inlined member functions are replaced as well.
+class ScalarReplacer {
+private:
+	//The instruction consuming a value on the stack, and the position of the value among its operands from the bottom
+	struct Consumer {
+		int index;
+		int operand;
+	};
+
+	InstructionInfo& mInstructionInfo;
+	Statistics& mStatistics;
+	std::map<std::string, const GeneratedFunction*> mConstructors;
+	std::map<std::string, const GeneratedClass*> mClasses;
+	int mNumReplaced;
+
+	//Finds the consumer of the value pushed by each instruction, and the producers of the operands of each instruction.
+	//False if the stack cannot be followed within the blocks.
+	bool followStack(const GeneratedFunction& function, std::vector<Consumer>& consumers, std::vector<std::vector<int>>& operands) const;
+
+	//Indicates if the given constructor can be expanded in place of the allocation. The constructor must be a single block
+	//that only uses the object to access its fields.
+	bool canExpand(const GeneratedFunction& constructor) const;
+
+	//Adds the expanded constructor for the allocation to the given instructions, where the fields are stored in the given locals
+	void expand(GeneratedFunction& function, const GeneratedFunction& constructor, const std::map<std::string, int>& fieldLocals,
+				std::vector<std::string>& instructions);
+
+	//Replaces the objects that do not escape in the given function
+	void replaceObjects(GeneratedFunction& function);
+public:
+	//Creates a new scalar replacer
+	ScalarReplacer(InstructionInfo& instructionInfo, Statistics& statistics);
+
+	//Replaces the objects that do not escape in the given functions
+	void replace(std::vector<GeneratedFunction>& functions, const std::vector<GeneratedClass>& classes);
+};
@@ -0,0 +1,370 @@
+#include "specializer.h"
+#include "codegenerator.h"
+#include "instructioninfo.h"
+#include "treeshaker.h"
+#include "peephole.h"
+#include "statistics.h"
+
+#include <set>
+
+namespace {
+	//Returns the kind of constant the given instruction loads, which is empty if it is not a constant that can be folded
+	std::string constantKind(const std::string& instruction) {
+		auto opCode = Instructions::split(instruction).first;
+
+		if (opCode == "LDINT") {
+			return "Int";
+		} else if (opCode == "LDCHAR") {
+			return "Char";
+		} else if (opCode == "LDTRUE" || opCode == "LDFALSE") {
+			return "Bool";
+		}
+
+		return "";
+	}
+
+	//Returns the kind of the result of folding the given operation of the given constants, or empty if it cannot be folded
+	std::string foldedKind(const std::string& opCode, const std::vector<std::string>& operands) {
+		if (opCode == "NOT") {
+			return operands[0] == "Bool" ? "Bool" : "";
+		}
+
+		if (operands.size() != 2 || operands[0].empty() || operands[0] != operands[1]) {
+			return "";
+		}
+
+		bool isEquality = opCode == "CMPEQ" || opCode == "CMPNE" || opCode == "BEQ" || opCode == "BNE";
+
+		if (opCode == "ADD" || opCode == "SUB" || opCode == "MUL" || opCode == "DIV") {
+			return operands[0] == "Int" ? "Int" : "";
+		} else if (opCode.find("CMP") == 0 || (Instructions::isBranch(opCode) && opCode != "BR")) {
+			return operands[0] != "Bool" || isEquality ? "Bool" : "";
+		}
+
+		return "";
+	}
+
+	//Returns the instructions that start a block
+	std::vector<bool> blockStarts(const GeneratedFunction& function) {
+		std::vector<bool> isStart(function.numInstructions() + 1, false);
+		isStart[0] = true;
+
+		for (int i = 0; i < function.numInstructions(); i++) {
+			auto inst = Instructions::split(function.instructions()[i]);
+
+			if (Instructions::isBranch(inst.first)) {
+				isStart[std::stoi(inst.second)] = true;
+				isStart[i + 1] = true;
+			} else if (inst.first == "RET") {
+				isStart[i + 1] = true;
+			}
+		}
+
+		return isStart;
+	}
+}
+
+Specializer::Specializer(InstructionInfo& instructionInfo, const TreeShaker& treeShaker, Statistics& statistics)
+	: mInstructionInfo(instructionInfo), mTreeShaker(treeShaker), mStatistics(statistics) {
+	mStatistics.add("specialize.propagated", 0);
+	mStatistics.add("specialize.clones", 0);
+	mStatistics.add("specialize.calls", 0);
+	mStatistics.add("specialize.budget", 0);
+}
+
+const int Specializer::maxSize = 200;
+const int Specializer::maxGrowth = 1000;
+const int Specializer::maxClones = 4;
+
+std::vector<Specializer::Call> Specializer::findCalls(const GeneratedFunction& function) const {
+	std::vector<Call> calls;
+	auto isStart = blockStarts(function);
+
+	//The instruction that pushed each value on the stack, or -1 if it was computed from other values
+	std::vector<int> stack;
+
+	for (int i = 0; i < function.numInstructions(); i++) {
+		auto& instruction = function.instructions()[i];
+		auto inst = Instructions::split(instruction);
+
+		if (isStart[i]) {
+			stack.clear();
+		}
+
+		auto effect = mInstructionInfo.stackEffect(function, instruction);
+
+		if (effect.pops > (int)stack.size()) {
+			return {};
+		}
+
+		if (inst.first == "CALL") {
+			Call call;
+			call.index = i;
+			call.signature = inst.second;
+
+			for (int j = (int)stack.size() - effect.pops; j < (int)stack.size(); j++) {
+				call.producers.push_back(stack[j]);
+				call.loads.push_back(stack[j] != -1 ? function.instructions()[stack[j]] : "");
+			}
+
+			calls.push_back(call);
+		}
+
+		stack.resize(stack.size() - effect.pops);
+
+		for (int j = 0; j < effect.pushes; j++) {
+			stack.push_back(effect.pops == 0 && effect.pushes == 1 ? i : -1);
+		}
+	}
+
+	return calls;
+}
+
+int Specializer::numFoldedBranches(const GeneratedFunction& function, const std::map<int, std::string>& constants) const {
+	auto isStart = blockStarts(function);
+	int numFolded = 0;
+
+	//The kind of constant of each value on the stack, or empty if not constant
+	std::vector<std::string> stack;
+
+	for (int i = 0; i < function.numInstructions(); i++) {
+		auto& instruction = function.instructions()[i];
+		auto inst = Instructions::split(instruction);
+
+		if (isStart[i]) {
+			stack.clear();
+		}
+
+		auto effect = mInstructionInfo.stackEffect(function, instruction);
+
+		if (effect.pops > (int)stack.size()) {
+			return 0;
+		}
+
+		std::vector<std::string> operands(stack.end() - effect.pops, stack.end());
+		stack.resize(stack.size() - effect.pops);
+		std::string kind = "";
+
+		if (inst.first == "LDARG" && constants.count(std::stoi(inst.second)) > 0) {
+			kind = constantKind(constants.at(std::stoi(inst.second)));
+		} else if (effect.pops == 0) {
+			kind = constantKind(instruction);
+		} else {
+			kind = foldedKind(inst.first, operands);
+
+			if (!kind.empty() && Instructions::isBranch(inst.first)) {
+				numFolded++;
+			}
+		}
+
+		for (int j = 0; j < effect.pushes; j++) {
+			stack.push_back(kind);
+		}
+	}
+
+	return numFolded;
+}
+
+bool Specializer::passesOtherConstants(const GeneratedFunction& function, const std::map<int, std::string>& constants) const {
+	for (auto& call : findCalls(function)) {
+		if (call.signature != function.signature()) {
+			continue;
+		}
+
+		for (auto& constant : constants) {
+			if (call.loads[constant.first] != "LDARG " + std::to_string(constant.first)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void Specializer::replaceParameters(GeneratedFunction& function, const std::map<int, std::string>& constants) {
+	for (int i = 0; i < function.numInstructions(); i++) {
+		auto inst = Instructions::split(function.instruction(i));
+
+		if (inst.first == "LDARG" && constants.count(std::stoi(inst.second)) > 0) {
+			function.instruction(i) = constants.at(std::stoi(inst.second));
+		}
+	}
+}
+
+void Specializer::propagateConstants(std::vector<GeneratedFunction>& functions) {
+	std::map<std::string, std::vector<std::pair<const GeneratedFunction*, Call>>> callsOf;
+
+	for (auto& function : functions) {
+		for (auto& call : findCalls(function)) {
+			callsOf[call.signature].push_back({ &function, call });
+		}
+	}
+
+	for (auto& function : functions) {
+		auto& calls = callsOf[function.signature()];
+
+		//Entry points can be called with other arguments
+		if (function.isMemberFunction() || mTreeShaker.isEntryPoint(function) || calls.empty()) {
+			continue;
+		}
+
+		std::map<int, std::string> constants;
+
+		for (int parameter = 0; parameter < (int)function.parameters().size(); parameter++) {
+			std::string constant = "";
+			bool isSame = true;
+
+			for (auto& call : calls) {
+				auto& load = call.second.loads[parameter];
+
+				//A recursive call can pass the parameter on
+				if (call.first == &function && load == "LDARG " + std::to_string(parameter)) {
+					continue;
+				}
+
+				if (constantKind(load).empty() || (!constant.empty() && load != constant)) {
+					isSame = false;
+					break;
+				}
+
+				constant = load;
+			}
+
+			if (isSame && !constant.empty()) {
+				constants[parameter] = constant;
+			}
+		}
+
+		replaceParameters(function, constants);
+		mStatistics.add("specialize.propagated", constants.size());
+	}
+}
+
+GeneratedFunction Specializer::clone(const GeneratedFunction& function, const std::map<int, std::string>& constants) {
+	//The name contains the index and value of each constant
+	auto name = function.name();
+	std::vector<FunctionParameter> parameters;
+	std::vector<int> newIndex;
+
+	for (int parameter = 0; parameter < (int)function.parameters().size(); parameter++) {
+		auto constant = constants.find(parameter);
+
+		if (constant != constants.end()) {
+			auto inst = Instructions::split(constant->second);
+			auto value = inst.first == "LDTRUE" ? "true" : (inst.first == "LDFALSE" ? "false" : inst.second);
+			name += "$" + std::to_string(parameter) + "_" + value;
+			newIndex.push_back(-1);
+		} else {
+			newIndex.push_back(parameters.size());
+			parameters.push_back(function.parameters()[parameter]);
+		}
+	}
+
+	std::vector<std::string> attributes;
+	for (auto& attribute : function.attributes()) {
+		if (attribute != "Export") {
+			attributes.push_back(attribute);
+		}
+	}
+
+	GeneratedFunction clone(name, parameters, function.returnType(), false, function.accessModifier(), attributes);
+	clone.replaceLocals(function.locals());
+	clone.replaceInstructions(function.instructions());
+	replaceParameters(clone, constants);
+
+	for (int i = 0; i < clone.numInstructions(); i++) {
+		auto inst = Instructions::split(clone.instruction(i));
+
+		if (inst.first == "LDARG") {
+			clone.instruction(i) = "LDARG " + std::to_string(newIndex[std::stoi(inst.second)]);
+		}
+	}
+
+	return clone;
+}
+
+void Specializer::specializeCalls(std::vector<GeneratedFunction>& functions) {
+	std::map<std::string, int> indices;
+	std::map<std::string, int> numClones;
+	int growth = 0;
+
+	for (int i = 0; i < (int)functions.size(); i++) {
+		indices[functions[i].signature()] = i;
+	}
+
+	//The clones are added to the end, so that the calls in them are specialized as well
+	for (int caller = 0; caller < (int)functions.size(); caller++) {
+		auto calls = findCalls(functions[caller]);
+		std::vector<std::pair<Call, std::string>> specializedCalls;
+
+		for (auto& call : calls) {
+			auto callee = indices.find(call.signature);
+
+			if (callee == indices.end()) {
+				continue;
+			}
+
+			auto& function = functions[callee->second];
+			std::map<int, std::string> constants;
+
+			for (int parameter = 0; parameter < (int)call.loads.size(); parameter++) {
+				if (!constantKind(call.loads[parameter]).empty()) {
+					constants[parameter] = call.loads[parameter];
+				}
+			}
+
+			//Only the first call of a recursive function that changes the constants would be specialized
+			if (constants.empty() || function.isMemberFunction() || function.numInstructions() > maxSize
+				|| numFoldedBranches(function, constants) == 0 || passesOtherConstants(function, constants)) {
+				continue;
+			}
+
+			auto specialized = clone(function, constants);
+			auto signature = specialized.signature();
+
+			if (indices.count(signature) == 0) {
+				if (growth + specialized.numInstructions() > maxGrowth || numClones[function.signature()] >= maxClones) {
+					mStatistics.add("specialize.budget");
+					continue;
+				}
+
+				growth += specialized.numInstructions();
+				numClones[function.signature()]++;
+				indices[signature] = functions.size();
+				mInstructionInfo.defineFunction(signature, specialized.returnType());
+				functions.push_back(specialized);
+				mStatistics.add("specialize.clones");
+			}
+
+			specializedCalls.push_back({ call, signature });
+		}
+
+		if (specializedCalls.empty()) {
+			continue;
+		}
+
+		//The constant arguments are no longer passed
+		PeepholeFunction peepholeFunc(functions[caller]);
+
+		for (auto& specializedCall : specializedCalls) {
+			auto& call = specializedCall.first;
+
+			for (int parameter = 0; parameter < (int)call.loads.size(); parameter++) {
+				if (!constantKind(call.loads[parameter]).empty()) {
+					peepholeFunc.at(call.producers[parameter]).isDeleted = true;
+				}
+			}
+
+			peepholeFunc.at(call.index).operand = specializedCall.second;
+			mStatistics.add("specialize.calls");
+		}
+
+		peepholeFunc.endPass();
+		peepholeFunc.store(functions[caller]);
+	}
+}
+
+void Specializer::specialize(std::vector<GeneratedFunction>& functions) {
+	propagateConstants(functions);
+	specializeCalls(functions);
+}
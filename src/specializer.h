@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+
+class GeneratedFunction;
+class InstructionInfo;
+class TreeShaker;
+class Statistics;
+
+//Propagates constant arguments into the called functions. If all calls of a function pass the same constant
+//for a parameter, the parameter is replaced by the constant. Otherwise, calls with constants that enable folding
+//call a clone of the function specialized for the constants, named after them. A call is only specialized if a branch folds.
+class Specializer {
+private:
+	//A call of a function in the program
+	struct Call {
+		int index;
+		std::string signature;
+
+		//The instruction loading each argument, which is empty if the argument is computed
+		std::vector<std::string> loads;
+
+		//The index of the instruction pushing each argument, which is -1 if the instruction is not known
+		std::vector<int> producers;
+	};
+
+	InstructionInfo& mInstructionInfo;
+	const TreeShaker& mTreeShaker;
+	Statistics& mStatistics;
+
+	//Finds the calls of functions without an object reference in the given function
+	std::vector<Call> findCalls(const GeneratedFunction& function) const;
+
+	//Returns the number of conditional branches in the given function that can be folded when the parameters are the given constants
+	int numFoldedBranches(const GeneratedFunction& function, const std::map<int, std::string>& constants) const;
+
+	//Indicates if the given function calls itself with other values for the given constant parameters
+	bool passesOtherConstants(const GeneratedFunction& function, const std::map<int, std::string>& constants) const;
+
+	//Replaces the loads of the given parameters by the constants
+	static void replaceParameters(GeneratedFunction& function, const std::map<int, std::string>& constants);
+
+	//Replaces parameters that are the same constant in all calls
+	void propagateConstants(std::vector<GeneratedFunction>& functions);
+
+	//Creates a clone of the given function without the given parameters, which are replaced by the constants
+	GeneratedFunction clone(const GeneratedFunction& function, const std::map<int, std::string>& constants);
+
+	//Replaces calls with constants that enable folding by calls to specialized clones
+	void specializeCalls(std::vector<GeneratedFunction>& functions);
+public:
+	//Creates a new specializer. Functions that are entry points of the program can be called with any arguments.
+	Specializer(InstructionInfo& instructionInfo, const TreeShaker& treeShaker, Statistics& statistics);
+
+	//The maximum number of instructions of a function that is specialized
+	static const int maxSize;
+
+	//The maximum number of instructions added by clones
+	static const int maxGrowth;
+
+	//The maximum number of clones of each function
+	static const int maxClones;
+
+	//Specializes the given functions
+	void specialize(std::vector<GeneratedFunction>& functions);
+};
@@ -0,0 +1,865 @@
+#include "ssa.h"
+#include "codegenerator.h"
+#include "instructioninfo.h"
+#include "type.h"
+
+#include <set>
+#include <map>
+#include <algorithm>
+#include <functional>
+
+namespace {
+	//The instructions that always push the same value. Null is not included, as the VM rejects instructions
+	//such as LDLEN and LDFIELD on a null that was not loaded from a local of the right type.
+	const std::set<std::string> constantInstructions = {
+		"LDINT", "LDFLOAT", "LDCHAR", "LDTRUE", "LDFALSE", "LDARG"
+	};
+
+	//Returns the instruction that loads the default value of the given type, which is the value of uninitialized locals
+	SSAInstruction defaultValue(std::shared_ptr<Type> type, int result) {
+		auto name = type->name();
+
+		if (name == "Int") {
+			return { "LDINT", "0", result, {} };
+		} else if (name == "Float") {
+			return { "LDFLOAT", "0", result, {} };
+		} else if (name == "Char") {
+			return { "LDCHAR", "0", result, {} };
+		} else if (name == "Bool") {
+			return { "LDFALSE", "", result, {} };
+		} else {
+			return { "LDNULL", "", result, {} };
+		}
+	}
+
+	//Indicates if the given op code reads fields or elements
+	bool readsMemory(const std::string& opCode) {
+		return opCode == "LDFIELD" || opCode == "LDELEM" || opCode == "LDLEN";
+	}
+
+	//Indicates if the given op code can change memory, which includes calls and allocations
+	bool writesMemory(const std::string& opCode) {
+		return !InstructionInfo::isPure(opCode);
+	}
+
+	//Indicates if the order of the given instructions matters
+	bool hasEffect(const std::string& opCode) {
+		return readsMemory(opCode) || writesMemory(opCode) || InstructionInfo::canThrow(opCode);
+	}
+
+	//Indicates if the given instructions can be executed in any order
+	bool commutes(const std::string& first, const std::string& second) {
+		if (writesMemory(first) && hasEffect(second)) {
+			return false;
+		}
+
+		if (writesMemory(second) && hasEffect(first)) {
+			return false;
+		}
+
+		return !(InstructionInfo::canThrow(first) && InstructionInfo::canThrow(second));
+	}
+
+	//A copy of values into the locals of phi instructions. All values are loaded before any is stored.
+	struct PhiCopy {
+		std::vector<std::string> loads;
+		std::vector<std::string> stores;
+
+		//Adds the given copy
+		void add(const PhiCopy& other) {
+			loads.insert(loads.end(), other.loads.begin(), other.loads.end());
+			stores.insert(stores.begin(), other.stores.begin(), other.stores.end());
+		}
+
+		//Adds the instructions of the copy to the given instructions
+		void generate(std::vector<std::string>& instructions) const {
+			instructions.insert(instructions.end(), loads.begin(), loads.end());
+			instructions.insert(instructions.end(), stores.begin(), stores.end());
+		}
+	};
+}
+
+std::string SSAInstruction::instruction() const {
+	if (operand != "") {
+		return opCode + " " + operand;
+	} else {
+		return opCode;
+	}
+}
+
+SSAFunction::SSAFunction(const InstructionInfo& instructionInfo)
+	: mInstructionInfo(instructionInfo) {
+
+}
+
+std::vector<SSABlock>& SSAFunction::blocks() {
+	return mBlocks;
+}
+
+int SSAFunction::numRegisters() const {
+	return mRegisterTypes.size();
+}
+
+std::shared_ptr<Type> SSAFunction::registerType(int reg) const {
+	return mRegisterTypes.at(reg);
+}
+
+int SSAFunction::newRegister(std::shared_ptr<Type> type) {
+	mRegisterTypes.push_back(type);
+	return mRegisterTypes.size() - 1;
+}
+
+std::vector<bool> SSAFunction::reachableBlocks() const {
+	std::vector<bool> reachable(mBlocks.size(), false);
+	std::vector<int> blocks = { 0 };
+	reachable[0] = true;
+
+	while (!blocks.empty()) {
+		int block = blocks.back();
+		blocks.pop_back();
+
+		for (int successor : mBlocks[block].successors) {
+			if (!reachable[successor]) {
+				reachable[successor] = true;
+				blocks.push_back(successor);
+			}
+		}
+	}
+
+	return reachable;
+}
+
+void SSAFunction::removeEdge(int from, int to) {
+	auto& successors = mBlocks[from].successors;
+	successors.erase(std::find(successors.begin(), successors.end(), to));
+
+	auto& predecessors = mBlocks[to].predecessors;
+	auto predecessor = std::find(predecessors.begin(), predecessors.end(), from);
+	int index = predecessor - predecessors.begin();
+	predecessors.erase(predecessor);
+
+	for (auto& instruction : mBlocks[to].instructions) {
+		if (instruction.opCode == "PHI") {
+			instruction.arguments.erase(instruction.arguments.begin() + index);
+		}
+	}
+}
+
+std::vector<int> SSAFunction::numUses() const {
+	std::vector<int> uses(numRegisters(), 0);
+
+	for (auto& block : mBlocks) {
+		for (auto& instruction : block.instructions) {
+			for (int argument : instruction.arguments) {
+				uses[argument]++;
+			}
+		}
+	}
+
+	return uses;
+}
+
+bool SSAFunction::isConstant(const std::string& opCode) {
+	return constantInstructions.count(opCode) > 0;
+}
+
+bool SSAFunction::build(const GeneratedFunction& function) {
+	auto& instructions = function.instructions();
+	int numInstructions = instructions.size();
+	mBlocks.clear();
+	mRegisterTypes.clear();
+
+	if (numInstructions == 0) {
+		return false;
+	}
+
+	//A block starts at the first instruction, at branch targets and after branches
+	std::set<int> starts = { 0 };
+
+	for (int i = 0; i < numInstructions; i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (Instructions::isBranch(inst.first)) {
+			int target = std::stoi(inst.second);
+
+			if (target < 0 || target >= numInstructions) {
+				return false;
+			}
+
+			starts.insert(target);
+		}
+
+		if ((Instructions::isBranch(inst.first) || inst.first == "RET") && i + 1 < numInstructions) {
+			starts.insert(i + 1);
+		}
+	}
+
+	std::vector<int> blockStarts(starts.begin(), starts.end());
+	blockStarts.push_back(numInstructions);
+
+	std::map<int, int> startBlocks;
+	for (int i = 0; i + 1 < (int)blockStarts.size(); i++) {
+		startBlocks[blockStarts[i]] = i + 1;
+	}
+
+	//The first block is the entry, followed by the blocks of the instructions
+	mBlocks.resize(blockStarts.size());
+	mBlocks[0].successors.push_back(1);
+
+	for (int block = 1; block < (int)mBlocks.size(); block++) {
+		auto last = Instructions::split(instructions[blockStarts[block] - 1]);
+		auto& successors = mBlocks[block].successors;
+
+		if (Instructions::isBranch(last.first)) {
+			successors.push_back(startBlocks[std::stoi(last.second)]);
+		}
+
+		if (last.first != "BR" && last.first != "RET") {
+			if (block + 1 == (int)mBlocks.size()) {
+				return false;
+			}
+
+			successors.push_back(block + 1);
+		}
+	}
+
+	auto reachable = reachableBlocks();
+
+	for (int block = 0; block < (int)mBlocks.size(); block++) {
+		if (!reachable[block]) {
+			mBlocks[block].successors.clear();
+		}
+
+		for (int successor : mBlocks[block].successors) {
+			mBlocks[successor].predecessors.push_back(block);
+		}
+	}
+
+	//Order the blocks such that a block with a single predecessor is after the predecessor
+	std::vector<int> order;
+	std::vector<bool> isVisited(mBlocks.size(), false);
+	std::vector<std::pair<int, int>> visitStack = { { 0, 0 } };
+	isVisited[0] = true;
+
+	while (!visitStack.empty()) {
+		auto& top = visitStack.back();
+		auto& successors = mBlocks[top.first].successors;
+
+		if (top.second < (int)successors.size()) {
+			int successor = successors[top.second++];
+
+			if (!isVisited[successor]) {
+				isVisited[successor] = true;
+				visitStack.push_back({ successor, 0 });
+			}
+		} else {
+			order.push_back(top.first);
+			visitStack.pop_back();
+		}
+	}
+
+	std::reverse(order.begin(), order.end());
+
+	//The types of the locals
+	int numLocals = function.numLocals();
+	std::vector<std::shared_ptr<Type>> localTypes(numLocals);
+
+	for (auto& local : function.locals()) {
+		if (local.second.first < 0 || local.second.first >= numLocals) {
+			return false;
+		}
+
+		localTypes[local.second.first] = local.second.second;
+	}
+
+	for (auto& type : localTypes) {
+		if (type == nullptr) {
+			return false;
+		}
+	}
+
+	//Replace the locals by the registers that were last stored in them, where blocks with multiple predecessors
+	//start with a phi instruction for each local
+	std::vector<std::vector<int>> exitValues(mBlocks.size());
+
+	for (int local = 0; local < numLocals; local++) {
+		int reg = newRegister(localTypes[local]);
+		mBlocks[0].instructions.push_back(defaultValue(localTypes[local], reg));
+		exitValues[0].push_back(reg);
+	}
+
+	mBlocks[0].instructions.push_back({ "BR", "", -1, {} });
+
+	for (int block : order) {
+		if (block == 0) {
+			continue;
+		}
+
+		auto& ssaBlock = mBlocks[block];
+		std::vector<int> values;
+
+		if (ssaBlock.predecessors.size() == 1) {
+			values = exitValues[ssaBlock.predecessors[0]];
+		} else {
+			for (int local = 0; local < numLocals; local++) {
+				int reg = newRegister(localTypes[local]);
+				ssaBlock.instructions.push_back({ "PHI", "", reg, {} });
+				values.push_back(reg);
+			}
+		}
+
+		std::vector<int> stack;
+
+		for (int i = blockStarts[block - 1]; i < blockStarts[block]; i++) {
+			auto inst = Instructions::split(instructions[i]);
+			auto effect = mInstructionInfo.stackEffect(function, instructions[i]);
+
+			if ((int)stack.size() < effect.pops) {
+				return false;
+			}
+
+			std::vector<int> arguments(stack.end() - effect.pops, stack.end());
+			stack.resize(stack.size() - effect.pops);
+
+			if (inst.first == "LDLOC" || inst.first == "STLOC") {
+				int local = std::stoi(inst.second);
+
+				if (local < 0 || local >= numLocals) {
+					return false;
+				}
+
+				if (inst.first == "LDLOC") {
+					stack.push_back(values[local]);
+				} else {
+					//A null gets the type of the local it is stored in
+					if (registerType(arguments[0]) == nullptr) {
+						mRegisterTypes[arguments[0]] = localTypes[local];
+					}
+
+					values[local] = arguments[0];
+				}
+			} else if (Instructions::isBranch(inst.first)) {
+				ssaBlock.instructions.push_back({ inst.first, "", -1, arguments });
+			} else if (inst.first != "POP") {
+				int result = -1;
+
+				if (effect.pushes > 0) {
+					std::vector<std::shared_ptr<Type>> argumentTypes;
+					for (int argument : arguments) {
+						argumentTypes.push_back(registerType(argument));
+					}
+
+					auto type = mInstructionInfo.resultType(function, instructions[i], argumentTypes);
+
+					//Values without a known type might need to be stored in a local
+					if (type == nullptr && !isConstant(inst.first) && inst.first != "LDNULL") {
+						return false;
+					}
+
+					result = newRegister(type);
+					stack.push_back(result);
+				}
+
+				ssaBlock.instructions.push_back({ inst.first, inst.second, result, arguments });
+			}
+		}
+
+		if (!stack.empty()) {
+			return false;
+		}
+
+		auto last = Instructions::split(instructions[blockStarts[block] - 1]).first;
+		if (!Instructions::isBranch(last) && last != "RET") {
+			ssaBlock.instructions.push_back({ "BR", "", -1, {} });
+		}
+
+		exitValues[block] = values;
+	}
+
+	//The arguments of the phi instructions are the values at the end of the predecessors
+	for (int block : order) {
+		auto& ssaBlock = mBlocks[block];
+
+		for (int local = 0; local < numLocals && ssaBlock.predecessors.size() != 1 && block != 0; local++) {
+			for (int predecessor : ssaBlock.predecessors) {
+				ssaBlock.instructions[local].arguments.push_back(exitValues[predecessor][local]);
+			}
+		}
+	}
+
+	return true;
+}
+
+std::vector<std::vector<bool>> SSAFunction::liveRegisters() const {
+	std::vector<std::vector<bool>> live(mBlocks.size(), std::vector<bool>(numRegisters(), false));
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		for (int block = mBlocks.size() - 1; block >= 0; block--) {
+			std::vector<bool> liveIn(numRegisters(), false);
+
+			//The values used by the phi instructions of the successors are live at the end of the block
+			for (int successor : mBlocks[block].successors) {
+				auto& predecessors = mBlocks[successor].predecessors;
+				int index = std::find(predecessors.begin(), predecessors.end(), block) - predecessors.begin();
+
+				for (int reg = 0; reg < numRegisters(); reg++) {
+					if (live[successor][reg]) {
+						liveIn[reg] = true;
+					}
+				}
+
+				for (auto& instruction : mBlocks[successor].instructions) {
+					if (instruction.opCode == "PHI") {
+						liveIn[instruction.arguments[index]] = true;
+					}
+				}
+			}
+
+			auto& instructions = mBlocks[block].instructions;
+
+			for (auto instruction = instructions.rbegin(); instruction != instructions.rend(); instruction++) {
+				if (instruction->result != -1) {
+					liveIn[instruction->result] = false;
+				}
+
+				if (instruction->opCode != "PHI") {
+					for (int argument : instruction->arguments) {
+						liveIn[argument] = true;
+					}
+				}
+			}
+
+			if (liveIn != live[block]) {
+				live[block] = std::move(liveIn);
+				changed = true;
+			}
+		}
+	}
+
+	return live;
+}
+
+std::vector<int> SSAFunction::coalesceRegisters(const std::vector<std::vector<bool>>& live) const {
+	int numRegs = numRegisters();
+	std::vector<const SSAInstruction*> definitions(numRegs, nullptr);
+	std::vector<int> definingBlocks(numRegs, -1);
+
+	//The registers that are live after the definition of each register, and during the copies at the end of each block
+	std::vector<std::vector<bool>> liveAfter(numRegs);
+	std::vector<std::vector<bool>> liveAtCopies(mBlocks.size(), std::vector<bool>(numRegs, false));
+
+	for (int block = 0; block < (int)mBlocks.size(); block++) {
+		for (int successor : mBlocks[block].successors) {
+			for (int reg = 0; reg < numRegs; reg++) {
+				if (live[successor][reg]) {
+					liveAtCopies[block][reg] = true;
+				}
+			}
+		}
+
+		auto liveRegs = liveAtCopies[block];
+
+		for (int successor : mBlocks[block].successors) {
+			auto& predecessors = mBlocks[successor].predecessors;
+			int index = std::find(predecessors.begin(), predecessors.end(), block) - predecessors.begin();
+
+			for (auto& instruction : mBlocks[successor].instructions) {
+				if (instruction.opCode == "PHI") {
+					liveRegs[instruction.arguments[index]] = true;
+				}
+			}
+		}
+
+		auto& instructions = mBlocks[block].instructions;
+
+		for (auto instruction = instructions.rbegin(); instruction != instructions.rend(); instruction++) {
+			if (instruction->result != -1) {
+				definitions[instruction->result] = &(*instruction);
+				definingBlocks[instruction->result] = block;
+				liveAfter[instruction->result] = liveRegs;
+			}
+
+			if (instruction->opCode != "PHI") {
+				if (instruction->result != -1) {
+					liveRegs[instruction->result] = false;
+				}
+
+				for (int argument : instruction->arguments) {
+					liveRegs[argument] = true;
+				}
+			}
+		}
+	}
+
+	//In SSA form, two values interfere if one is live where the other is defined
+	auto interferes = [&](int x, int y) {
+		return liveAfter[x][y] || liveAfter[y][x];
+	};
+
+	std::vector<int> classes(numRegs);
+	std::vector<std::vector<int>> members(numRegs);
+
+	for (int reg = 0; reg < numRegs; reg++) {
+		classes[reg] = reg;
+		members[reg].push_back(reg);
+	}
+
+	for (auto& block : mBlocks) {
+		for (auto& phi : block.instructions) {
+			if (phi.opCode != "PHI") {
+				break;
+			}
+
+			for (int argument : phi.arguments) {
+				int phiClass = classes[phi.result];
+				int argumentClass = classes[argument];
+
+				if (phiClass == argumentClass) {
+					continue;
+				}
+
+				bool canCoalesce = true;
+
+				for (int x : members[phiClass]) {
+					for (int y : members[argumentClass]) {
+						canCoalesce = canCoalesce && !interferes(x, y);
+					}
+				}
+
+				//The copies into the phi instructions of the class must not overwrite other values of the class
+				std::vector<int> coalesced = members[phiClass];
+				coalesced.insert(coalesced.end(), members[argumentClass].begin(), members[argumentClass].end());
+
+				auto isCoalesced = [&](int reg) {
+					return classes[reg] == phiClass || classes[reg] == argumentClass;
+				};
+
+				for (int reg : coalesced) {
+					if (!canCoalesce || definitions[reg]->opCode != "PHI") {
+						continue;
+					}
+
+					auto& predecessors = mBlocks[definingBlocks[reg]].predecessors;
+
+					for (int index = 0; index < (int)predecessors.size(); index++) {
+						if (isCoalesced(definitions[reg]->arguments[index])) {
+							continue;
+						}
+
+						for (int other : coalesced) {
+							canCoalesce = canCoalesce && (other == reg || !liveAtCopies[predecessors[index]][other]);
+						}
+					}
+				}
+
+				if (canCoalesce) {
+					for (int reg : members[argumentClass]) {
+						classes[reg] = phiClass;
+					}
+
+					members[phiClass] = coalesced;
+					members[argumentClass].clear();
+				}
+			}
+		}
+	}
+
+	return classes;
+}
+
+std::vector<bool> SSAFunction::scheduleBlocks() {
+	auto uses = numUses();
+	std::vector<bool> isTree(numRegisters(), false);
+
+	for (auto& block : mBlocks) {
+		auto& instructions = block.instructions;
+		int numPhis = 0;
+
+		while (numPhis < (int)instructions.size() && instructions[numPhis].opCode == "PHI") {
+			numPhis++;
+		}
+
+		//Values used once by a later instruction in the block are computed where they are used,
+		//except a null stored in a local, which must be loaded from a local of its type
+		std::map<int, int> definitions;
+		std::vector<bool> isChild(instructions.size(), false);
+
+		for (int i = numPhis; i < (int)instructions.size(); i++) {
+			for (int argument : instructions[i].arguments) {
+				auto definition = definitions.find(argument);
+
+				if (definition != definitions.end() && uses[argument] == 1
+					&& !isConstant(instructions[definition->second].opCode)
+					&& !(instructions[definition->second].opCode == "LDNULL" && registerType(argument) != nullptr)) {
+					isChild[definition->second] = true;
+				}
+			}
+
+			if (instructions[i].result != -1) {
+				definitions[instructions[i].result] = i;
+			}
+		}
+
+		std::vector<int> effects;
+		for (int i = numPhis; i < (int)instructions.size(); i++) {
+			if (hasEffect(instructions[i].opCode)) {
+				effects.push_back(i);
+			}
+		}
+
+		std::vector<int> order;
+		bool isValid = false;
+
+		while (!isValid) {
+			order.clear();
+
+			std::function<void(int)> schedule = [&](int index) {
+				for (int argument : instructions[index].arguments) {
+					auto definition = definitions.find(argument);
+
+					if (definition != definitions.end() && isChild[definition->second]) {
+						schedule(definition->second);
+					}
+				}
+
+				order.push_back(index);
+			};
+
+			for (int i = numPhis; i < (int)instructions.size(); i++) {
+				if (!isChild[i]) {
+					schedule(i);
+				}
+			}
+
+			//Instructions with effects that do not commute must stay in order,
+			//otherwise the first one is computed where it was instead of where it is used
+			std::vector<int> positions(instructions.size(), -1);
+			for (int i = 0; i < (int)order.size(); i++) {
+				positions[order[i]] = i;
+			}
+
+			isValid = true;
+
+			for (int i = 0; i < (int)effects.size(); i++) {
+				for (int j = i + 1; j < (int)effects.size() && isChild[effects[i]]; j++) {
+					auto& first = instructions[effects[i]].opCode;
+					auto& second = instructions[effects[j]].opCode;
+
+					if (positions[effects[i]] > positions[effects[j]] && !commutes(first, second)) {
+						isChild[effects[i]] = false;
+						isValid = false;
+					}
+				}
+			}
+		}
+
+		std::vector<SSAInstruction> scheduled(instructions.begin(), instructions.begin() + numPhis);
+
+		for (int index : order) {
+			scheduled.push_back(instructions[index]);
+
+			if (isChild[index]) {
+				isTree[instructions[index].result] = true;
+			}
+		}
+
+		instructions = scheduled;
+	}
+
+	return isTree;
+}
+
+void SSAFunction::generateCode(GeneratedFunction& function) {
+	auto isTree = scheduleBlocks();
+	auto reachable = reachableBlocks();
+	auto uses = numUses();
+	auto live = liveRegisters();
+
+	std::vector<const SSAInstruction*> definitions(numRegisters(), nullptr);
+
+	for (auto& block : mBlocks) {
+		for (auto& instruction : block.instructions) {
+			if (instruction.result != -1) {
+				definitions[instruction.result] = &instruction;
+			}
+		}
+	}
+
+	//Phi instructions and their arguments share local where possible, which removes the copies between them
+	auto classes = coalesceRegisters(live);
+	std::vector<int> classSizes(numRegisters(), 0);
+	std::map<int, int> locals;
+
+	for (int reg = 0; reg < numRegisters(); reg++) {
+		classSizes[classes[reg]]++;
+	}
+
+	auto local = [&](int reg) {
+		reg = classes[reg];
+
+		if (locals.count(reg) == 0) {
+			locals[reg] = function.newLocal("$tmp$_" + std::to_string(function.numLocals()), registerType(reg));
+		}
+
+		return std::to_string(locals[reg]);
+	};
+
+	//Constants are loaded again where they are used
+	auto load = [&](int reg) {
+		if (isConstant(definitions[reg]->opCode)) {
+			return definitions[reg]->instruction();
+		} else {
+			return "LDLOC " + local(reg);
+		}
+	};
+
+	auto phiCopy = [&](int from, int to) {
+		PhiCopy copy;
+		auto& predecessors = mBlocks[to].predecessors;
+		int index = std::find(predecessors.begin(), predecessors.end(), from) - predecessors.begin();
+
+		for (auto& instruction : mBlocks[to].instructions) {
+			if (instruction.opCode == "PHI" && classes[instruction.arguments[index]] != classes[instruction.result]) {
+				copy.loads.push_back(load(instruction.arguments[index]));
+				copy.stores.insert(copy.stores.begin(), "STLOC " + local(instruction.result));
+			}
+		}
+
+		return copy;
+	};
+
+	//A copy can be done before a conditional branch if the other successor does not use the assigned values
+	auto isCopySafe = [&](int to, int other) {
+		for (auto& instruction : mBlocks[to].instructions) {
+			for (int reg = 0; reg < numRegisters() && instruction.opCode == "PHI"; reg++) {
+				if (live[other][reg] && classes[reg] == classes[instruction.result]) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	};
+
+	//The branches refer to the blocks, followed by blocks for copies that could not be done before a branch
+	std::vector<std::string> instructions;
+	std::vector<int> labels(mBlocks.size(), -1);
+	std::vector<std::pair<int, int>> branches;
+	std::vector<std::pair<int, PhiCopy>> copyBlocks;
+
+	//Values used once in the same block are computed on the stack where they are used
+	std::function<void(const SSAInstruction&)> generateArguments = [&](const SSAInstruction& instruction) {
+		for (int argument : instruction.arguments) {
+			if (isTree[argument]) {
+				generateArguments(*definitions[argument]);
+				instructions.push_back(definitions[argument]->instruction());
+			} else {
+				instructions.push_back(load(argument));
+			}
+		}
+	};
+
+	for (int block = 0; block < (int)mBlocks.size(); block++) {
+		if (!reachable[block]) {
+			continue;
+		}
+
+		labels[block] = instructions.size();
+
+		int nextBlock = block + 1;
+		while (nextBlock < (int)mBlocks.size() && !reachable[nextBlock]) {
+			nextBlock++;
+		}
+
+		for (auto& instruction : mBlocks[block].instructions) {
+			if (instruction.opCode == "PHI" || (instruction.result != -1 && isTree[instruction.result])) {
+				continue;
+			}
+
+			//Constants are only stored where they are computed if they share local with a phi instruction
+			if (isConstant(instruction.opCode)) {
+				if (classSizes[classes[instruction.result]] > 1) {
+					instructions.push_back(instruction.instruction());
+					instructions.push_back("STLOC " + local(instruction.result));
+				}
+
+				continue;
+			}
+
+			generateArguments(instruction);
+
+			if (instruction.opCode == "BR") {
+				int target = mBlocks[block].successors[0];
+				phiCopy(block, target).generate(instructions);
+
+				if (target != nextBlock) {
+					branches.push_back({ instructions.size(), target });
+					instructions.push_back("BR");
+				}
+			} else if (Instructions::isBranch(instruction.opCode)) {
+				int target = mBlocks[block].successors[0];
+				int next = mBlocks[block].successors[1];
+				auto targetCopy = phiCopy(block, target);
+				auto nextCopy = phiCopy(block, next);
+
+				PhiCopy beforeCopy;
+				bool isTargetSafe = target == next || isCopySafe(target, next);
+				bool isNextSafe = target != next && isCopySafe(next, target);
+
+				if (isTargetSafe) {
+					beforeCopy.add(targetCopy);
+				}
+
+				if (isNextSafe) {
+					beforeCopy.add(nextCopy);
+				}
+
+				beforeCopy.generate(instructions);
+
+				if (!isTargetSafe && !targetCopy.loads.empty()) {
+					branches.push_back({ instructions.size(), mBlocks.size() + copyBlocks.size() });
+					copyBlocks.push_back({ target, targetCopy });
+				} else {
+					branches.push_back({ instructions.size(), target });
+				}
+
+				instructions.push_back(instruction.opCode);
+
+				if (!isNextSafe && target != next) {
+					nextCopy.generate(instructions);
+				}
+
+				if (next != nextBlock) {
+					branches.push_back({ instructions.size(), next });
+					instructions.push_back("BR");
+				}
+			} else {
+				instructions.push_back(instruction.instruction());
+
+				if (instruction.result != -1) {
+					if (uses[instruction.result] == 0) {
+						instructions.push_back("POP");
+					} else {
+						instructions.push_back("STLOC " + local(instruction.result));
+					}
+				}
+			}
+		}
+	}
+
+	for (auto& copyBlock : copyBlocks) {
+		labels.push_back(instructions.size());
+		copyBlock.second.generate(instructions);
+		branches.push_back({ instructions.size(), copyBlock.first });
+		instructions.push_back("BR");
+	}
+
+	for (auto& branch : branches) {
+		instructions[branch.first] += " " + std::to_string(labels[branch.second]);
+	}
+
+	function.replaceInstructions(instructions);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+
+class GeneratedFunction;
+class Type;
+class InstructionInfo;
+
+//Represents an instruction in SSA form. The operands are registers instead of stack values.
+//Phi instructions have one argument per predecessor of their block. Branches and returns end a block.
+struct SSAInstruction {
+	std::string opCode;
+	std::string operand;
+	int result;
+	std::vector<int> arguments;
+
+	//Returns the instruction as generated code
+	std::string instruction() const;
+};
+
+//Represents a basic block in SSA form. The phi instructions are first, and the last instruction is a branch or return.
+//For conditional branches, the first successor is the target and the second one the next block.
+struct SSABlock {
+	std::vector<SSAInstruction> instructions;
+	std::vector<int> predecessors;
+	std::vector<int> successors;
+};
+
+//Represents a function in SSA form, where the locals are replaced by registers that are assigned once.
+//The first block defines the initial values of the locals and is followed by the blocks of the function in order.
+class SSAFunction {
+private:
+	const InstructionInfo& mInstructionInfo;
+	std::vector<SSABlock> mBlocks;
+	std::vector<std::shared_ptr<Type>> mRegisterTypes;
+
+	//Returns the registers that are live at the start of each block
+	std::vector<std::vector<bool>> liveRegisters() const;
+
+	//Assigns the registers of phi instructions and their arguments to the same class where they do not interfere,
+	//such that they can be stored in the same local. Returns the class of each register.
+	std::vector<int> coalesceRegisters(const std::vector<std::vector<bool>>& live) const;
+
+	//Orders the instructions of each block such that values used once in the block are computed where they are used,
+	//as long as instructions with effects keep their order. Returns the registers of the values computed where used.
+	std::vector<bool> scheduleBlocks();
+public:
+	//Creates a new empty SSA function
+	SSAFunction(const InstructionInfo& instructionInfo);
+
+	//Returns the blocks
+	std::vector<SSABlock>& blocks();
+
+	//Returns the number of registers
+	int numRegisters() const;
+
+	//Returns the type of the given register
+	std::shared_ptr<Type> registerType(int reg) const;
+
+	//Creates a new register of the given type
+	int newRegister(std::shared_ptr<Type> type);
+
+	//Indicates if the given block is reachable from the first block
+	std::vector<bool> reachableBlocks() const;
+
+	//Removes the edge between the given blocks, including the phi arguments for it
+	void removeEdge(int from, int to);
+
+	//Returns the number of uses of each register
+	std::vector<int> numUses() const;
+
+	//Indicates if the given instruction loads a constant, which can be loaded again instead of kept in a register
+	static bool isConstant(const std::string& opCode);
+
+	//Builds the SSA form of the given function. Returns false if the instructions could not be analyzed.
+	bool build(const GeneratedFunction& function);
+
+	//Generates the instructions of the given function from the SSA form.
+	//Values used once in the same block are computed on the stack where they are used, others are stored in locals.
+	void generateCode(GeneratedFunction& function);
+};
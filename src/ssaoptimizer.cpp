@@ -0,0 +1,406 @@
+#include "ssaoptimizer.h"
+#include "ssa.h"
+#include "codegenerator.h"
+#include "instructioninfo.h"
+#include "statistics.h"
+
+#include <set>
+#include <algorithm>
+#include <map>
+#include <limits>
+#include <cstdint>
+
+namespace {
+	//Returns the value of the given integer or char constant. Returns false if it is not one.
+	bool integerValue(const SSAInstruction* instruction, std::int64_t& value) {
+		if (instruction != nullptr && (instruction->opCode == "LDINT" || instruction->opCode == "LDCHAR")) {
+			value = std::stoll(instruction->operand);
+			return true;
+		}
+
+		return false;
+	}
+
+	//Returns the value of the given bool constant. Returns false if it is not one.
+	bool boolValue(const SSAInstruction* instruction, bool& value) {
+		if (instruction != nullptr && (instruction->opCode == "LDTRUE" || instruction->opCode == "LDFALSE")) {
+			value = instruction->opCode == "LDTRUE";
+			return true;
+		}
+
+		return false;
+	}
+
+	//Compares the given values with the given condition, which is the op code of a compare or branch without prefix
+	bool compare(const std::string& condition, std::int64_t x, std::int64_t y) {
+		if (condition == "EQ") {
+			return x == y;
+		} else if (condition == "NE") {
+			return x != y;
+		} else if (condition == "GT") {
+			return x > y;
+		} else if (condition == "GE") {
+			return x >= y;
+		} else if (condition == "LT") {
+			return x < y;
+		} else {
+			return x <= y;
+		}
+	}
+
+	//Evaluates the given compare or conditional branch of the given constants. Returns false if it cannot be evaluated.
+	bool evaluateCondition(const std::string& opCode, const SSAInstruction* x, const SSAInstruction* y, bool& result) {
+		auto condition = opCode.substr(opCode.length() - 2);
+		std::int64_t xInteger;
+		std::int64_t yInteger;
+		bool xBool;
+		bool yBool;
+
+		if (integerValue(x, xInteger) && integerValue(y, yInteger) && x->opCode == y->opCode) {
+			result = compare(condition, xInteger, yInteger);
+			return true;
+		} else if (boolValue(x, xBool) && boolValue(y, yBool) && (condition == "EQ" || condition == "NE")) {
+			result = compare(condition, xBool, yBool);
+			return true;
+		}
+
+		return false;
+	}
+
+	//Evaluates the given integer operation of the given constants. Returns false if it cannot be evaluated.
+	bool evaluateOperation(const std::string& opCode, const SSAInstruction* x, const SSAInstruction* y, std::int32_t& result) {
+		if (x == nullptr || y == nullptr || x->opCode != "LDINT" || y->opCode != "LDINT") {
+			return false;
+		}
+
+		std::int64_t xValue = std::stoll(x->operand);
+		std::int64_t yValue = std::stoll(y->operand);
+
+		//Integer arithmetic wraps around
+		if (opCode == "ADD") {
+			result = (std::int32_t)(std::uint32_t)(xValue + yValue);
+		} else if (opCode == "SUB") {
+			result = (std::int32_t)(std::uint32_t)(xValue - yValue);
+		} else if (opCode == "MUL") {
+			result = (std::int32_t)(std::uint32_t)(xValue * yValue);
+		} else if (opCode == "DIV" && yValue != 0 && !(xValue == std::numeric_limits<std::int32_t>::min() && yValue == -1)) {
+			result = (std::int32_t)(xValue / yValue);
+		} else {
+			return false;
+		}
+
+		return true;
+	}
+}
+
+SSAOptimizer::SSAOptimizer(const InstructionInfo& instructionInfo, Statistics& statistics)
+	: mInstructionInfo(instructionInfo), mStatistics(statistics) {
+	mStatistics.add("ssa.functions", 0);
+	mStatistics.add("ssa.folded", 0);
+	mStatistics.add("ssa.dead-values", 0);
+}
+
+void SSAOptimizer::replaceRegisters(SSAFunction& function, std::vector<int>& replacements) {
+	auto find = [&](int reg) {
+		while (replacements[reg] != -1) {
+			reg = replacements[reg];
+		}
+
+		return reg;
+	};
+
+	for (auto& block : function.blocks()) {
+		for (auto& instruction : block.instructions) {
+			for (auto& argument : instruction.arguments) {
+				argument = find(argument);
+			}
+		}
+	}
+}
+
+void SSAOptimizer::removeTrivialPhis(SSAFunction& function) {
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+		std::vector<int> replacements(function.numRegisters(), -1);
+
+		for (auto& block : function.blocks()) {
+			auto& instructions = block.instructions;
+
+			for (int i = 0; i < (int)instructions.size() && instructions[i].opCode == "PHI"; i++) {
+				int value = -1;
+				bool isTrivial = !instructions[i].arguments.empty();
+
+				for (int argument : instructions[i].arguments) {
+					if (argument != instructions[i].result && argument != value) {
+						isTrivial = isTrivial && value == -1;
+						value = argument;
+					}
+				}
+
+				if (isTrivial && value != -1) {
+					replacements[instructions[i].result] = value;
+					instructions.erase(instructions.begin() + i);
+					i--;
+					changed = true;
+				}
+			}
+		}
+
+		replaceRegisters(function, replacements);
+	}
+}
+
+bool SSAOptimizer::threadBranches(SSAFunction& function) {
+	auto& blocks = function.blocks();
+	auto uses = function.numUses();
+	bool changed = false;
+
+	for (int block = 1; block < (int)blocks.size(); block++) {
+		auto& instructions = blocks[block].instructions;
+
+		if (instructions.empty() || instructions.back().opCode != "BR" || blocks[block].successors[0] == block) {
+			continue;
+		}
+
+		//Constants that are not used are removed later
+		bool isEmpty = true;
+		for (int i = 0; i < (int)instructions.size() - 1; i++) {
+			isEmpty = isEmpty && SSAFunction::isConstant(instructions[i].opCode) && uses[instructions[i].result] == 0;
+		}
+
+		if (!isEmpty) {
+			continue;
+		}
+
+		int target = blocks[block].successors[0];
+		auto& targetPredecessors = blocks[target].predecessors;
+		int index = std::find(targetPredecessors.begin(), targetPredecessors.end(), block) - targetPredecessors.begin();
+		auto predecessors = blocks[block].predecessors;
+
+		for (int predecessor : predecessors) {
+			//If the predecessor already branches to the target, the values of the phi instructions must be the same
+			auto existing = std::find(targetPredecessors.begin(), targetPredecessors.end(), predecessor);
+			bool isSameValues = true;
+
+			for (auto& instruction : blocks[target].instructions) {
+				if (instruction.opCode == "PHI" && existing != targetPredecessors.end()) {
+					auto& arguments = instruction.arguments;
+					isSameValues = isSameValues && arguments[existing - targetPredecessors.begin()] == arguments[index];
+				}
+			}
+
+			if (!isSameValues) {
+				continue;
+			}
+
+			for (auto& instruction : blocks[target].instructions) {
+				if (instruction.opCode == "PHI") {
+					instruction.arguments.push_back(instruction.arguments[index]);
+				}
+			}
+
+			targetPredecessors.push_back(predecessor);
+			blocks[block].predecessors.erase(std::find(
+				blocks[block].predecessors.begin(),
+				blocks[block].predecessors.end(),
+				predecessor));
+
+			auto& successors = blocks[predecessor].successors;
+			*std::find(successors.begin(), successors.end(), block) = target;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+void SSAOptimizer::foldConstants(SSAFunction& function) {
+	auto& blocks = function.blocks();
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+
+		std::vector<const SSAInstruction*> definitions(function.numRegisters(), nullptr);
+		for (auto& block : blocks) {
+			for (auto& instruction : block.instructions) {
+				if (instruction.result != -1) {
+					definitions[instruction.result] = &instruction;
+				}
+			}
+		}
+
+		auto argument = [&](const SSAInstruction& instruction, int index) {
+			return definitions[instruction.arguments[index]];
+		};
+
+		for (int block = 0; block < (int)blocks.size(); block++) {
+			auto& instructions = blocks[block].instructions;
+			int numPhis = 0;
+
+			for (int i = 0; i < (int)instructions.size(); i++) {
+				auto& instruction = instructions[i];
+				auto& opCode = instruction.opCode;
+				std::int32_t intResult;
+				bool boolResult;
+
+				if (opCode == "PHI") {
+					//Phi instructions where all values are the same constant are the constant, after the phi instructions
+					bool isConstant = !instruction.arguments.empty();
+					auto constant = argument(instruction, 0);
+
+					for (int index = 0; index < (int)instruction.arguments.size() && isConstant; index++) {
+						auto value = argument(instruction, index);
+						isConstant = value != nullptr && SSAFunction::isConstant(value->opCode)
+									 && value->instruction() == constant->instruction();
+					}
+
+					if (isConstant) {
+						SSAInstruction folded = { constant->opCode, constant->operand, instruction.result, {} };
+						instructions.erase(instructions.begin() + i);
+
+						int end = 0;
+						while (end < (int)instructions.size() && instructions[end].opCode == "PHI") {
+							end++;
+						}
+
+						instructions.insert(instructions.begin() + end, folded);
+						changed = true;
+						break;
+					}
+
+					numPhis++;
+				} else if (Instructions::isBranch(opCode) && opCode != "BR") {
+					auto successors = blocks[block].successors;
+
+					//Branches to the next block do not depend on the condition
+					if (successors[0] == successors[1]) {
+						function.removeEdge(block, successors[0]);
+						instruction = { "BR", "", -1, {} };
+						mStatistics.add("ssa.folded");
+						changed = true;
+					} else if (evaluateCondition(opCode, argument(instruction, 0), argument(instruction, 1), boolResult)) {
+						function.removeEdge(block, boolResult ? successors[1] : successors[0]);
+						instruction = { "BR", "", -1, {} };
+						mStatistics.add("ssa.folded");
+						changed = true;
+					}
+				} else if (opCode == "NOT") {
+					if (boolValue(argument(instruction, 0), boolResult)) {
+						instruction = { boolResult ? "LDFALSE" : "LDTRUE", "", instruction.result, {} };
+						mStatistics.add("ssa.folded");
+						changed = true;
+					}
+				} else if (opCode.find("CMP") == 0) {
+					if (evaluateCondition(opCode, argument(instruction, 0), argument(instruction, 1), boolResult)) {
+						instruction = { boolResult ? "LDTRUE" : "LDFALSE", "", instruction.result, {} };
+						mStatistics.add("ssa.folded");
+						changed = true;
+					}
+				} else if (opCode == "ADD" || opCode == "SUB" || opCode == "MUL" || opCode == "DIV") {
+					if (evaluateOperation(opCode, argument(instruction, 0), argument(instruction, 1), intResult)) {
+						instruction = { "LDINT", std::to_string(intResult), instruction.result, {} };
+						mStatistics.add("ssa.folded");
+						changed = true;
+					}
+				}
+			}
+
+			if (changed) {
+				break;
+			}
+		}
+
+		//Remove the blocks that are no longer reachable
+		auto reachable = function.reachableBlocks();
+
+		for (int block = 0; block < (int)blocks.size(); block++) {
+			if (!reachable[block] && !blocks[block].instructions.empty()) {
+				auto successors = blocks[block].successors;
+				for (int successor : successors) {
+					function.removeEdge(block, successor);
+				}
+
+				blocks[block].instructions.clear();
+			}
+		}
+
+		removeTrivialPhis(function);
+		changed = threadBranches(function) || changed;
+	}
+}
+
+void SSAOptimizer::removeDeadValues(SSAFunction& function) {
+	auto& blocks = function.blocks();
+	std::vector<SSAInstruction*> definitions(function.numRegisters(), nullptr);
+	std::vector<bool> isLive(function.numRegisters(), false);
+	std::vector<int> liveValues;
+
+	//Values with side effects, that can throw, or that are not registers are used
+	for (auto& block : blocks) {
+		for (auto& instruction : block.instructions) {
+			auto& opCode = instruction.opCode;
+
+			if (instruction.result != -1) {
+				definitions[instruction.result] = &instruction;
+			}
+
+			if (instruction.result == -1
+				|| (opCode != "PHI" && (!InstructionInfo::isPure(opCode) || InstructionInfo::canThrow(opCode)))) {
+				for (int argument : instruction.arguments) {
+					liveValues.push_back(argument);
+				}
+
+				if (instruction.result != -1) {
+					isLive[instruction.result] = true;
+				}
+			}
+		}
+	}
+
+	while (!liveValues.empty()) {
+		int value = liveValues.back();
+		liveValues.pop_back();
+
+		if (!isLive[value]) {
+			isLive[value] = true;
+
+			for (int argument : definitions[value]->arguments) {
+				liveValues.push_back(argument);
+			}
+		}
+	}
+
+	for (auto& block : blocks) {
+		auto& instructions = block.instructions;
+
+		for (int i = 0; i < (int)instructions.size(); i++) {
+			auto& instruction = instructions[i];
+
+			if (instruction.result != -1 && !isLive[instruction.result]) {
+				if (instruction.opCode != "PHI" && !SSAFunction::isConstant(instruction.opCode)) {
+					mStatistics.add("ssa.dead-values");
+				}
+
+				instructions.erase(instructions.begin() + i);
+				i--;
+			}
+		}
+	}
+}
+
+void SSAOptimizer::optimize(GeneratedFunction& function) {
+	SSAFunction ssaFunction(mInstructionInfo);
+
+	if (!ssaFunction.build(function)) {
+		return;
+	}
+
+	removeTrivialPhis(ssaFunction);
+	foldConstants(ssaFunction);
+	removeDeadValues(ssaFunction);
+	ssaFunction.generateCode(function);
+	mStatistics.add("ssa.functions");
+}
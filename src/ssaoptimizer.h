@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+
+class GeneratedFunction;
+class InstructionInfo;
+class Statistics;
+class SSAFunction;
+
+//Optimizes generated functions in SSA form. The functions are converted to SSA form, optimized,
+//and converted back to instructions, where values used once are kept on the stack instead of stored in locals.
+class SSAOptimizer {
+private:
+	const InstructionInfo& mInstructionInfo;
+	Statistics& mStatistics;
+
+	//Replaces the uses of registers by the given registers, where -1 keeps the register
+	static void replaceRegisters(SSAFunction& function, std::vector<int>& replacements);
+
+	//Removes phi instructions where all arguments are the same value, or the phi itself
+	void removeTrivialPhis(SSAFunction& function);
+
+	//Makes branches to blocks that only branch go to the target of that block. Returns true if any branch was changed.
+	bool threadBranches(SSAFunction& function);
+
+	//Folds operations on constants, including conditional branches, and removes the blocks that become unreachable
+	void foldConstants(SSAFunction& function);
+
+	//Removes values that are not used and have no side effects
+	void removeDeadValues(SSAFunction& function);
+public:
+	//Creates a new SSA optimizer
+	SSAOptimizer(const InstructionInfo& instructionInfo, Statistics& statistics);
+
+	//Optimizes the given function
+	void optimize(GeneratedFunction& function);
+};
@@ -1,6 +1,16 @@
 #include "compiler.h"
 #include "parser.h"
+#include "helpers.h"
 #include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+
+//The minimum stack size used when compiling
+const std::size_t minStackSize = 8 * 1024 * 1024;
+
+//The stack size reserved per token. The AST, and thereby the recursion in the compiler, can be as deep as the number of tokens.
+const std::size_t stackSizePerToken = 4 * 1024;
 
 int main(int argc, char* argv[]) {
 	auto compiler = Compiler::create();
@@ -14,13 +24,33 @@ int main(int argc, char* argv[]) {
 	}
 
 	std::vector<std::string> libraries;
+	bool printStatistics = false;
+	bool printTimes = false;
 
 	if (argc > 2) {
 		for (int i = 2; i < argc; ++i) {
-			std::string library = argv[i];
+			std::string arg = argv[i];
 
-			if (library.find(".sbc") == library.length() - 4) {
-				libraries.push_back(library);
+			if (arg == "--stats") {
+				printStatistics = true;
+			} else if (arg == "--time-passes") {
+				printTimes = true;
+			} else if (arg.find("-O") == 0 && arg.length() == 3 && std::isdigit(arg[2])) {
+				compiler.passManager().setOptimizationLevel(arg[2] - '0');
+			} else if (arg.find("--disable-pass=") == 0) {
+				compiler.passManager().disablePass(arg.substr(15));
+			} else if (arg.find("--print-before=") == 0) {
+				compiler.passManager().printBefore(arg.substr(15));
+			} else if (arg.find("--print-after=") == 0) {
+				compiler.passManager().printAfter(arg.substr(14));
+			} else if (arg.find("--opt-bisect-limit=") == 0) {
+				compiler.passManager().setBisectLimit(std::stoi(arg.substr(19)));
+			} else if (arg.find("--keep=") == 0) {
+				compiler.codeGenerator().treeShaker().keep(arg.substr(7));
+			} else if (arg.find("--unroll=") == 0) {
+				compiler.codeGenerator().loopOptimizer().setUnrollFactor(std::stoi(arg.substr(9)));
+			} else if (arg.find(".sbc") == arg.length() - 4) {
+				libraries.push_back(arg);
 			}
 		}
 	}
@@ -33,12 +63,27 @@ int main(int argc, char* argv[]) {
 
 	auto tokens = compiler.lexer().tokenize(programText); 
 
-	Parser parser(compiler.operators(), tokens);
-	auto programAST = parser.parse();
+	//Run the compiler on a stack large enough for the deepest possible AST.
+	//Only the used part of the stack is committed, so the nesting depth is limited by memory.
+	auto stackSize = std::max(minStackSize, tokens.size() * stackSizePerToken);
+
+	Helpers::runWithStackSize(stackSize, [&]() {
+		Parser parser(compiler.operators(), tokens);
+		auto programAST = parser.parse();
+
+		//Loads libraries
+		compiler.load(libraries);
 
-	//Loads libraries
-	compiler.load(libraries);
+		//Process the program
+		compiler.process(programAST);
+	});
 
-	//Process the program
-	compiler.process(programAST);
+	//The generated code is written to the standard output, so the statistics are written to the error output
+	if (printStatistics) {
+		compiler.statistics().print(std::cerr);
+	}
+
+	if (printTimes) {
+		compiler.passManager().printTimes(std::cerr);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "statistics.h"
+
+Statistics::Statistics() {
+
+}
+
+void Statistics::add(std::string name, int amount) {
+	if (mCounters.count(name) == 0) {
+		mNames.push_back(name);
+		mCounters[name] = 0;
+	}
+
+	mCounters[name] += amount;
+}
+
+int Statistics::get(std::string name) const {
+	if (mCounters.count(name) > 0) {
+		return mCounters.at(name);
+	}
+
+	return 0;
+}
+
+void Statistics::print(std::ostream& os) const {
+	for (auto& name : mNames) {
+		os << name << ": " << mCounters.at(name) << std::endl;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <string>
+#include <iostream>
+
+//Collects statistics about the work done by the compiler, such as the number of applied optimizations
+class Statistics {
+private:
+	std::vector<std::string> mNames;
+	std::map<std::string, int> mCounters;
+public:
+	//Creates new statistics
+	Statistics();
+
+	//Adds the given amount to the given counter. If the counter does not exist, it is created.
+	void add(std::string name, int amount = 1);
+
+	//Returns the value of the given counter
+	int get(std::string name) const;
+
+	//Prints the counters, in the order they were created, to the given stream
+	void print(std::ostream& os) const;
+};
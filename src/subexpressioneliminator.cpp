@@ -0,0 +1,296 @@
+#include "subexpressioneliminator.h"
+#include "codegenerator.h"
+#include "instructioninfo.h"
+#include "statistics.h"
+
+#include <set>
+#include <map>
+#include <algorithm>
+
+namespace {
+	//The instructions where the order of the operands does not matter
+	const std::set<std::string> commutativeInstructions = {
+		"ADD", "MUL", "CMPEQ", "CMPNE"
+	};
+
+	//The instructions that always push the same value, which are loaded again instead of stored in a local
+	const std::set<std::string> constantLoads = {
+		"LDINT", "LDFLOAT", "LDCHAR", "LDTRUE", "LDFALSE", "LDNULL", "LDARG"
+	};
+}
+
+SubexpressionEliminator::SubexpressionEliminator(const InstructionInfo& instructionInfo, Statistics& statistics)
+	: mInstructionInfo(instructionInfo), mStatistics(statistics) {
+	mStatistics.add("cse.eliminated", 0);
+	mStatistics.add("cse.forwarded", 0);
+}
+
+bool SubexpressionEliminator::numberValues(const GeneratedFunction& function, std::vector<Value>& values) const {
+	auto& instructions = function.instructions();
+	std::map<int, int> numBranches;
+
+	for (auto& instruction : instructions) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			numBranches[std::stoi(inst.second)]++;
+		}
+	}
+
+	//A value is identified by its instruction and the numbers of its operands.
+	//Loads also depend on the stores before them, which is tracked by versions. Calls with side effects can modify any field or element.
+	//The numbers are kept in blocks with a single predecessor, which makes the blocks extended basic blocks.
+	std::map<std::string, int> numbers;
+	std::set<std::string> forwardedKeys;
+	std::map<int, std::map<std::string, int>> branchNumbers;
+	std::map<std::string, int> localVersions;
+	std::map<std::string, int> fieldVersions;
+	int elementVersion = 0;
+	int callVersion = 0;
+	int nextNumber = 0;
+
+	//The stack is empty between basic blocks
+	std::vector<Value> stack;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		auto inst = Instructions::split(instructions[i]);
+
+		if (i > 0) {
+			auto prevOpCode = Instructions::split(instructions[i - 1]).first;
+			bool isFallthrough = prevOpCode != "BR" && prevOpCode != "RET";
+			bool isBlockStart = numBranches.count(i) > 0 || Instructions::isBranch(prevOpCode) || prevOpCode == "RET";
+
+			if (isBlockStart) {
+				if (!stack.empty()) {
+					return false;
+				}
+
+				//The values computed before a block are known if the block has a single predecessor before it
+				if (isFallthrough && numBranches.count(i) > 0) {
+					numbers.clear();
+				} else if (!isFallthrough) {
+					if (branchNumbers.count(i) > 0) {
+						numbers = branchNumbers[i];
+					} else {
+						numbers.clear();
+					}
+				}
+			}
+		}
+
+		auto effect = mInstructionInfo.stackEffect(function, instructions[i]);
+
+		if ((int)stack.size() < effect.pops) {
+			return false;
+		}
+
+		std::vector<Value> operands(stack.end() - effect.pops, stack.end());
+		stack.resize(stack.size() - effect.pops);
+
+		if (Instructions::isBranch(inst.first)) {
+			int target = std::stoi(inst.second);
+			bool isTargetFallthrough = target > 0 && Instructions::split(instructions[target - 1]).first != "BR"
+									   && Instructions::split(instructions[target - 1]).first != "RET";
+
+			if (target > i && numBranches[target] == 1 && !isTargetFallthrough) {
+				branchNumbers[target] = numbers;
+			}
+		}
+
+		auto fieldKey = [&](int objectNumber) {
+			return instructions[i] + " #" + std::to_string(objectNumber)
+				   + " @" + std::to_string(fieldVersions[inst.second]) + "/" + std::to_string(callVersion);
+		};
+
+		std::string key = "";
+
+		if (InstructionInfo::isPure(inst.first)) {
+			std::vector<int> operandNumbers;
+
+			for (auto& operand : operands) {
+				operandNumbers.push_back(operand.number);
+			}
+
+			if (commutativeInstructions.count(inst.first) > 0) {
+				std::sort(operandNumbers.begin(), operandNumbers.end());
+			}
+
+			key = instructions[i];
+
+			for (int number : operandNumbers) {
+				key += " #" + std::to_string(number);
+			}
+
+			if (inst.first == "LDLOC") {
+				key += " @" + std::to_string(localVersions[inst.second]);
+			} else if (inst.first == "LDFIELD") {
+				key = fieldKey(operands[0].number);
+			} else if (inst.first == "LDELEM") {
+				key += " @" + std::to_string(elementVersion) + "/" + std::to_string(callVersion);
+			}
+		} else if (inst.first == "STLOC") {
+			//Loads of the local are the stored value
+			localVersions[inst.second]++;
+			numbers["LDLOC " + inst.second + " @" + std::to_string(localVersions[inst.second])] = operands[0].number;
+		} else if (inst.first == "STFIELD") {
+			//The object might be referenced by other values, but a load from the same value is the stored value
+			fieldVersions[inst.second]++;
+			auto loadKey = fieldKey(operands[0].number);
+			loadKey.replace(0, 2, "LD");
+			numbers[loadKey] = operands[1].number;
+			forwardedKeys.insert(loadKey);
+		} else if (inst.first == "STELEM") {
+			elementVersion++;
+		} else if (InstructionInfo::isCall(inst.first)
+				   && mInstructionInfo.effects(instructions[i]) == FunctionEffects::SideEffecting) {
+			callVersion++;
+		}
+
+		if (effect.pushes > 0) {
+			int start = operands.empty() ? i : operands.front().start;
+			Value value = { start, i, -1, effect.pops > 0, false, nullptr };
+
+			if (key != "") {
+				auto number = numbers.find(key);
+
+				if (number != numbers.end()) {
+					value.number = number->second;
+					value.isForwarded = forwardedKeys.count(key) > 0;
+				} else {
+					value.number = nextNumber++;
+					numbers[key] = value.number;
+				}
+
+				std::vector<std::shared_ptr<Type>> operandTypes;
+				for (auto& operand : operands) {
+					operandTypes.push_back(operand.type);
+				}
+
+				value.type = mInstructionInfo.resultType(function, instructions[i], operandTypes);
+			} else {
+				value.number = nextNumber++;
+			}
+
+			//The length of an allocated array is the allocated size
+			if (inst.first == "NEWARR") {
+				auto lengthKey = "LDLEN #" + std::to_string(value.number);
+				numbers[lengthKey] = operands[0].number;
+				forwardedKeys.insert(lengthKey);
+			}
+
+			stack.push_back(value);
+			values.push_back(value);
+		}
+	}
+
+	return true;
+}
+
+void SubexpressionEliminator::eliminate(GeneratedFunction& function) {
+	std::vector<Value> values;
+
+	if (!numberValues(function, values)) {
+		return;
+	}
+
+	//Values that have been computed before
+	std::map<int, Value> firstValues;
+	std::vector<Value> recomputed;
+
+	for (auto& value : values) {
+		if (firstValues.count(value.number) == 0) {
+			firstValues[value.number] = value;
+		} else if (value.isExpression && value.type != nullptr) {
+			recomputed.push_back(value);
+		}
+	}
+
+	if (recomputed.empty()) {
+		return;
+	}
+
+	//Only the largest recomputed values are eliminated, which contain the smaller ones
+	std::sort(recomputed.begin(), recomputed.end(), [](const Value& x, const Value& y) {
+		return x.start < y.start || (x.start == y.start && x.end > y.end);
+	});
+
+	auto& instructions = function.instructions();
+	std::map<int, int> valueLocals;
+	std::map<int, int> storedValues;
+	std::map<int, std::pair<int, std::string>> eliminated;
+	int numForwarded = 0;
+	int lastEnd = -1;
+
+	for (auto& value : recomputed) {
+		auto& first = firstValues[value.number];
+
+		//A forwarded value can be computed by the instructions of the load, which must then be kept
+		bool isPure = first.end < value.start;
+		for (int i = value.start; i <= value.end && isPure; i++) {
+			isPure = InstructionInfo::isPure(Instructions::split(instructions[i]).first);
+		}
+
+		if (value.start <= lastEnd || !isPure) {
+			continue;
+		}
+
+		std::string load;
+
+		if (first.start == first.end && constantLoads.count(Instructions::split(instructions[first.start]).first) > 0) {
+			load = instructions[first.start];
+		} else {
+			if (valueLocals.count(value.number) == 0) {
+				int local = function.newLocal("$tmp$_" + std::to_string(function.numLocals()), value.type);
+				valueLocals[value.number] = local;
+				storedValues[first.end] = local;
+			}
+
+			load = "LDLOC " + std::to_string(valueLocals[value.number]);
+		}
+
+		eliminated[value.start] = { value.end, load };
+		numForwarded += value.isForwarded ? 1 : 0;
+		lastEnd = value.end;
+	}
+
+	std::vector<std::string> newInstructions;
+	std::vector<int> newIndices;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		newIndices.push_back(newInstructions.size());
+
+		auto eliminatedValue = eliminated.find(i);
+		if (eliminatedValue != eliminated.end()) {
+			newInstructions.push_back(eliminatedValue->second.second);
+
+			for (; i < eliminatedValue->second.first; i++) {
+				newIndices.push_back(newIndices.back());
+			}
+
+			continue;
+		}
+
+		newInstructions.push_back(instructions[i]);
+
+		//There is no instruction for duplicating a value, so it is stored and loaded again
+		auto storedValue = storedValues.find(i);
+		if (storedValue != storedValues.end()) {
+			newInstructions.push_back("STLOC " + std::to_string(storedValue->second));
+			newInstructions.push_back("LDLOC " + std::to_string(storedValue->second));
+		}
+	}
+
+	newIndices.push_back(newInstructions.size());
+
+	for (auto& instruction : newInstructions) {
+		auto inst = Instructions::split(instruction);
+
+		if (Instructions::isBranch(inst.first)) {
+			instruction = inst.first + " " + std::to_string(newIndices[std::stoi(inst.second)]);
+		}
+	}
+
+	function.replaceInstructions(newInstructions);
+	mStatistics.add("cse.eliminated", eliminated.size() - numForwarded);
+	mStatistics.add("cse.forwarded", numForwarded);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <memory>
+
+class GeneratedFunction;
+class Type;
+class InstructionInfo;
+class Statistics;
+
+//Eliminates common subexpressions within extended basic blocks using local value numbering.
+//A value that is computed again is instead stored in a temporary local when first computed, and loaded from it.
+//Stores to fields and array allocations are forwarded to later loads of the field and the array length.
+class SubexpressionEliminator {
+private:
+	const InstructionInfo& mInstructionInfo;
+	Statistics& mStatistics;
+
+	//Represents a value pushed by the instructions in [start, end]
+	struct Value {
+		int start;
+		int end;
+		int number;
+		bool isExpression;
+		bool isForwarded;
+		std::shared_ptr<Type> type;
+	};
+
+	//Numbers the values computed in the given function, where equal values within a block have the same number.
+	//Returns false if the function could not be analyzed.
+	bool numberValues(const GeneratedFunction& function, std::vector<Value>& values) const;
+public:
+	//Creates a new subexpression eliminator
+	SubexpressionEliminator(const InstructionInfo& instructionInfo, Statistics& statistics);
+
+	//Eliminates the common subexpressions in the given function
+	void eliminate(GeneratedFunction& function);
+};
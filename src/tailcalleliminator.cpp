@@ -0,0 +1,88 @@
+#include "tailcalleliminator.h"
+#include "codegenerator.h"
+#include "localallocator.h"
+#include "statistics.h"
+
+#include <algorithm>
+
+TailCallEliminator::TailCallEliminator(Statistics& statistics)
+	: mStatistics(statistics) {
+	mStatistics.add("tailcalls.eliminated", 0);
+	mStatistics.add("tailcalls.uninitialized-locals", 0);
+}
+
+void TailCallEliminator::eliminate(GeneratedFunction& function) {
+	//Member functions are excluded, since a call on a null object must throw
+	if (function.isMemberFunction()) {
+		return;
+	}
+
+	auto selfCall = "CALL " + function.signature();
+	auto& instructions = function.instructions();
+	int numTailCalls = 0;
+
+	for (int i = 0; i + 1 < (int)instructions.size(); i++) {
+		if (instructions[i] == selfCall && instructions[i + 1] == "RET") {
+			numTailCalls++;
+		}
+	}
+
+	if (numTailCalls == 0) {
+		return;
+	}
+
+	//Locals are only zero initialized when the function is called, not when branching to the start
+	auto liveAtEntry = LocalAllocator::liveLocals(function)[0];
+	if (std::find(liveAtEntry.begin(), liveAtEntry.end(), true) != liveAtEntry.end()) {
+		mStatistics.add("tailcalls.uninitialized-locals", numTailCalls);
+		return;
+	}
+
+	//Copy the parameters to locals, which becomes the start of the loop
+	auto& parameters = function.parameters();
+	std::vector<int> parameterLocals;
+	std::vector<std::string> newInstructions;
+
+	for (int i = 0; i < (int)parameters.size(); i++) {
+		int local = function.newLocal("$param$_" + parameters[i].name, parameters[i].type);
+		parameterLocals.push_back(local);
+		newInstructions.push_back("LDARG " + std::to_string(i));
+		newInstructions.push_back("STLOC " + std::to_string(local));
+	}
+
+	int start = newInstructions.size();
+	std::vector<int> newIndices;
+	std::vector<int> branches;
+
+	for (int i = 0; i < (int)instructions.size(); i++) {
+		newIndices.push_back(newInstructions.size());
+		auto inst = Instructions::split(instructions[i]);
+
+		if (instructions[i] == selfCall && i + 1 < (int)instructions.size() && instructions[i + 1] == "RET") {
+			//The arguments are on the stack, with the last one on top
+			for (int param = parameters.size() - 1; param >= 0; param--) {
+				newInstructions.push_back("STLOC " + std::to_string(parameterLocals[param]));
+			}
+
+			newInstructions.push_back("BR " + std::to_string(start));
+		} else if (inst.first == "LDARG") {
+			newInstructions.push_back("LDLOC " + std::to_string(parameterLocals[std::stoi(inst.second)]));
+		} else {
+			if (Instructions::isBranch(inst.first)) {
+				branches.push_back(newInstructions.size());
+			}
+
+			newInstructions.push_back(instructions[i]);
+		}
+	}
+
+	newIndices.push_back(newInstructions.size());
+
+	for (auto branch : branches) {
+		auto inst = Instructions::split(newInstructions[branch]);
+		newInstructions[branch] = inst.first + " " + std::to_string(newIndices[std::stoi(inst.second)]);
+	}
+
+	function.replaceInstructions(newInstructions);
+	mStatistics.add("tailcalls.eliminated", numTailCalls);
+}
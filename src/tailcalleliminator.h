@@ -0,0 +1,17 @@
+#pragma once
+
+class GeneratedFunction;
+class Statistics;
+
+//Replaces calls to the function itself that are directly returned with a branch to the start of the function.
+//As there is no instruction for storing arguments, the parameters are copied to locals that are assigned instead.
+class TailCallEliminator {
+private:
+	Statistics& mStatistics;
+public:
+	//Creates a new tail call eliminator
+	TailCallEliminator(Statistics& statistics);
+
+	//Eliminates the tail calls in the given function
+	void eliminate(GeneratedFunction& function);
+};
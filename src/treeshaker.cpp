@@ -0,0 +1,165 @@
+#include "treeshaker.h"
+#include "codegenerator.h"
+#include "statistics.h"
+#include "type.h"
+
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+	//Returns the names of the classes referred to by the given VM type or signature, such as 'Ref.Array[Ref.Point]'
+	std::vector<std::string> referencedClasses(const std::string& str) {
+		std::vector<std::string> classes;
+		std::size_t start = 0;
+
+		while ((start = str.find("Ref.", start)) != std::string::npos) {
+			start += 4;
+			auto end = str.find_first_of(" []()", start);
+			classes.push_back(str.substr(start, end == std::string::npos ? std::string::npos : end - start));
+		}
+
+		return classes;
+	}
+}
+
+TreeShaker::TreeShaker(Statistics& statistics)
+	: mStatistics(statistics) {
+	mStatistics.add("shake.functions", 0);
+	mStatistics.add("shake.classes", 0);
+}
+
+bool TreeShaker::isEntryPoint(const GeneratedFunction& function) const {
+	return function.signature() == "main()"
+		   || function.hasAttribute("Export")
+		   || mKeptFunctions.count(function.name()) > 0
+		   || mKeptFunctions.count(function.signature()) > 0;
+}
+
+void TreeShaker::keep(std::string function) {
+	mKeptFunctions.insert(function);
+}
+
+void TreeShaker::shake(std::vector<GeneratedFunction>& functions, std::vector<GeneratedClass>& classes) {
+	for (auto& kept : mKeptFunctions) {
+		bool isDefined = std::any_of(functions.begin(), functions.end(), [&](const GeneratedFunction& function) {
+			return function.name() == kept || function.signature() == kept;
+		});
+
+		if (!isDefined) {
+			throw std::runtime_error("The kept function '" + kept + "' is not defined.");
+		}
+	}
+
+	//Without a main function, the program is a library where any function can be called
+	bool hasMain = std::any_of(functions.begin(), functions.end(), [&](const GeneratedFunction& function) {
+		return function.signature() == "main()";
+	});
+
+	if (!hasMain) {
+		return;
+	}
+
+	std::map<std::string, const GeneratedFunction*> functionsBySignature;
+	std::map<std::string, const GeneratedClass*> classesByName;
+
+	for (auto& function : functions) {
+		functionsBySignature[function.signature()] = &function;
+	}
+
+	for (auto& classDef : classes) {
+		classesByName[classDef.name()] = &classDef;
+	}
+
+	std::set<std::string> reachedFunctions;
+	std::set<std::string> reachedClasses;
+	std::vector<const GeneratedFunction*> functionWorklist;
+	std::vector<const GeneratedClass*> classWorklist;
+
+	auto reachFunction = [&](const std::string& signature) {
+		auto function = functionsBySignature.find(signature);
+
+		if (function != functionsBySignature.end() && reachedFunctions.insert(signature).second) {
+			functionWorklist.push_back(function->second);
+		}
+	};
+
+	auto reachClass = [&](const std::string& name) {
+		auto classDef = classesByName.find(name);
+
+		if (classDef != classesByName.end() && reachedClasses.insert(name).second) {
+			classWorklist.push_back(classDef->second);
+		}
+	};
+
+	auto reachType = [&](const std::string& type) {
+		for (auto& name : referencedClasses(type)) {
+			reachClass(name);
+		}
+	};
+
+	for (auto& function : functions) {
+		if (isEntryPoint(function)) {
+			reachFunction(function.signature());
+		}
+	}
+
+	while (!functionWorklist.empty() || !classWorklist.empty()) {
+		if (!functionWorklist.empty()) {
+			auto function = functionWorklist.back();
+			functionWorklist.pop_back();
+
+			for (auto& parameter : function->parameters()) {
+				reachType(parameter.type->vmType());
+			}
+
+			reachType(function->returnType()->vmType());
+
+			for (auto& local : function->locals()) {
+				reachType(local.second.second->vmType());
+			}
+
+			for (auto& instruction : function->instructions()) {
+				auto inst = Instructions::split(instruction);
+				auto& opCode = inst.first;
+
+				if (opCode == "CALL" || opCode == "CALLINST" || opCode == "NEWOBJ") {
+					reachFunction(inst.second);
+					reachType(inst.second);
+				}
+
+				//Members are referred to as 'Class::member'
+				if (opCode == "CALLINST" || opCode == "NEWOBJ" || opCode == "LDFIELD" || opCode == "STFIELD") {
+					reachClass(inst.second.substr(0, inst.second.find("::")));
+				} else if (opCode == "NEWARR" || opCode == "LDELEM" || opCode == "STELEM") {
+					reachType(inst.second);
+				}
+			}
+		} else {
+			auto classDef = classWorklist.back();
+			classWorklist.pop_back();
+
+			for (auto& field : classDef->objectLayout().fields()) {
+				reachType(field.second.type()->vmType());
+			}
+		}
+	}
+
+	int numFunctions = functions.size();
+	int numClasses = classes.size();
+
+	functions.erase(
+		std::remove_if(functions.begin(), functions.end(), [&](const GeneratedFunction& function) {
+			return reachedFunctions.count(function.signature()) == 0;
+		}),
+		functions.end());
+
+	classes.erase(
+		std::remove_if(classes.begin(), classes.end(), [&](const GeneratedClass& classDef) {
+			return reachedClasses.count(classDef.name()) == 0;
+		}),
+		classes.end());
+
+	mStatistics.add("shake.functions", numFunctions - functions.size());
+	mStatistics.add("shake.classes", numClasses - classes.size());
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <set>
+
+class GeneratedFunction;
+class GeneratedClass;
+class Statistics;
+
+//Removes the functions and classes that cannot be reached from the entry points of the program.
+//The entry points are the main function, functions with the 'Export' attribute and the kept functions.
+//Functions are reached through calls and classes through the types and members used by the reached code.
+//Programs without a main function are libraries, which are not shaken.
+class TreeShaker {
+private:
+	Statistics& mStatistics;
+	std::set<std::string> mKeptFunctions;
+public:
+	//Creates a new tree shaker
+	TreeShaker(Statistics& statistics);
+
+	//Indicates if the given function is an entry point, which can be called from outside the program
+	bool isEntryPoint(const GeneratedFunction& function) const;
+
+	//Keeps the function with the given name or signature, such as functions called by the host
+	void keep(std::string function);
+
+	//Removes the unreachable functions and classes. Throws if a kept function is not defined.
+	void shake(std::vector<GeneratedFunction>& functions, std::vector<GeneratedClass>& classes);
+};
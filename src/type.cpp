@@ -76,6 +76,53 @@ std::string ArrayType::vmType() const {
 	return "Ref.Array[" + elementType()->vmType() + "]";
 }
 
+//Rectangular array type
+RectangularArrayType::RectangularArrayType(std::shared_ptr<Type> elementType, int rank)
+	: ReferenceType(elementType->name() + "[" + std::string(rank - 1, ',') + "]"), mElementType(elementType), mRank(rank) {
+
+}
+
+const std::string RectangularArrayType::elementsField = "elements";
+
+std::shared_ptr<Type> RectangularArrayType::elementType() const {
+	return mElementType;
+}
+
+int RectangularArrayType::rank() const {
+	return mRank;
+}
+
+std::shared_ptr<Type> RectangularArrayType::elementsType() const {
+	return std::make_shared<ArrayType>(mElementType);
+}
+
+std::string RectangularArrayType::lengthField(int dim) const {
+	return "length" + std::to_string(dim);
+}
+
+std::string RectangularArrayType::vmType() const {
+	return "Ref." + vmClassName();
+}
+
+std::string RectangularArrayType::vmClassName() const {
+	//The brackets of array element types are not valid in class names
+	std::string elementName = "";
+
+	for (char c : Helpers::replaceString(mElementType->name(), "::", ".")) {
+		if (c == '[' || c == ',') {
+			elementName += '$';
+		} else if (c != ']') {
+			elementName += c;
+		}
+	}
+
+	return "Array" + std::to_string(mRank) + "D$" + elementName;
+}
+
+std::string RectangularArrayType::sizeFunctionName() const {
+	return "Array" + std::to_string(mRank) + "D$size";
+}
+
 //Class type
 ClassType::ClassType(std::string name)
 	: ReferenceType(name) {
@@ -157,6 +204,21 @@ std::shared_ptr<Type> TypeSystem::makeType(std::string typeName, const Types& de
 		}
 
 		return std::make_shared<ArrayType>(elementType);
+	} else if (typeName.at(typeName.length() - 1) == ']' && typeName.at(typeName.length() - 2) == ',') {
+		auto rankStart = typeName.rfind('[');
+
+		if (rankStart == std::string::npos
+			|| typeName.find_first_not_of(',', rankStart + 1) != typeName.length() - 1) {
+			return nullptr;
+		}
+
+		auto elementType = makeType(typeName.substr(0, rankStart), definedTypes);
+
+		if (elementType == nullptr) {
+			return nullptr;
+		}
+
+		return std::make_shared<RectangularArrayType>(elementType, typeName.length() - rankStart - 1);
 	} else if (typeName == "NullRef") {
 		return std::make_shared<NullReferenceType>();
 	} else {
@@ -196,7 +258,7 @@ std::string TypeSystem::fromVMType(std::string vmType) {
 
 	typeParts.push_back(token);
 
-	std::string arrayPattern = "Array.(.*).";
+	std::string arrayPattern = "Array[[](.*)[]]";
 	std::regex arrayRegex(arrayPattern, std::regex_constants::extended);
 	PrimitiveTypes primType;
 
@@ -208,7 +270,6 @@ std::string TypeSystem::fromVMType(std::string vmType) {
 
 		if (foundArray) {
 			std::string elementType = match[1].str();
-			elementType = elementType.substr(1, elementType.length() - 2);
 			return fromVMType(elementType) + "[]";
 		} else if (typeParts.at(1) == "Null") {
 			return NullReferenceType().name();
@@ -82,6 +82,41 @@ public:
 	virtual std::string vmType() const override;
 };
 
+//Represents a rectangular array type, such as 'Float[,]'. The array is stored as an object of a generated class,
+//which contains the elements in a flat array in row-major order and the length of each dimension.
+class RectangularArrayType : public ReferenceType {
+private:
+	std::shared_ptr<Type> mElementType;
+	int mRank;
+public:
+	//Creates a new rectangular array with the given element type and number of dimensions
+	RectangularArrayType(std::shared_ptr<Type> elementType, int rank);
+
+	//The name of the field containing the elements
+	static const std::string elementsField;
+
+	//Returns the element type
+	std::shared_ptr<Type> elementType() const;
+
+	//Returns the number of dimensions
+	int rank() const;
+
+	//Returns the type of the flat array containing the elements
+	std::shared_ptr<Type> elementsType() const;
+
+	//Returns the name of the field containing the length of the given dimension
+	std::string lengthField(int dim) const;
+
+	virtual std::string vmType() const override;
+
+	//Returns the name of the generated class in the VM
+	std::string vmClassName() const;
+
+	//Returns the name of the generated function that computes the number of elements from the lengths.
+	//The function fails for negative lengths and if the number of elements overflows.
+	std::string sizeFunctionName() const;
+};
+
 //Represents a class type
 class ClassType : public ReferenceType {
 public:
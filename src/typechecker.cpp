@@ -74,6 +74,10 @@ bool TypeChecker::addType(std::shared_ptr<Type> type) {
 	}
 }
 
+const std::unordered_map<std::string, std::shared_ptr<Type>>& TypeChecker::types() const {
+	return mTypes;
+}
+
 bool TypeChecker::typeExists(std::string name) const {
 	return mTypes.count(name) > 0;
 }
@@ -66,6 +66,9 @@ public:
 	//Adds the given type
 	bool addType(std::shared_ptr<Type> type);
 
+	//Returns the defined types
+	const std::unordered_map<std::string, std::shared_ptr<Type>>& types() const;
+
 	//Indicates if the given type exists
 	bool typeExists(std::string name) const;
 
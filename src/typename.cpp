@@ -14,8 +14,12 @@ TypeName::TypeName(std::string name, std::unique_ptr<TypeName> elementTypeName)
 }
 
 std::unique_ptr<TypeName> TypeName::make(std::string name) {
-	if (name.at(name.length() - 1) == ']' && name.at(name.length() - 2) == '[') {
-		auto elementTypeName = make(name.substr(0, name.length() - 2));
+	//Rectangular arrays have a ',' between each dimension
+	auto rankStart = name.rfind('[');
+
+	if (name.at(name.length() - 1) == ']' && rankStart != std::string::npos
+		&& name.find_first_not_of(',', rankStart + 1) == name.length() - 1) {
+		auto elementTypeName = make(name.substr(0, rankStart));
 		return std::unique_ptr<TypeName>(new TypeName(name, std::move(elementTypeName)));
 	}
 
@@ -25,7 +29,9 @@ std::unique_ptr<TypeName> TypeName::make(std::string name) {
 std::unique_ptr<TypeName> TypeName::makeFull(const TypeName* const typeName, std::shared_ptr<SymbolTable> symbolTable) {
 	if (typeName->isArray()) {
 		auto elementTypeName = makeFull(typeName->elementTypeName(), symbolTable);
-		return std::unique_ptr<TypeName>(new TypeName(elementTypeName->name() + "[]", std::move(elementTypeName)));
+		auto rank = typeName->name().substr(typeName->elementTypeName()->name().length());
+		auto fullTypeName = elementTypeName->name() + rank;
+		return std::unique_ptr<TypeName>(new TypeName(fullTypeName, std::move(elementTypeName)));
 	} else {
 		std::string fullTypeName;
 
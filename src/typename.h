@@ -26,7 +26,7 @@ public:
 	//Returns the name of the type
 	std::string name() const;
 
-	//Indicates if the current type name is an array
+	//Indicates if the current type name is an array, which includes rectangular arrays
 	bool isArray() const;
 
 	//Returns the name of the element type. Nullptr if not an array.
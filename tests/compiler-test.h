@@ -4,6 +4,7 @@
 #include <initializer_list>
 #include <algorithm> 
 #include <functional> 
+#include <fstream>
 #include <cxxtest/TestSuite.h>
 
 //Executes the given command
@@ -59,6 +60,86 @@ std::string compile(std::string programName, std::initializer_list<std::string>
     return executeCmd(invokePath.data());
 }
 
+//Compiles the given program with the given options and returns the generated code, or the errors
+std::string compileWithOptions(std::string programName, std::string options) {
+    std::string invokePath =
+        "./stackc programs/" + programName + ".sl " + options
+        + " 2>&1";
+
+    return executeCmd(invokePath.data());
+}
+
+//Compiles the given program and returns the exit status of the compiler
+std::string compileExitStatus(std::string programName) {
+    std::string invokePath =
+        "./stackc programs/" + programName + ".sl"
+        + " >/dev/null 2>&1; echo $?";
+
+    return executeCmd(invokePath.data());
+}
+
+std::string compileStatistics(std::string programName, std::string options = "") {
+    std::string invokePath =
+        "./stackc programs/" + programName + ".sl --stats " + options
+        + " 2>&1 >/dev/null";
+
+    return executeCmd(invokePath.data());
+}
+
+//Removes the targets of the branches in the given generated code, so that it can be matched without depending on the
+//number of instructions before the targets
+std::string stripBranchTargets(std::string code) {
+    std::string result = "";
+    std::size_t lineStart = 0;
+
+    while (lineStart < code.length()) {
+        auto lineEnd = code.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? code.length() : lineEnd + 1;
+        auto line = code.substr(lineStart, lineEnd - lineStart);
+        auto opCodeStart = line.find_first_not_of(' ');
+        auto targetStart = line.find(' ', opCodeStart);
+
+        std::string opCode = targetStart == std::string::npos ? "" : line.substr(opCodeStart, targetStart - opCodeStart);
+
+        if (opCode == "BR" || opCode == "BEQ" || opCode == "BNE" || opCode == "BGT" || opCode == "BGE" || opCode == "BLT" || opCode == "BLE") {
+            line = line.substr(0, targetStart) + (line.back() == '\n' ? "\n" : "");
+        }
+
+        result += line;
+        lineStart = lineEnd;
+    }
+
+    return result;
+}
+
+//Reads the given file
+std::string readFile(std::string fileName) {
+    std::ifstream file(fileName);
+    std::string content;
+    std::getline(file, content, '\0');
+    return content;
+}
+
+//Repeats the given string the given number of times
+std::string repeatString(std::string str, int count) {
+    std::string result = "";
+    result.reserve(str.length() * count);
+
+    for (int i = 0; i < count; i++) {
+        result += str;
+    }
+
+    return result;
+}
+
+//Writes the given program text to the generated programs folder, and returns the name of the program
+std::string generateProgram(std::string programName, std::string programText) {
+    executeCmd("mkdir -p programs/generated");
+    std::ofstream programFile("programs/generated/" + programName + ".sl");
+    programFile << programText;
+    return "generated/" + programName;
+}
+
 static inline std::string &ltrim(std::string &s) {
         s.erase(s.begin(), std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun<int, int>(std::isspace))));
         return s;
@@ -112,6 +193,40 @@ public:
         TS_ASSERT_EQUALS(compileAndRun("basic/and1"), "4\n0\n");
     }
 
+    void testDeepNesting() {
+        const int depth = 100000;
+
+        TS_ASSERT_EQUALS(compileAndRun(generateProgram(
+            "parenthesis",
+            "func main(): Int {\n\treturn " + repeatString("(", depth) + "0" + repeatString(" + 1)", depth) + ";\n}\n")),
+            "100000\n");
+
+        TS_ASSERT_EQUALS(compileAndRun(generateProgram(
+            "binaryop",
+            "func main(): Int {\n\tInt x = 0" + repeatString(" + 1", depth) + ";\n\treturn x;\n}\n")),
+            "100000\n");
+
+        TS_ASSERT_EQUALS(compileAndRun(generateProgram(
+            "unaryop",
+            "func main(): Int {\n\tBool x = " + repeatString("!", depth) + "true;\n\tif (x) {\n\t\treturn 1;\n\t}\n\treturn 0;\n}\n")),
+            "1\n");
+
+        TS_ASSERT_EQUALS(compileAndRun(generateProgram(
+            "blocks",
+            "func main(): Int {\n" + repeatString("{", depth) + "Int x = 5; return x;" + repeatString("}", depth) + "\n}\n")),
+            "5\n");
+
+        TS_ASSERT_EQUALS(compileAndRun(generateProgram(
+            "ifelse",
+            "func main(): Int {\n" + repeatString("if (true) {", depth) + "return 7;" + repeatString("}", depth) + "\n\treturn 0;\n}\n")),
+            "7\n");
+
+        //The compiler must also exit normally after the output is written, when the AST is destroyed
+        for (auto program : { "parenthesis", "binaryop", "unaryop", "blocks", "ifelse" }) {
+            TS_ASSERT_EQUALS(compileExitStatus("generated/" + std::string(program)), "0\n");
+        }
+    }
+
     void testFunctions() {
         TS_ASSERT_EQUALS(compileAndRun("functions/rec1"), "120\n");
         TS_ASSERT_EQUALS(compileAndRun("functions/rec2"), "21\n");
@@ -122,6 +237,16 @@ public:
         TS_ASSERT_EQUALS(compileAndRun("arrays/simple2"), "4\n");
         TS_ASSERT_EQUALS(compileAndRun("arrays/simple3"), "4\n0\n");
         TS_ASSERT_EQUALS(compileAndRun("arrays/multidim1"), "5\n5\n1337\n");
+        TS_ASSERT_EQUALS(compileAndRun("arrays/multidim2"), "3\n2\n3\n4\n2.5\n9\n0\n");
+        TS_ASSERT_EQUALS(compileAndRun("arrays/rectangular1"), "3\n4\n4.5\n33\n21\n4\n1.5\n0\n");
+        TS_ASSERT_EQUALS(compileAndRun("arrays/rectangular2"), "6\nError: negative array length\n");
+        TS_ASSERT_EQUALS(compileAndRun("arrays/rectangular3"), "65536\nError: negative array length\n");
+        TS_ASSERT_EQUALS(compileAndRun("arrays/rectangular4"), "4\nError: array index out of bounds\n");
+
+        //The bounds checks and the index are generated at each access instead of calling a function
+        auto rectangularCode = compile("arrays/rectangular4");
+        TS_ASSERT_EQUALS(rectangularCode.find("CALL Array2D$index"), std::string::npos);
+        TS_ASSERT_DIFFERS(rectangularCode.find("LDFIELD Array2D$Int::length1"), std::string::npos);
     }
 
     void testStrings() {
@@ -141,6 +266,272 @@ public:
         TS_ASSERT_EQUALS(compileAndRun("namespaces/usingclass5"), "0\n");
     }
 
+    void testConstantFolding() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/fold1"), "14\n1\n-3\n5.5\n7\n1.5\n1\n0\n0\n");
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/fold2"), "-2147483648\n-2147483648\n0\n2147483647\n0.3\n1.67772e+07\n0\n");
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/branches1"), "1\n");
+
+        auto foldedCode = compile("optimizations/fold1");
+        TS_ASSERT_EQUALS(foldedCode.find("MUL"), std::string::npos);
+        TS_ASSERT_EQUALS(foldedCode.find("CONV"), std::string::npos);
+        TS_ASSERT_EQUALS(foldedCode.find("CMP"), std::string::npos);
+
+        auto branchesCode = compile("optimizations/branches1");
+        TS_ASSERT_EQUALS(branchesCode.find("1000"), std::string::npos);
+        TS_ASSERT_EQUALS(branchesCode.find("LDINT 10\n"), std::string::npos);
+    }
+
+    void testSimplification() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/simplify1"), "3\n4\n0\n1\n3\n4\n0\n1\n0\n3\n1\n0\n");
+    }
+
+    void testPeephole() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/peephole1"), "7\n1\n1\n0\n0\n-1\n0\n0\n");
+        auto peepholeStats = compileStatistics("optimizations/peephole1");
+        TS_ASSERT_DIFFERS(peepholeStats.find("peephole.negate-add: 1\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(peepholeStats.find("peephole.negate-sub: 1\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(peepholeStats.find("peephole.compare-branch: "), std::string::npos);
+        TS_ASSERT_DIFFERS(peepholeStats.find("peephole.load-pop: 1\n"), std::string::npos);
+        TS_ASSERT_EQUALS(peepholeStats.find("peephole.branch-chain: 0\n"), std::string::npos);
+    }
+
+    void testConditions() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/conditions1"), "1\n0\n1\n0\n5\n2\n1\n0\n1\n0\n");
+        TS_ASSERT_DIFFERS(
+            compileWithOptions("optimizations/conditions1", "--disable-pass=specialize").find("func check(Int Int Bool) Void\n{\n   LDARG 0"),
+            std::string::npos);
+    }
+
+    void testLocalAllocation() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/locals1"), "12.5\n50\n1\n4.66667\n1\n4.66667\n1\n0\n");
+        TS_ASSERT_DIFFERS(compile("optimizations/locals1").find("func sum(Int) Int\n{\n   .locals 6\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(compileStatistics("optimizations/locals1").find("locals.allocated: 8\n"), std::string::npos);
+    }
+
+    void testReturns() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/returns1"), "55\n-1\n1\n0\n2\n-1\n0\n");
+        TS_ASSERT_DIFFERS(compileWithOptions("optimizations/returns1", "--disable-pass=evaluate --disable-pass=specialize").find("func sign(Int) Int\n{\n   @Pure()\n   LDARG 0"), std::string::npos);
+    }
+
+    void testInlining() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/inline1"), "10\n25\n169\n27\n110\n120\n0\n");
+        auto inlinedCode = compileWithOptions("optimizations/inline1", "--disable-pass=specialize");
+        TS_ASSERT_EQUALS(inlinedCode.find("CALL square(Int)"), std::string::npos);
+        TS_ASSERT_EQUALS(inlinedCode.find("CALL polynomial(Int)"), std::string::npos);
+        TS_ASSERT_DIFFERS(inlinedCode.find("CALL cube(Int)"), std::string::npos);
+        auto inlineStats = compileStatistics("optimizations/inline1", "--disable-pass=evaluate");
+        TS_ASSERT_DIFFERS(inlineStats.find("inline.inlined: 7\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(inlineStats.find("inline.no-inline: 1\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(inlineStats.find("inline.recursive: 1\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(inlineStats.find("inline.access: 2\n"), std::string::npos);
+        TS_ASSERT_EQUALS(
+            stripErrorMessage(compile("optimizations/inline2")),
+            "what():  A function cannot have both the 'Inline' and 'NoInline' attributes.");
+    }
+
+    void testTailCalls() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/tailcalls1"), "50005000\n6\n1\n3\n2\n1\n0\n");
+        TS_ASSERT_EQUALS(compile("optimizations/tailcalls1").find("CALL sum(Int Int)\n   RET"), std::string::npos);
+        TS_ASSERT_DIFFERS(compileStatistics("optimizations/tailcalls1").find("tailcalls.eliminated: 4\n"), std::string::npos);
+    }
+
+    void testLoopInvariants() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/licm1"), "16\n16\n7\n0\n30\n0\n");
+        TS_ASSERT_DIFFERS(
+            stripBranchTargets(compileWithOptions("optimizations/licm1", "--disable-pass=specialize")).find("BGE\n   LDARG 1\n   LDARG 2\n   MUL\n   STLOC 2\n"),
+            std::string::npos);
+        TS_ASSERT_DIFFERS(compileStatistics("optimizations/licm1", "--disable-pass=evaluate --disable-pass=specialize").find("loops.hoisted: 10\n"), std::string::npos);
+    }
+
+    void testLoopRotation() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/rotation1"), "10\n0\n0\n2\n4\n0\n0\n");
+        TS_ASSERT_EQUALS(compile("optimizations/rotation1").find("   BR "), std::string::npos);
+    }
+
+    void testLoopUnrolling() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/unroll1"), "32\n0\n0\n10\n28\n0\n2550\n3\n0\n");
+        TS_ASSERT_DIFFERS(
+            compile("optimizations/unroll1").find("LDARG 0\n   LDINT 2\n   LDELEM Float\n   LDARG 1\n   LDINT 2\n   LDELEM Float\n"),
+            std::string::npos);
+        auto unrollStats = compileStatistics("optimizations/unroll1", "--disable-pass=evaluate");
+        TS_ASSERT_DIFFERS(unrollStats.find("loops.unrolled: 3\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(unrollStats.find("loops.fully-unrolled: 1\n"), std::string::npos);
+    }
+
+    void testSubexpressions() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/cse1"), "25\n33\n71404\n10\n0.75\n0\n");
+        TS_ASSERT_DIFFERS(
+            compileWithOptions("optimizations/cse1", "--keep=lengthSquared").find("LDFIELD Point::y\n   STLOC 1\n   LDLOC 0\n   LDLOC 0\n   MUL\n"),
+            std::string::npos);
+        TS_ASSERT_DIFFERS(
+            compileStatistics("optimizations/cse1", "--keep=lengthSquared --disable-pass=evaluate").find("cse.eliminated: 6\n"),
+            std::string::npos);
+    }
+
+    void testLoadForwarding() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/loads1"), "3\n15\n2\n1\n30\n12\n0\n");
+        auto loadsCode = compileWithOptions("optimizations/loads1", "--keep=aliased --disable-pass=scalars");
+        TS_ASSERT_DIFFERS(loadsCode.find("STFIELD Box::value\n   LDINT 30\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(loadsCode.find("STFIELD Box::value\n   LDARG 0\n   LDFIELD Box::value\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(compileStatistics("optimizations/loads1", "--disable-pass=evaluate --disable-pass=scalars").find("cse.forwarded: 3\n"), std::string::npos);
+    }
+
+    void testPromotion() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/promotion1"), "15\n5\n3\n6\n12\n13\n14\n0\n");
+        TS_ASSERT_DIFFERS(
+            stripBranchTargets(compile("optimizations/promotion1")).find("BLT\n   LDARG 0\n   LDLOC 1\n   STFIELD Accumulator::count\n"),
+            std::string::npos);
+        TS_ASSERT_DIFFERS(compileStatistics("optimizations/promotion1").find("loops.promoted: 3\n"), std::string::npos);
+    }
+
+    void testStrengthReduction() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/strength1"), "0\n23\n33\n9\n5\n0\n");
+        TS_ASSERT_DIFFERS(compileStatistics("optimizations/strength1").find("loops.strength-reduced: 12\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(compileStatistics("optimizations/strength1", "--disable-pass=evaluate").find("loops.dead-variables: 1\n"), std::string::npos);
+    }
+
+    void testSSA() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/ssa1"), "28\n6\n6\n24\n0\n");
+        TS_ASSERT_DIFFERS(compileWithOptions("optimizations/ssa1", "--disable-pass=evaluate --disable-pass=specialize").find("func select(Bool) Int\n{\n   @Pure()\n   LDINT 6\n   RET\n}"), std::string::npos);
+        auto ssaStats = compileStatistics("optimizations/ssa1", "--disable-pass=evaluate --disable-pass=specialize");
+        TS_ASSERT_DIFFERS(ssaStats.find("ssa.folded: 6\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(ssaStats.find("ssa.functions: 4\n"), std::string::npos);
+
+        //The temporaries created by the SSA form must not reuse the names of compacted locals
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/ssa2"), "51\n112\n51\n112\n51\n112\n76\n3\n51\n110\n0\n");
+
+        //A null is loaded from a local, so the VM accepts the program and fails when the null is used
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/ssa3"), "1\n2\nError: null reference\n");
+    }
+
+    void testOptimizationLevels() {
+        TS_ASSERT_DIFFERS(
+            compileWithOptions("optimizations/ssa1", "-O1").find("LDARG 0\n   LDINT 4\n   MUL\n   LDINT 8\n   ADD\n   RET\n"),
+            std::string::npos);
+        TS_ASSERT_EQUALS(compileWithOptions("optimizations/ssa1", "-O0"), readFile("programs/optimizations/ssa1-O0.sbc"));
+        TS_ASSERT_EQUALS(
+            stripErrorMessage(compileWithOptions("optimizations/ssa1", "-O3")),
+            "what():  Invalid optimization level: 3.");
+        TS_ASSERT_DIFFERS(
+            compileWithOptions("optimizations/ssa1", "-O1 --disable-pass=ssa").find("LDINT 4\n   STLOC 0\n"),
+            std::string::npos);
+    }
+
+    void testPassManager() {
+        TS_ASSERT_DIFFERS(
+            compileWithOptions("optimizations/ssa1", "--disable-pass=evaluate --disable-pass=specialize --print-after=locals").find("*** After locals ***\nfunc select(Bool) Int\n{\n   @Pure()\n   LDINT 6\n"),
+            std::string::npos);
+        auto bisectCode = compileWithOptions("optimizations/ssa1", "--opt-bisect-limit=1");
+        TS_ASSERT_DIFFERS(bisectCode.find("BISECT: running pass (1) fold on program\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(bisectCode.find("BISECT: NOT running pass (2) evaluate on program\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(bisectCode.find("BISECT: NOT running pass (3) simplify on scale(Int)\n"), std::string::npos);
+        TS_ASSERT_EQUALS(
+            stripErrorMessage(compileWithOptions("optimizations/ssa1", "--disable-pass=codegen")),
+            "what():  The pass 'codegen' is required and cannot be disabled.");
+        TS_ASSERT_EQUALS(
+            stripErrorMessage(compileWithOptions("optimizations/ssa1", "--print-before=unknown")),
+            "what():  The pass 'unknown' is not defined.");
+    }
+
+    void testDeadCode() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/dce1"), "3\n3\n1\n0\n2\n0\n");
+        auto dceCode = compileWithOptions("optimizations/dce1", "-O1 --disable-pass=ssa");
+        TS_ASSERT_DIFFERS(dceCode.find("func deadStores(Int) Int\n{\n   @Pure()\n   LDARG 0\n   RET\n}"), std::string::npos);
+        TS_ASSERT_DIFFERS(dceCode.find("LDARG 0\n   LDLEN\n   POP\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(dceCode.find("CALL printed(Int)\n   POP\n"), std::string::npos);
+        auto dceStats = compileStatistics("optimizations/dce1", "--disable-pass=evaluate --disable-pass=specialize");
+        TS_ASSERT_DIFFERS(dceStats.find("dce.unreachable: 9\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(dceStats.find("dce.dead-stores: 4\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(dceStats.find("dce.pure-values: 4\n"), std::string::npos);
+    }
+
+    void testTreeShaking() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/shake1"), "5\n0\n");
+        auto shakeCode = compile("optimizations/shake1");
+        TS_ASSERT_EQUALS(shakeCode.find("Unused"), std::string::npos);
+        TS_ASSERT_EQUALS(shakeCode.find("func kept(Int) Int"), std::string::npos);
+        TS_ASSERT_DIFFERS(shakeCode.find("class Part"), std::string::npos);
+        TS_ASSERT_DIFFERS(shakeCode.find("func exported(Int) Int"), std::string::npos);
+        TS_ASSERT_DIFFERS(compileWithOptions("optimizations/shake1", "--keep=kept").find("func kept(Int) Int"), std::string::npos);
+        TS_ASSERT_EQUALS(
+            stripErrorMessage(compileWithOptions("optimizations/shake1", "--keep=missing")),
+            "what():  The kept function 'missing' is not defined.");
+        auto shakeStats = compileStatistics("optimizations/shake1");
+        TS_ASSERT_DIFFERS(shakeStats.find("shake.functions: 5\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(shakeStats.find("shake.classes: 1\n"), std::string::npos);
+
+        //A library has no main function, so all of its functions and classes are kept
+        auto libraryCode = compile("optimizations/shake2");
+        TS_ASSERT_DIFFERS(libraryCode.find("class Pair"), std::string::npos);
+        TS_ASSERT_DIFFERS(libraryCode.find("func sum(Ref.Pair) Int"), std::string::npos);
+        TS_ASSERT_DIFFERS(libraryCode.find("func scaled(Int) Int"), std::string::npos);
+    }
+
+    void testSpecialization() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/specialize1"), "14\n7\n7\n7\n0\n");
+        auto specializedCode = compile("optimizations/specialize1");
+        TS_ASSERT_DIFFERS(specializedCode.find("CALL scaled$1_true(Int)"), std::string::npos);
+        TS_ASSERT_DIFFERS(specializedCode.find("func scaled$1_false(Int) Int\n{\n   @Pure()\n   LDARG 0\n   RET\n}"), std::string::npos);
+        TS_ASSERT_DIFFERS(specializedCode.find("LDARG 0\n   LDINT 10\n   BLE"), std::string::npos);
+        auto specializeStats = compileStatistics("optimizations/specialize1");
+        TS_ASSERT_DIFFERS(specializeStats.find("specialize.propagated: 1\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(specializeStats.find("specialize.clones: 2\n"), std::string::npos);
+
+        //Calls are only specialized when a branch folds, and each function has a limited number of clones
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/specialize2"), "10\n12\n10\n3\n3\n4\n6\n9\n2\n3\n4\n6\n9\n2\n0\n");
+        auto limitedCode = compileWithOptions("optimizations/specialize2", "--disable-pass=evaluate");
+        TS_ASSERT_EQUALS(limitedCode.find("func offset$"), std::string::npos);
+        TS_ASSERT_EQUALS(limitedCode.find("func depth$"), std::string::npos);
+        TS_ASSERT_DIFFERS(limitedCode.find("func select$1_3(Int) Int"), std::string::npos);
+        TS_ASSERT_EQUALS(limitedCode.find("func select$1_4(Int) Int"), std::string::npos);
+        auto limitedStats = compileStatistics("optimizations/specialize2", "--disable-pass=evaluate");
+        TS_ASSERT_DIFFERS(limitedStats.find("specialize.clones: 4\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(limitedStats.find("specialize.budget: 1\n"), std::string::npos);
+    }
+
+    void testEvaluation() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/evaluate1"), "2147483646\n832040\n21\n1.75\n1\n0\n1000000\n5\n5\n4\n0\n");
+        auto evaluatedCode = compile("optimizations/evaluate1");
+        TS_ASSERT_EQUALS(evaluatedCode.find("CALL fibonacci(Int)"), std::string::npos);
+        TS_ASSERT_EQUALS(evaluatedCode.find("CALL gcd(Int Int)"), std::string::npos);
+        TS_ASSERT_DIFFERS(evaluatedCode.find("LDINT 832040\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(evaluatedCode.find("CALL count(Int)"), std::string::npos);
+        TS_ASSERT_DIFFERS(evaluatedCode.find("CALL constant()"), std::string::npos);
+        TS_ASSERT_DIFFERS(compileWithOptions("optimizations/evaluate1", "-O1").find("CALL fibonacci(Int)"), std::string::npos);
+        auto evaluateStats = compileStatistics("optimizations/evaluate1");
+        TS_ASSERT_DIFFERS(evaluateStats.find("evaluate.calls: 6\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(evaluateStats.find("evaluate.budget: 1\n"), std::string::npos);
+    }
+
+    void testEffects() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/effects1"), "8\n25\n3\n72507\n708\n0\n");
+        auto effectsCode = compile("optimizations/effects1");
+        TS_ASSERT_DIFFERS(effectsCode.find("func twice(Int) Int\n{\n   @Pure()\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsCode.find("func norm(Ref.Point) Int\n{\n   @ReadOnly()\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsCode.find("func makeArray(Int) Ref.Array[Int]\n{\n   LDARG 0"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsCode.find("func move(Ref.Point) Int\n{\n   LDARG 0"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsCode.find("CALL norm(Ref.Point)\n   LDINT 100\n   MUL\n   ADD\n   LDLOC 0\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsCode.find("CALL move(Ref.Point)\n   ADD\n   LDARG 0\n   LDFIELD Point::x\n"), std::string::npos);
+        auto effectsStats = compileStatistics("optimizations/effects1");
+        TS_ASSERT_DIFFERS(effectsStats.find("effects.pure: 2\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsStats.find("effects.read-only: 2\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsStats.find("effects.allocating: 1\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(effectsStats.find("effects.side-effecting: 3\n"), std::string::npos);
+    }
+
+    void testScalarReplacement() {
+        TS_ASSERT_EQUALS(compileAndRun("optimizations/scalars1"), "30\n20\n5\n0\n");
+        auto scalarsCode = compile("optimizations/scalars1");
+        TS_ASSERT_EQUALS(scalarsCode.find("NEWOBJ Counter::.constructor()"), std::string::npos);
+        TS_ASSERT_EQUALS(scalarsCode.find("LDFIELD Counter::"), std::string::npos);
+        TS_ASSERT_DIFFERS(scalarsCode.find("func lengths(Int) Float\n{\n   @Pure()\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(scalarsCode.find("NEWOBJ Vec::.constructor(Float Float)\n   STLOC 0\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(compileWithOptions("optimizations/scalars1", "--disable-pass=scalars").find("NEWOBJ Counter::.constructor()"), std::string::npos);
+        auto scalarsStats = compileStatistics("optimizations/scalars1");
+        TS_ASSERT_DIFFERS(scalarsStats.find("scalars.replaced: 2\n"), std::string::npos);
+        TS_ASSERT_DIFFERS(scalarsStats.find("scalars.escaped: 1\n"), std::string::npos);
+    }
+
     void testClasses() {
         TS_ASSERT_EQUALS(compileAndRun("classes/simple1"), "6\n");
         TS_ASSERT_EQUALS(compileAndRun("classes/simple2"), "4.47214\n0\n");